@@ -110,6 +110,31 @@ minheap_t *mh_create(unsigned int capacity) {
   return minheap;
 }
 
+// Увеличивает вместимость кучи, узлы и их индексы остаются на месте
+int mh_reserve(minheap_t *minheap, unsigned int capacity) {
+  if (!minheap) return -1;
+  if (capacity <= minheap->capacity) return 0;
+
+  minheap_node_t **arr = (minheap_node_t **)realloc(minheap->arr, capacity * sizeof(minheap->arr[0]));
+  if (!arr) return -1;
+
+  for (unsigned int i = minheap->capacity; i < capacity; i++) {
+    arr[i] = NULL;
+  }
+  minheap->arr = arr;
+  minheap->capacity = capacity;
+  return 0;
+}
+
+void *mh_storage(minheap_t *minheap, size_t *bytes) {
+  if (!minheap) {
+    if (bytes) *bytes = 0;
+    return NULL;
+  }
+  if (bytes) *bytes = minheap->capacity * sizeof(minheap->arr[0]);
+  return minheap->arr;
+}
+
 // Освобождает память кучи (не освобождает узлы)
 void mh_free(minheap_t *minheap) {
   if (!minheap) return;
@@ -28,7 +28,7 @@
 
 typedef struct minheap_node {
   uint64_t key; /* Ключ для сортировки внутри кучи (например, время таймера) */
-  uint16_t idx;
+  uint32_t idx; /* позиция в куче + 1, 0 — узел не в куче */
 } minheap_node_t;
 
 // Непрозрачный тип для сокрытия реализации
@@ -37,6 +37,18 @@ typedef struct minheap_t minheap_t;
 EXPORT_API minheap_t *mh_create(unsigned int capacity);
 EXPORT_API void mh_free(minheap_t *minheap);
 
+/**
+ * Увеличивает вместимость кучи до capacity (уменьшение не поддерживается).
+ * Возвращает 0 при успехе, -1 при ошибке выделения памяти.
+ */
+EXPORT_API int mh_reserve(minheap_t *minheap, unsigned int capacity);
+
+/**
+ * Массив узлов кучи, в *bytes — его размер (вся вместимость). Нужен для привязки
+ * памяти (например, к узлу NUMA); адрес меняется после mh_reserve. NULL для NULL кучи.
+ */
+EXPORT_API void *mh_storage(minheap_t *minheap, size_t *bytes);
+
 /**
  * Вставляет node в кучу. Если node уже есть — обновляет key и перестраивает
  * кучу.
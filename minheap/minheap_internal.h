@@ -14,7 +14,7 @@ struct minheap_t {
 static inline void mh_map_set(minheap_t *minheap, minheap_node_t *node, int idx) {
   if (!node) return;
   (void)minheap; // не используется
-  node->idx = (uint16_t)idx + 1;
+  node->idx = (uint32_t)idx + 1;
 }
 
 // Получает индекс узла или -1, если узел не в куче
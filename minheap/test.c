@@ -131,6 +131,28 @@ void test_insert_overflow() {
   fail_malloc_at = 0;
 }
 
+void test_reserve() {
+  PRINT_TEST_START("Reserve grows a full heap, keeps order");
+  minheap_t *heap = mh_create(1);
+  minheap_node_t nodes[3] = {{.key = 3}, {.key = 1}, {.key = 2}};
+  assert(mh_insert(heap, &nodes[0]) == 0);
+  assert(mh_insert(heap, &nodes[1]) == -1 && "Full heap should reject insert");
+  assert(mh_reserve(heap, 3) == 0);
+  assert(mh_reserve(heap, 2) == 0 && "Shrinking request is a no-op");
+  assert(heap->capacity == 3);
+  size_t bytes = 0;
+  assert(mh_storage(heap, &bytes) == heap->arr && bytes == 3 * sizeof(heap->arr[0]));
+  assert(mh_storage(NULL, &bytes) == NULL && bytes == 0);
+  assert(mh_insert(heap, &nodes[1]) == 0);
+  assert(mh_insert(heap, &nodes[2]) == 0);
+  assert(mh_extract_min(heap)->key == 1);
+  assert(mh_extract_min(heap)->key == 2);
+  assert(mh_extract_min(heap)->key == 3);
+  assert(mh_reserve(NULL, 10) == -1);
+  mh_free(heap);
+  PRINT_TEST_PASSED();
+}
+
 void test_free_null() {
   reset_alloc_counters();
   fail_malloc_at = 0;
@@ -779,6 +801,7 @@ int main(int argc, char **argv) {
       {"insert_null_heap", test_insert_null_heap},
       {"insert_null_node", test_insert_null_node},
       {"insert_overflow", test_insert_overflow},
+      {"reserve", test_reserve},
       {"free_null", test_free_null},
       {"extract_min_null", test_extract_min_null},
       {"extract_min_empty", test_extract_min_empty},
@@ -807,6 +830,7 @@ int main(int argc, char **argv) {
   test_insert_null_heap();
   test_insert_null_node();
   test_insert_overflow();
+  test_reserve();
   test_free_null();
   test_extract_min_null();
   test_extract_min_empty();
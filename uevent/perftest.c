@@ -10,9 +10,18 @@
 
 
 #include <assert.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
 #include <time.h>
+#include <unistd.h>
 
 // Заголовки для libevent
 #include <event2/event.h>
@@ -23,6 +32,7 @@
 
 // Заголовок для вашей библиотеки
 #include "uevent.h"
+#include "uevent_co.h"
 
 // --- Утилита для замера времени ---
 long long get_time_ms() {
@@ -31,6 +41,12 @@ long long get_time_ms() {
   return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
 }
 
+long long get_time_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
 // --- Код для тестирования uevent ---
 
 static _Atomic int uevent_triggered_count = 0;
@@ -52,7 +68,8 @@ void run_uevent_test(int num_events) {
   printf("--- test uevent (events=%d) ---\n", num_events);
   uevent_triggered_count = 0;
 
-  uevent_base_t *base = uevent_base_new_with_workers(num_events, 0);
+  // +1 слот под служебный wakeup_event
+  uevent_base_t *base = uevent_base_new_with_workers(num_events + 1, 0);
   assert(base);
 
   // Замеряем только добавление и выполнение
@@ -76,6 +93,477 @@ void run_uevent_test(int num_events) {
   uevent_deinit(base);
 }
 
+// --- Сравнение бэкендов таймеров: куча vs колесо ---
+
+static const char *timer_backend_name(uev_timer_backend_t backend) {
+  return backend == UEV_TIMER_WHEEL ? "wheel" : "heap";
+}
+
+// keepalive-сценарий: таймеры взводятся, перевзводятся и отменяются, не успевая сработать
+void run_timer_backend_test(uev_timer_backend_t backend, int num_timers) {
+  setup_syslog2("uevent_test", LOG_WARNING, false);
+
+  uevent_base_args_t args = {.max_events = num_timers + 16, .num_workers = 0, .timer_backend = backend};
+  uevent_base_t *base = uevent_base_new_with_args(&args);
+  assert(base);
+
+  uev_t **uevs = malloc(sizeof(uev_t *) * num_timers);
+  assert(uevs);
+  for (int i = 0; i < num_timers; i++) {
+    uevs[i] = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, uevent_perf_cb, &uevent_triggered_count, __func__);
+    assert(uevs[i]);
+  }
+
+  srand(42);
+  long long t0 = get_time_ns();
+  for (int i = 0; i < num_timers; i++) {
+    uevent_add(uevs[i], 10000 + rand() % 50000);
+  }
+  long long t1 = get_time_ns();
+  for (int i = 0; i < num_timers; i++) {
+    uevent_add(uevs[i], 10000 + rand() % 50000);
+  }
+  long long t2 = get_time_ns();
+  for (int i = 0; i < num_timers; i++) {
+    uevent_del(uevs[i]);
+  }
+  long long t3 = get_time_ns();
+
+  printf("result %-5s timers=%-8d add=%6.1f ns/op rearm=%6.1f ns/op cancel=%6.1f ns/op\n",
+         timer_backend_name(backend), num_timers,
+         (double)(t1 - t0) / num_timers, (double)(t2 - t1) / num_timers, (double)(t3 - t2) / num_timers);
+
+  for (int i = 0; i < num_timers; i++) {
+    uevent_free(uevs[i]);
+  }
+  free(uevs);
+  uevent_deinit(base);
+}
+
+// --- Сутки keepalive-таймеров на виртуальных часах: стоимость очереди таймеров без сна ---
+
+static uint64_t vday_fired;
+static void vday_cb(uevent_t *ev, int fd, short event, void *arg) { vday_fired++; }
+static void vday_stop_cb(uevent_t *ev, int fd, short event, void *arg) { uevent_base_loopbreak(arg); }
+
+void run_virtual_day_test(uev_timer_backend_t backend, int num_timers) {
+  setup_syslog2("uevent_test", LOG_WARNING, false);
+
+  uevent_base_args_t args = {.max_events = num_timers + 16, .timer_backend = backend, .virtual_clock = true};
+  uevent_base_t *base = uevent_base_new_with_args(&args);
+  assert(base);
+
+  uev_t **uevs = malloc(sizeof(uev_t *) * num_timers);
+  assert(uevs);
+  srand(42);
+  for (int i = 0; i < num_timers; i++) {
+    uevs[i] = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT | UEV_PERSIST, vday_cb, NULL, __func__);
+    assert(uevs[i]);
+    uevent_set_timeout(uevs[i], 10000 + rand() % 50000);
+    uevent_add_with_current_timeout(uevs[i]);
+  }
+  uev_t *stop = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, vday_stop_cb, base, "vday_stop");
+  assert(stop);
+  uevent_add(stop, 24 * 3600 * 1000);
+
+  vday_fired = 0;
+  long long t0 = get_time_ns();
+  uevent_base_dispatch(base);
+  long long t1 = get_time_ns();
+
+  printf("result vday  %-5s timers=%-7d fired=%-10" PRIu64 " wall=%7.1f ms %6.1f ns/fire\n",
+         timer_backend_name(backend), num_timers, vday_fired, (double)(t1 - t0) / 1e6,
+         vday_fired ? (double)(t1 - t0) / (double)vday_fired : 0.0);
+
+  uevent_free(stop);
+  for (int i = 0; i < num_timers; i++) {
+    uevent_free(uevs[i]);
+  }
+  free(uevs);
+  uevent_deinit(base);
+}
+
+// --- Перевзвод таймеров из чужих потоков при работающем цикле ---
+
+typedef struct {
+  uev_t **uevs;
+  int num_timers;
+  long long deadline_ns;
+  long long ops;
+} rearm_thread_arg_t;
+
+static void *rearm_thread(void *arg) {
+  rearm_thread_arg_t *a = arg;
+  while (get_time_ns() < a->deadline_ns) {
+    for (int i = 0; i < a->num_timers; i++) {
+      uevent_add(a->uevs[i], 10000 + rand() % 50000);
+    }
+    a->ops += a->num_timers;
+  }
+  return NULL;
+}
+
+static void *rearm_dispatch_thread(void *arg) {
+  uevent_base_dispatch((uevent_base_t *)arg);
+  return NULL;
+}
+
+// команды таймеров из других потоков идут через очередь базы и не берут base_mut
+void run_cross_thread_rearm_test(int num_threads, int timers_per_thread) {
+  setup_syslog2("uevent_test", LOG_WARNING, false);
+
+  int total = num_threads * timers_per_thread;
+  uevent_base_t *base = uevent_base_new_with_workers(total + 16, 0);
+  assert(base);
+
+  uev_t *keeper = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT | UEV_PERSIST, uevent_perf_cb, &uevent_triggered_count, "keeper");
+  assert(keeper);
+  uevent_set_timeout(keeper, 3600 * 1000);
+  uevent_add_with_current_timeout(keeper);
+
+  uev_t **uevs = malloc(sizeof(uev_t *) * total);
+  assert(uevs);
+  for (int i = 0; i < total; i++) {
+    uevs[i] = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, uevent_perf_cb, &uevent_triggered_count, __func__);
+    assert(uevs[i]);
+  }
+
+  pthread_t dispatcher;
+  pthread_create(&dispatcher, NULL, rearm_dispatch_thread, base);
+  usleep(10000);
+
+  pthread_t *threads = malloc(sizeof(pthread_t) * num_threads);
+  rearm_thread_arg_t *args = calloc(num_threads, sizeof(rearm_thread_arg_t));
+  assert(threads && args);
+  long long t0 = get_time_ns();
+  for (int t = 0; t < num_threads; t++) {
+    args[t].uevs = uevs + t * timers_per_thread;
+    args[t].num_timers = timers_per_thread;
+    args[t].deadline_ns = t0 + 1000000000LL;
+    pthread_create(&threads[t], NULL, rearm_thread, &args[t]);
+  }
+  long long ops = 0;
+  for (int t = 0; t < num_threads; t++) {
+    pthread_join(threads[t], NULL);
+    ops += args[t].ops;
+  }
+  long long t1 = get_time_ns();
+
+  printf("result cross-thread rearm threads=%d timers=%-6d %.0f ops/s\n",
+         num_threads, total, (double)ops * 1e9 / (double)(t1 - t0));
+
+  uevent_base_loopbreak(base);
+  pthread_join(dispatcher, NULL);
+  for (int i = 0; i < total; i++) {
+    uevent_free(uevs[i]);
+  }
+  uevent_free(keeper);
+  free(uevs);
+  free(threads);
+  free(args);
+  uevent_deinit(base);
+}
+
+// --- Опоздание таймеров: миллисекундный режим против hires_timers ---
+
+#define LATENESS_SAMPLES 2000
+
+typedef struct {
+  uev_t *peer;
+  long long *deadline_ns;
+  long long *lateness_ns;
+  int *samples;
+  int delay_us;
+} lateness_arg_t;
+
+static long long get_time_mono_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// два таймера взводят друг друга из колбэка, каждый раз с задержкой delay_us
+static void lateness_cb(uevent_t *ev, int fd, short event, void *arg) {
+  (void)ev;
+  (void)fd;
+  (void)event;
+  lateness_arg_t *a = arg;
+  long long now = get_time_mono_ns();
+  a->lateness_ns[(*a->samples)++] = now - *a->deadline_ns;
+  if (*a->samples >= LATENESS_SAMPLES) return;
+  *a->deadline_ns = get_time_mono_ns() + a->delay_us * 1000LL;
+  uevent_add_us(a->peer, a->delay_us);
+}
+
+static int cmp_ll(const void *a, const void *b) {
+  long long x = *(const long long *)a, y = *(const long long *)b;
+  return (x > y) - (x < y);
+}
+
+void run_timer_lateness_test(bool hires, int delay_us) {
+  setup_syslog2("uevent_test", LOG_WARNING, false);
+
+  uevent_base_args_t args = {.max_events = 16, .num_workers = 0, .hires_timers = hires};
+  uevent_base_t *base = uevent_base_new_with_args(&args);
+  assert(base);
+
+  long long deadline_ns = 0;
+  long long *lateness_ns = calloc(LATENESS_SAMPLES, sizeof(long long));
+  int samples = 0;
+  assert(lateness_ns);
+  lateness_arg_t a = {.deadline_ns = &deadline_ns, .lateness_ns = lateness_ns, .samples = &samples, .delay_us = delay_us};
+  lateness_arg_t b = a;
+  uev_t *ua = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, lateness_cb, &a, "lateness_a");
+  uev_t *ub = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, lateness_cb, &b, "lateness_b");
+  assert(ua && ub);
+  a.peer = ub;
+  b.peer = ua;
+
+  deadline_ns = get_time_mono_ns() + delay_us * 1000LL;
+  uevent_add_us(ua, delay_us);
+  uevent_base_dispatch(base);
+  assert(samples == LATENESS_SAMPLES);
+
+  qsort(lateness_ns, LATENESS_SAMPLES, sizeof(long long), cmp_ll);
+  printf("result lateness %-5s delay=%dus p50=%lldus p90=%lldus p99=%lldus max=%lldus\n",
+         hires ? "hires" : "ms", delay_us,
+         lateness_ns[LATENESS_SAMPLES / 2] / 1000, lateness_ns[LATENESS_SAMPLES * 9 / 10] / 1000,
+         lateness_ns[LATENESS_SAMPLES * 99 / 100] / 1000, lateness_ns[LATENESS_SAMPLES - 1] / 1000);
+
+  uevent_free(ua);
+  uevent_free(ub);
+  free(lateness_ns);
+  uevent_deinit(base);
+}
+
+// --- fd ping-pong: epoll против io_uring ---
+
+typedef struct {
+  int total;         // сколько обменов уже завершено
+  int target;        // сколько обменов нужно всего
+  uevent_base_t *base;
+} pingpong_state_t;
+
+static pingpong_state_t pingpong;
+
+// эхо-сторона: вернуть все прочитанное обратно
+static void pingpong_echo_cb(uevent_t *ev, int fd, short event, void *arg) {
+  (void)ev;
+  (void)event;
+  (void)arg;
+  char buf[64];
+  ssize_t n;
+  while ((n = read(fd, buf, sizeof(buf))) > 0) {
+    if (write(fd, buf, (size_t)n) != n) abort();
+  }
+}
+
+// клиентская сторона: засчитать обмен и отправить следующий
+static void pingpong_client_cb(uevent_t *ev, int fd, short event, void *arg) {
+  (void)ev;
+  (void)event;
+  (void)arg;
+  char c;
+  while (read(fd, &c, 1) == 1) {
+    if (++pingpong.total >= pingpong.target) {
+      uevent_base_loopbreak(pingpong.base);
+      return;
+    }
+    if (write(fd, &c, 1) != 1) abort();
+  }
+}
+
+// максимум соединений, которые позволяет RLIMIT_NOFILE (по два fd на соединение)
+static int pingpong_max_conns(int want) {
+  struct rlimit rl;
+  if (getrlimit(RLIMIT_NOFILE, &rl) != 0) return want;
+  rl.rlim_cur = rl.rlim_max;
+  (void)setrlimit(RLIMIT_NOFILE, &rl);
+  int fit = (int)((rl.rlim_cur - 64) / 2);
+  return want < fit ? want : fit;
+}
+
+void run_pingpong_test(uev_io_backend_t backend, int want_conns, int rounds) {
+  setup_syslog2("uevent_test", LOG_WARNING, false);
+  int conns = pingpong_max_conns(want_conns);
+
+  uevent_base_args_t args = {.max_events = 1024, .num_workers = 0, .io_backend = backend};
+  uevent_base_t *base = uevent_base_new_with_args(&args);
+  assert(base);
+  const char *name = uevent_base_io_backend(base) == UEV_IO_URING ? "io_uring" : "epoll";
+  if (uevent_base_io_backend(base) != backend) name = "epoll(fallback)";
+
+  int (*fds)[2] = calloc((size_t)conns, sizeof(*fds));
+  uev_t **uevs = calloc((size_t)conns * 2, sizeof(uev_t *));
+  assert(fds && uevs);
+
+  pingpong.total = 0;
+  pingpong.target = conns * rounds;
+  pingpong.base = base;
+
+  for (int i = 0; i < conns; i++) {
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds[i]) != 0) {
+      perror("socketpair");
+      abort();
+    }
+    uevs[2 * i] = uevent_create_or_assign_event(NULL, base, fds[i][0], UEV_READ | UEV_PERSIST, pingpong_echo_cb, NULL, "pp_echo");
+    uevs[2 * i + 1] = uevent_create_or_assign_event(NULL, base, fds[i][1], UEV_READ | UEV_PERSIST, pingpong_client_cb, NULL, "pp_client");
+    assert(uevs[2 * i] && uevs[2 * i + 1]);
+    uevent_add(uevs[2 * i], 0);
+    uevent_add(uevs[2 * i + 1], 0);
+  }
+
+  long long start = get_time_ns();
+  for (int i = 0; i < conns; i++) {
+    if (write(fds[i][1], "p", 1) != 1) abort();
+  }
+  uevent_base_dispatch(base);
+  long long elapsed_ns = get_time_ns() - start;
+
+  printf("result pingpong %-15s conns=%d rounds=%d exchanges=%d time=%lldms rate=%.0f/s\n",
+         name, conns, rounds, pingpong.total, elapsed_ns / 1000000,
+         pingpong.total * 1e9 / (double)(elapsed_ns > 0 ? elapsed_ns : 1));
+
+  for (int i = 0; i < conns * 2; i++) uevent_free(uevs[i]);
+  uevent_deinit(base);
+  for (int i = 0; i < conns; i++) {
+    close(fds[i][0]);
+    close(fds[i][1]);
+  }
+  free(uevs);
+  free(fds);
+}
+
+// --- задержка запрос/ответ: блокирующее ожидание против busy-poll ---
+
+typedef struct {
+  int fd;
+  int rounds;
+  long long *rtt_ns;
+} rtt_client_t;
+
+// клиент в отдельном потоке: запрос, блокирующее чтение ответа, пауза между запросами
+static void *rtt_client_thread(void *arg) {
+  rtt_client_t *c = arg;
+  char ch = 'r';
+  for (int i = 0; i < c->rounds; i++) {
+    long long t0 = get_time_ns();
+    if (write(c->fd, &ch, 1) != 1 || read(c->fd, &ch, 1) != 1) abort();
+    c->rtt_ns[i] = get_time_ns() - t0;
+    // запросы идут с промежутками, как в реальном сервисе: цикл успевает уснуть
+    struct timespec pause = {.tv_sec = 0, .tv_nsec = 20000};
+    nanosleep(&pause, NULL);
+  }
+  close(c->fd);
+  return NULL;
+}
+
+static void rtt_echo_cb(uevent_t *ev, int fd, short event, void *arg) {
+  (void)event;
+  (void)arg;
+  char buf[64];
+  ssize_t n;
+  while ((n = read(fd, buf, sizeof(buf))) > 0) {
+    if (write(fd, buf, (size_t)n) != n) abort();
+  }
+  if (n == 0) uevent_del(ev->uev);
+}
+
+void run_rtt_test(int busy_poll_us, int rounds) {
+  setup_syslog2("uevent_test", LOG_WARNING, false);
+  uevent_base_args_t args = {.max_events = 16, .num_workers = 0, .busy_poll_us = busy_poll_us};
+  uevent_base_t *base = uevent_base_new_with_args(&args);
+  assert(base);
+
+  int sv[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) abort();
+  if (fcntl(sv[0], F_SETFL, O_NONBLOCK) != 0) abort();
+  uev_t *echo = uevent_create_or_assign_event(NULL, base, sv[0], UEV_READ | UEV_PERSIST, rtt_echo_cb, NULL, "rtt_echo");
+  assert(echo);
+  uevent_add(echo, 0);
+
+  rtt_client_t client = {.fd = sv[1], .rounds = rounds, .rtt_ns = calloc((size_t)rounds, sizeof(long long))};
+  assert(client.rtt_ns);
+  pthread_t th;
+  if (pthread_create(&th, NULL, rtt_client_thread, &client) != 0) abort();
+  struct timespec cpu0, cpu1;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu0);
+  uevent_base_dispatch(base);
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu1);
+  pthread_join(th, NULL);
+
+  qsort(client.rtt_ns, (size_t)rounds, sizeof(long long), cmp_ll);
+  long long cpu_ms = ((cpu1.tv_sec - cpu0.tv_sec) * 1000000000LL + (cpu1.tv_nsec - cpu0.tv_nsec)) / 1000000;
+  printf("result rtt busy_poll_us=%-4d rounds=%d p50=%.1fus p99=%.1fus loop_cpu=%lldms\n",
+         busy_poll_us, rounds, client.rtt_ns[rounds / 2] / 1000.0, client.rtt_ns[rounds * 99 / 100] / 1000.0, cpu_ms);
+
+  uevent_free(echo);
+  uevent_deinit(base);
+  close(sv[0]);
+  free(client.rtt_ns);
+}
+
+// --- счетчики ссылок соседних слотов из нескольких потоков: плотные слоты против padded ---
+
+typedef struct {
+  uev_t *uev;
+  int iters;
+} slot_churn_arg_t;
+
+static void *slot_churn_thread(void *arg) {
+  slot_churn_arg_t *a = arg;
+  for (int i = 0; i < a->iters; i++) {
+    if (uevent_try_ref(a->uev) == NULL) abort();
+    (void)uevent_pending(a->uev, UEV_TIMEOUT);
+    uevent_put(a->uev);
+  }
+  return NULL;
+}
+
+static void slot_churn_noop_cb(uevent_t *ev, int fd, short event, void *arg) {
+  (void)ev;
+  (void)fd;
+  (void)event;
+  (void)arg;
+}
+
+void run_slot_churn_test(bool pad_slots, int threads, int iters) {
+  setup_syslog2("uevent_test", LOG_WARNING, false);
+  uevent_base_args_t args = {.max_events = 64, .num_workers = 0, .pad_slots = pad_slots};
+  uevent_base_t *base = uevent_base_new_with_args(&args);
+  assert(base);
+
+  // соседние слоты: без padding четыре счетчика ссылок делят одну кеш-линию
+  uev_t **uevs = calloc((size_t)threads, sizeof(uev_t *));
+  slot_churn_arg_t *targs = calloc((size_t)threads, sizeof(slot_churn_arg_t));
+  pthread_t *th = calloc((size_t)threads, sizeof(pthread_t));
+  assert(uevs && targs && th);
+  for (int i = 0; i < threads; i++) {
+    uevs[i] = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, slot_churn_noop_cb, NULL, "churn");
+    assert(uevs[i]);
+    targs[i].uev = uevs[i];
+    targs[i].iters = iters;
+  }
+
+  long long start = get_time_ns();
+  for (int i = 0; i < threads; i++) {
+    if (pthread_create(&th[i], NULL, slot_churn_thread, &targs[i]) != 0) abort();
+  }
+  for (int i = 0; i < threads; i++) pthread_join(th[i], NULL);
+  long long elapsed_ns = get_time_ns() - start;
+
+  size_t slot_bytes = (size_t)((char *)uevs[threads > 1 ? 1 : 0] - (char *)uevs[0]);
+  printf("result slot_churn pad=%d threads=%d ops=%lld rate=%.1fMops/s mem_per_event=%zuB (uevent_t=%zu slot=%zu)\n",
+         pad_slots, threads, (long long)threads * iters, (double)threads * iters * 1e3 / (double)(elapsed_ns > 0 ? elapsed_ns : 1),
+         sizeof(uevent_t) + slot_bytes, sizeof(uevent_t), slot_bytes);
+
+  for (int i = 0; i < threads; i++) uevent_free(uevs[i]);
+  uevent_deinit(base);
+  free(th);
+  free(targs);
+  free(uevs);
+}
+
 // --- Код для тестирования libevent ---
 
 static int libevent_triggered_count;
@@ -159,7 +647,509 @@ void run_libuv_test(int num_events) {
   uv_loop_delete(loop);
 }
 
-int main() {
+// --- Набор бенчмарков с машиночитаемым выводом: ./perftest --json ---
+//
+// Каждый сценарий собирает задержку отдельных операций и печатает p50/p99/p999 и ops/s.
+// С --json вывод — один JSON-массив объектов, по объекту на сценарий, для сравнения между версиями.
+
+typedef struct {
+  long long *ns;            // задержки операций в нс
+  _Atomic size_t n;         // сколько записано, пишут несколько потоков
+  size_t cap;
+} bench_samples_t;
+
+static bool bench_json;
+static int bench_reported;
+
+static void bench_samples_init(bench_samples_t *s, size_t cap) {
+  s->ns = calloc(cap, sizeof(long long));
+  assert(s->ns);
+  atomic_store(&s->n, 0);
+  s->cap = cap;
+}
+
+static inline void bench_sample(bench_samples_t *s, long long ns) {
+  size_t i = atomic_fetch_add_explicit(&s->n, 1, memory_order_relaxed);
+  if (i < s->cap) s->ns[i] = ns;
+}
+
+static long long bench_pct(const long long *sorted, size_t n, int permille) {
+  if (n == 0) return 0;
+  size_t i = n * (size_t)permille / 1000;
+  return sorted[i < n ? i : n - 1];
+}
+
+// печать результата и освобождение выборки; params — готовый JSON-объект параметров
+static void bench_report(const char *scenario, const char *params, bench_samples_t *s, long long ops, long long elapsed_ns) {
+  size_t n = atomic_load(&s->n);
+  if (n > s->cap) n = s->cap;
+  qsort(s->ns, n, sizeof(long long), cmp_ll);
+  long long p50 = bench_pct(s->ns, n, 500), p99 = bench_pct(s->ns, n, 990), p999 = bench_pct(s->ns, n, 999);
+  long long max = n ? s->ns[n - 1] : 0;
+  double rate = (double)ops * 1e9 / (double)(elapsed_ns > 0 ? elapsed_ns : 1);
+  if (bench_json) {
+    printf("%s\n  {\"scenario\":\"%s\",\"params\":%s,\"ops\":%lld,\"elapsed_ns\":%lld,\"ops_per_sec\":%.0f,"
+           "\"samples\":%zu,\"p50_ns\":%lld,\"p99_ns\":%lld,\"p999_ns\":%lld,\"max_ns\":%lld}",
+           bench_reported ? "," : "", scenario, params, ops, elapsed_ns, rate, n, p50, p99, p999, max);
+  } else {
+    printf("bench %-20s %s ops=%lld rate=%.0f/s p50=%.2fus p99=%.2fus p999=%.2fus max=%.2fus\n",
+           scenario, params, ops, rate, p50 / 1000.0, p99 / 1000.0, p999 / 1000.0, max / 1000.0);
+  }
+  fflush(stdout);
+  bench_reported++;
+  free(s->ns);
+  s->ns = NULL;
+}
+
+// ping-pong по одной паре сокетов: клиент в отдельном потоке меряет каждый обмен
+void bench_pingpong_latency(int rounds) {
+  setup_syslog2("uevent_test", LOG_ERR, false);
+  uevent_base_t *base = uevent_base_new_with_workers(16, 0);
+  assert(base);
+
+  int sv[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) abort();
+  if (fcntl(sv[0], F_SETFL, O_NONBLOCK) != 0) abort();
+  uev_t *echo = uevent_create_or_assign_event(NULL, base, sv[0], UEV_READ | UEV_PERSIST, rtt_echo_cb, NULL, "bench_echo");
+  assert(echo);
+  uevent_add(echo, 0);
+
+  rtt_client_t client = {.fd = sv[1], .rounds = rounds, .rtt_ns = calloc((size_t)rounds, sizeof(long long))};
+  assert(client.rtt_ns);
+  pthread_t th;
+  long long start = get_time_ns();
+  if (pthread_create(&th, NULL, rtt_client_thread, &client) != 0) abort();
+  uevent_base_dispatch(base);
+  pthread_join(th, NULL);
+  long long elapsed_ns = get_time_ns() - start;
+
+  bench_samples_t s = {.ns = client.rtt_ns, .cap = (size_t)rounds};
+  atomic_store(&s.n, (size_t)rounds);
+  char params[64];
+  snprintf(params, sizeof(params), "{\"rounds\":%d}", rounds);
+  bench_report("pingpong_latency", params, &s, rounds, elapsed_ns);
+
+  uevent_free(echo);
+  uevent_deinit(base);
+  close(sv[0]);
+}
+
+typedef struct {
+  int fd;
+  long long sent_ns;
+} bench_conn_t;
+
+static struct {
+  bench_samples_t samples;
+  int total;
+  int target;
+  uevent_base_t *base;
+} bench_conns;
+
+// клиентская сторона соединения: задержка обмена и следующий запрос
+static void bench_conn_client_cb(uevent_t *ev, int fd, short event, void *arg) {
+  (void)ev;
+  (void)event;
+  bench_conn_t *c = arg;
+  char ch;
+  while (read(fd, &ch, 1) == 1) {
+    long long now = get_time_ns();
+    bench_sample(&bench_conns.samples, now - c->sent_ns);
+    if (++bench_conns.total >= bench_conns.target) {
+      uevent_base_loopbreak(bench_conns.base);
+      return;
+    }
+    c->sent_ns = now;
+    if (write(fd, &ch, 1) != 1) abort();
+  }
+}
+
+// много соединений одновременно в одном цикле: пропускная способность и задержка обмена под нагрузкой
+void bench_conn_throughput(uev_io_backend_t backend, int want_conns, int rounds) {
+  setup_syslog2("uevent_test", LOG_ERR, false);
+  int conns = pingpong_max_conns(want_conns);
+
+  uevent_base_args_t args = {.max_events = 1024, .num_workers = 0, .io_backend = backend};
+  uevent_base_t *base = uevent_base_new_with_args(&args);
+  assert(base);
+
+  int (*fds)[2] = calloc((size_t)conns, sizeof(*fds));
+  bench_conn_t *cs = calloc((size_t)conns, sizeof(bench_conn_t));
+  uev_t **uevs = calloc((size_t)conns * 2, sizeof(uev_t *));
+  assert(fds && cs && uevs);
+
+  bench_samples_init(&bench_conns.samples, (size_t)conns * (size_t)rounds);
+  bench_conns.total = 0;
+  bench_conns.target = conns * rounds;
+  bench_conns.base = base;
+
+  for (int i = 0; i < conns; i++) {
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds[i]) != 0) abort();
+    cs[i].fd = fds[i][1];
+    uevs[2 * i] = uevent_create_or_assign_event(NULL, base, fds[i][0], UEV_READ | UEV_PERSIST, pingpong_echo_cb, NULL, "bench_echo");
+    uevs[2 * i + 1] = uevent_create_or_assign_event(NULL, base, fds[i][1], UEV_READ | UEV_PERSIST, bench_conn_client_cb, &cs[i], "bench_client");
+    assert(uevs[2 * i] && uevs[2 * i + 1]);
+    uevent_add(uevs[2 * i], 0);
+    uevent_add(uevs[2 * i + 1], 0);
+  }
+
+  long long start = get_time_ns();
+  for (int i = 0; i < conns; i++) {
+    cs[i].sent_ns = get_time_ns();
+    if (write(fds[i][1], "p", 1) != 1) abort();
+  }
+  uevent_base_dispatch(base);
+  long long elapsed_ns = get_time_ns() - start;
+
+  char params[96];
+  snprintf(params, sizeof(params), "{\"backend\":\"%s\",\"conns\":%d,\"rounds\":%d}",
+           uevent_base_io_backend(base) == UEV_IO_URING ? "io_uring" : "epoll", conns, rounds);
+  bench_report("conn_throughput", params, &bench_conns.samples, bench_conns.total, elapsed_ns);
+
+  for (int i = 0; i < conns * 2; i++) uevent_free(uevs[i]);
+  uevent_deinit(base);
+  for (int i = 0; i < conns; i++) {
+    close(fds[i][0]);
+    close(fds[i][1]);
+  }
+  free(uevs);
+  free(cs);
+  free(fds);
+}
+
+// взвод и отмена таймеров, которые не успевают сработать: отдельно мерится каждая операция
+void bench_timer_churn(uev_timer_backend_t backend, int num_timers, int passes) {
+  setup_syslog2("uevent_test", LOG_ERR, false);
+  uevent_base_args_t args = {.max_events = num_timers + 16, .num_workers = 0, .timer_backend = backend};
+  uevent_base_t *base = uevent_base_new_with_args(&args);
+  assert(base);
+
+  uev_t **uevs = malloc(sizeof(uev_t *) * num_timers);
+  assert(uevs);
+  for (int i = 0; i < num_timers; i++) {
+    uevs[i] = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, uevent_perf_cb, &uevent_triggered_count, "bench_churn");
+    assert(uevs[i]);
+  }
+
+  bench_samples_t s;
+  bench_samples_init(&s, (size_t)num_timers * (size_t)passes * 2);
+  srand(42);
+  long long start = get_time_ns();
+  for (int p = 0; p < passes; p++) {
+    for (int i = 0; i < num_timers; i++) {
+      long long t0 = get_time_ns();
+      uevent_add(uevs[i], 10000 + rand() % 50000);
+      bench_sample(&s, get_time_ns() - t0);
+    }
+    for (int i = 0; i < num_timers; i++) {
+      long long t0 = get_time_ns();
+      uevent_del(uevs[i]);
+      bench_sample(&s, get_time_ns() - t0);
+    }
+  }
+  long long elapsed_ns = get_time_ns() - start;
+
+  char params[96];
+  snprintf(params, sizeof(params), "{\"backend\":\"%s\",\"timers\":%d,\"passes\":%d}", timer_backend_name(backend), num_timers, passes);
+  bench_report("timer_churn", params, &s, (long long)num_timers * passes * 2, elapsed_ns);
+
+  for (int i = 0; i < num_timers; i++) uevent_free(uevs[i]);
+  free(uevs);
+  uevent_deinit(base);
+}
+
+typedef struct {
+  uev_t **uevs;
+  int num_timers;
+  int iters;
+  bench_samples_t *samples;
+} bench_add_thread_arg_t;
+
+static void *bench_add_thread(void *arg) {
+  bench_add_thread_arg_t *a = arg;
+  unsigned int seed = (unsigned int)(uintptr_t)a;
+  for (int k = 0; k < a->iters; k++) {
+    for (int i = 0; i < a->num_timers; i++) {
+      long long t0 = get_time_ns();
+      uevent_add(a->uevs[i], 10000 + rand_r(&seed) % 50000);
+      bench_sample(a->samples, get_time_ns() - t0);
+    }
+  }
+  return NULL;
+}
+
+// uevent_add из нескольких потоков при работающем цикле: конкуренция за очередь команд базы
+void bench_cross_thread_add(int num_threads, int timers_per_thread, int iters) {
+  setup_syslog2("uevent_test", LOG_ERR, false);
+  int total = num_threads * timers_per_thread;
+  uevent_base_t *base = uevent_base_new_with_workers(total + 16, 0);
+  assert(base);
+
+  uev_t *keeper = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT | UEV_PERSIST, uevent_perf_cb, &uevent_triggered_count, "bench_keeper");
+  assert(keeper);
+  uevent_set_timeout(keeper, 3600 * 1000);
+  uevent_add_with_current_timeout(keeper);
+  uev_t **uevs = malloc(sizeof(uev_t *) * total);
+  assert(uevs);
+  for (int i = 0; i < total; i++) {
+    uevs[i] = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, uevent_perf_cb, &uevent_triggered_count, "bench_add");
+    assert(uevs[i]);
+  }
+
+  pthread_t dispatcher;
+  if (pthread_create(&dispatcher, NULL, rearm_dispatch_thread, base) != 0) abort();
+  usleep(10000);
+
+  bench_samples_t s;
+  bench_samples_init(&s, (size_t)total * (size_t)iters);
+  pthread_t *th = calloc((size_t)num_threads, sizeof(pthread_t));
+  bench_add_thread_arg_t *args = calloc((size_t)num_threads, sizeof(bench_add_thread_arg_t));
+  assert(th && args);
+  long long start = get_time_ns();
+  for (int t = 0; t < num_threads; t++) {
+    args[t] = (bench_add_thread_arg_t){.uevs = uevs + t * timers_per_thread, .num_timers = timers_per_thread, .iters = iters, .samples = &s};
+    if (pthread_create(&th[t], NULL, bench_add_thread, &args[t]) != 0) abort();
+  }
+  for (int t = 0; t < num_threads; t++) pthread_join(th[t], NULL);
+  long long elapsed_ns = get_time_ns() - start;
+
+  char params[96];
+  snprintf(params, sizeof(params), "{\"threads\":%d,\"timers\":%d}", num_threads, total);
+  bench_report("cross_thread_add", params, &s, (long long)total * iters, elapsed_ns);
+
+  uevent_base_loopbreak(base);
+  pthread_join(dispatcher, NULL);
+  for (int i = 0; i < total; i++) uevent_free(uevs[i]);
+  uevent_free(keeper);
+  free(uevs);
+  free(args);
+  free(th);
+  uevent_deinit(base);
+}
+
+typedef struct {
+  int fd[2];
+  _Atomic long long armed_ns; // момент записи в fd, 0 — колбэк отработал и событие свободно
+} bench_task_t;
+
+static bench_samples_t bench_worker_samples;
+
+static void bench_worker_cb(uevent_t *ev, int fd, short event, void *arg) {
+  (void)ev;
+  (void)event;
+  bench_task_t *t = arg;
+  char buf[16];
+  while (read(fd, buf, sizeof(buf)) > 0) {
+  }
+  bench_sample(&bench_worker_samples, get_time_ns() - atomic_load(&t->armed_ns));
+  atomic_store(&t->armed_ns, 0);
+}
+
+// готовность fd до выполнения колбэка в пуле воркеров; события активируются записью в pipe,
+// а не uevent_active: uevent_add из чужого потока держит блокировку события и мог бы
+// пересечься с колбэком
+void bench_worker_dispatch(int num_workers, int num_events, int activations) {
+  setup_syslog2("uevent_test", LOG_ERR, false);
+  uevent_base_t *base = uevent_base_new_with_workers(num_events + 16, num_workers);
+  assert(base);
+
+  bench_task_t *tasks = calloc((size_t)num_events, sizeof(bench_task_t));
+  uev_t **uevs = calloc((size_t)num_events, sizeof(uev_t *));
+  assert(tasks && uevs);
+  for (int i = 0; i < num_events; i++) {
+    if (pipe2(tasks[i].fd, O_NONBLOCK) != 0) abort();
+    uevs[i] = uevent_create_or_assign_event(NULL, base, tasks[i].fd[0], UEV_READ | UEV_PERSIST, bench_worker_cb, &tasks[i], "bench_worker");
+    assert(uevs[i]);
+    uevent_add(uevs[i], 0);
+  }
+
+  pthread_t dispatcher;
+  if (pthread_create(&dispatcher, NULL, rearm_dispatch_thread, base) != 0) abort();
+  usleep(10000);
+
+  bench_samples_init(&bench_worker_samples, (size_t)activations);
+  long long start = get_time_ns();
+  for (int k = 0; k < activations; k++) {
+    bench_task_t *t = &tasks[k % num_events];
+    while (atomic_load(&t->armed_ns) != 0) sched_yield();
+    atomic_store(&t->armed_ns, get_time_ns());
+    if (write(t->fd[1], "w", 1) != 1) abort();
+  }
+  while (atomic_load(&bench_worker_samples.n) < (size_t)activations) sched_yield();
+  long long elapsed_ns = get_time_ns() - start;
+
+  char params[96];
+  snprintf(params, sizeof(params), "{\"workers\":%d,\"events\":%d}", num_workers, num_events);
+  bench_report("worker_dispatch", params, &bench_worker_samples, activations, elapsed_ns);
+
+  uevent_base_loopbreak(base);
+  pthread_join(dispatcher, NULL);
+  for (int i = 0; i < num_events; i++) {
+    uevent_free(uevs[i]);
+    close(tasks[i].fd[0]);
+    close(tasks[i].fd[1]);
+  }
+  free(uevs);
+  free(tasks);
+  uevent_deinit(base);
+}
+
+// цена жизненного цикла события: uevent_create_or_assign_event + uevent_free
+void bench_lifecycle(int live_events, int iters) {
+  setup_syslog2("uevent_test", LOG_ERR, false);
+  uevent_base_t *base = uevent_base_new_with_workers(live_events + 16, 0);
+  assert(base);
+
+  // живые события занимают таблицу слотов, как в работающем сервисе
+  uev_t **live = calloc((size_t)live_events, sizeof(uev_t *));
+  assert(live);
+  for (int i = 0; i < live_events; i++) {
+    live[i] = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, uevent_perf_cb, &uevent_triggered_count, "bench_live");
+    assert(live[i]);
+  }
+
+  bench_samples_t s;
+  bench_samples_init(&s, (size_t)iters);
+  long long start = get_time_ns();
+  for (int i = 0; i < iters; i++) {
+    long long t0 = get_time_ns();
+    uev_t *uev = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, uevent_perf_cb, &uevent_triggered_count, "bench_cycle");
+    if (uev == NULL) abort();
+    uevent_free(uev);
+    bench_sample(&s, get_time_ns() - t0);
+  }
+  long long elapsed_ns = get_time_ns() - start;
+
+  char params[64];
+  snprintf(params, sizeof(params), "{\"live_events\":%d}", live_events);
+  bench_report("event_lifecycle", params, &s, iters, elapsed_ns);
+
+  for (int i = 0; i < live_events; i++) uevent_free(live[i]);
+  free(live);
+  uevent_deinit(base);
+}
+
+// переключение корутин: две корутины по очереди уступают друг другу через очередь готовых,
+// выборка — полный оборот (выход из корутины, проход очереди и возврат в нее)
+static struct {
+  bench_samples_t samples;
+  int rounds;
+} bench_co;
+
+static void bench_co_yield_fn(void *arg) {
+  (void)arg;
+  for (int i = 0; i < bench_co.rounds; i++) {
+    long long t0 = get_time_ns();
+    uev_co_yield();
+    bench_sample(&bench_co.samples, get_time_ns() - t0);
+  }
+}
+
+void bench_co_switch(int rounds) {
+  setup_syslog2("uevent_test", LOG_ERR, false);
+  uevent_base_t *base = uevent_base_new_with_workers(16, 0);
+  assert(base);
+  uev_co_sched_t *sched = uev_co_sched_new(base, NULL);
+  assert(sched);
+
+  bench_co.rounds = rounds;
+  bench_samples_init(&bench_co.samples, (size_t)rounds * 2);
+  assert(uev_co_spawn(sched, bench_co_yield_fn, NULL, "bench_co_a") == UEV_ERR_OK);
+  assert(uev_co_spawn(sched, bench_co_yield_fn, NULL, "bench_co_b") == UEV_ERR_OK);
+  long long start = get_time_ns();
+  uevent_base_dispatch(base);
+  long long elapsed_ns = get_time_ns() - start;
+
+  char params[64];
+  snprintf(params, sizeof(params), "{\"coroutines\":2}");
+  bench_report("co_switch", params, &bench_co.samples, (long long)rounds * 2, elapsed_ns);
+
+  uev_co_sched_free(sched);
+  uevent_deinit(base);
+}
+
+static long bench_rss_bytes(void) {
+  long pages = 0, rss = 0;
+  FILE *f = fopen("/proc/self/statm", "r");
+  if (f == NULL) return 0;
+  if (fscanf(f, "%ld %ld", &pages, &rss) != 2) rss = 0;
+  fclose(f);
+  return rss * sysconf(_SC_PAGESIZE);
+}
+
+static struct {
+  int started;
+  int target;
+  long rss_before;
+  long rss_peak;
+} bench_co_mem;
+
+// каждая корутина засыпает со своим таймером; последняя запущенная снимает RSS, пока живы все
+static void bench_co_sleep_fn(void *arg) {
+  (void)arg;
+  if (++bench_co_mem.started == bench_co_mem.target) bench_co_mem.rss_peak = bench_rss_bytes();
+  uev_co_sleep(10);
+}
+
+// память на корутину при num_cos одновременно живых: стек, заголовок и таймер сна;
+// выборка — цена uev_co_spawn. Без сторожевых страниц: 100 тысяч защищенных стеков
+// не помещаются в vm.max_map_count по умолчанию
+void bench_co_memory(int num_cos, bool guard) {
+  setup_syslog2("uevent_test", LOG_ERR, false);
+  uevent_base_t *base = uevent_base_new_with_workers(1024, 0);
+  assert(base);
+  uev_co_sched_args_t args = {.pool_max = -1, .no_guard = !guard};
+  uev_co_sched_t *sched = uev_co_sched_new(base, &args);
+  assert(sched);
+
+  bench_co_mem.started = 0;
+  bench_co_mem.target = num_cos;
+  bench_co_mem.rss_before = bench_rss_bytes();
+  bench_samples_t s;
+  bench_samples_init(&s, (size_t)num_cos);
+  long long start = get_time_ns();
+  for (int i = 0; i < num_cos; i++) {
+    long long t0 = get_time_ns();
+    if (uev_co_spawn(sched, bench_co_sleep_fn, NULL, "bench_co_sleep") != UEV_ERR_OK) abort();
+    bench_sample(&s, get_time_ns() - t0);
+  }
+  long long elapsed_ns = get_time_ns() - start;
+  uevent_base_dispatch(base);
+  assert(uev_co_sched_live(sched) == 0);
+
+  char params[128];
+  snprintf(params, sizeof(params), "{\"coroutines\":%d,\"guard\":%s,\"rss_bytes_per_co\":%ld}", num_cos,
+           guard ? "true" : "false", (bench_co_mem.rss_peak - bench_co_mem.rss_before) / num_cos);
+  bench_report("co_spawn", params, &s, num_cos, elapsed_ns);
+
+  uev_co_sched_free(sched);
+  uevent_deinit(base);
+}
+
+static void run_bench_suite(void) {
+  if (bench_json) printf("[");
+  bench_pingpong_latency(20000);
+  bench_conn_throughput(UEV_IO_EPOLL, 1000, 50);
+  bench_conn_throughput(UEV_IO_URING, 1000, 50);
+  bench_timer_churn(UEV_TIMER_HEAP, 100000, 5);
+  bench_timer_churn(UEV_TIMER_WHEEL, 100000, 5);
+  bench_cross_thread_add(1, 1000, 200);
+  bench_cross_thread_add(4, 1000, 50);
+  bench_worker_dispatch(4, 64, 100000);
+  bench_lifecycle(10000, 1000000);
+  bench_co_switch(1000000);
+  bench_co_memory(100000, false);
+  bench_co_memory(20000, true);
+  if (bench_json) printf("\n]\n");
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1 && strcmp(argv[1], "--json") == 0) {
+    bench_json = true;
+    run_bench_suite();
+    return 0;
+  }
+
   const int event_counts[] = {100, 1000, 10000};
   int num_tests = sizeof(event_counts) / sizeof(int);
 
@@ -174,5 +1164,40 @@ int main() {
     printf("----------------------------------------\n");
   }
 
+  const int timer_counts[] = {1000, 100000, 1000000};
+  for (size_t i = 0; i < sizeof(timer_counts) / sizeof(timer_counts[0]); i++) {
+    run_timer_backend_test(UEV_TIMER_HEAP, timer_counts[i]);
+    run_timer_backend_test(UEV_TIMER_WHEEL, timer_counts[i]);
+  }
+
+  const int vday_counts[] = {100, 1000};
+  for (size_t i = 0; i < sizeof(vday_counts) / sizeof(vday_counts[0]); i++) {
+    run_virtual_day_test(UEV_TIMER_HEAP, vday_counts[i]);
+    run_virtual_day_test(UEV_TIMER_WHEEL, vday_counts[i]);
+  }
+
+  const int rearm_threads[] = {1, 4};
+  for (size_t i = 0; i < sizeof(rearm_threads) / sizeof(rearm_threads[0]); i++) {
+    run_cross_thread_rearm_test(rearm_threads[i], 1000);
+  }
+
+  const int lateness_delays_us[] = {50, 200};
+  for (size_t i = 0; i < sizeof(lateness_delays_us) / sizeof(lateness_delays_us[0]); i++) {
+    run_timer_lateness_test(false, lateness_delays_us[i]);
+    run_timer_lateness_test(true, lateness_delays_us[i]);
+  }
+
+  run_pingpong_test(UEV_IO_EPOLL, 10000, 20);
+  run_pingpong_test(UEV_IO_URING, 10000, 20);
+
+  run_rtt_test(0, 20000);
+  run_rtt_test(50, 20000);
+
+  run_slot_churn_test(false, 4, 5000000);
+  run_slot_churn_test(true, 4, 5000000);
+
+  printf("----------------------------------------\n");
+  run_bench_suite();
+
   return 0;
 }
@@ -1,6 +1,10 @@
 
 #include "uevent.h"
+#include "uevent_co.h"
+#include "uevent_group.h"
 #include "uevent_internal.h"
+#include "uevent_listener.h"
+#include "uevent_stream.h"
 #include "uevent_worker.h"
 #include <assert.h>
 #include <dirent.h>
@@ -8,10 +12,15 @@
 #include <fcntl.h>
 #include <inttypes.h>
 #include <limits.h>
+#include <netinet/in.h>
 #include <pthread.h>
+#include <sched.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
 #include <sys/syscall.h>
 #include <sys/wait.h>
 #include <time.h>
@@ -76,6 +85,50 @@ static int get_open_fd_count(void) {
   return count;
 }
 
+// syslog2 пишет прямо в fd 1: подменяем его временным файлом на время проверки
+static int log_capture_begin(int *saved) {
+  fflush(stdout);
+  FILE *f = tmpfile();
+  assert(f != NULL);
+  int fd = dup(fileno(f));
+  fclose(f);
+  *saved = dup(STDOUT_FILENO);
+  assert(fd >= 0 && *saved >= 0);
+  dup2(fd, STDOUT_FILENO);
+  return fd;
+}
+
+// вернуть stdout и проверить, встречалась ли строка в перехваченном выводе
+static bool log_capture_end(int fd, int saved, const char *needle) {
+  dup2(saved, STDOUT_FILENO);
+  close(saved);
+  char buf[65536];
+  ssize_t n = pread(fd, buf, sizeof(buf) - 1, 0);
+  close(fd);
+  buf[n > 0 ? n : 0] = '\0';
+  return strstr(buf, needle) != NULL;
+}
+
+// зарегистрирован ли fd в каком-нибудь epoll процесса: строки tfd в /proc/self/fdinfo
+static bool fd_in_some_epoll(int fd) {
+  bool found = false;
+  DIR *d = opendir("/proc/self/fd");
+  if (!d) return false;
+  for (struct dirent *de; !found && (de = readdir(d)) != NULL;) {
+    char path[300], line[256];
+    snprintf(path, sizeof(path), "/proc/self/fdinfo/%s", de->d_name);
+    FILE *f = fopen(path, "r");
+    if (!f) continue;
+    int tfd;
+    while (!found && fgets(line, sizeof(line), f) != NULL) {
+      if (sscanf(line, "tfd: %d", &tfd) == 1 && tfd == fd) found = true;
+    }
+    fclose(f);
+  }
+  closedir(d);
+  return found;
+}
+
 // =============================================================================
 // ХЕЛПЕР ДЛЯ ТЕСТИРОВАНИЯ ПАДЕНИЙ
 // =============================================================================
@@ -429,6 +482,26 @@ void test_create_and_free_static_event() {
   assert(uev_ptr != NULL);                   // uev_ptr is now the wrapper for 'ev'
   assert(ATOM_LOAD_ACQ(uev_ptr->ev) == &ev); // The wrapper should point to the static event
   uevent_free(uev_ptr);
+
+  // в работающем цикле статическое событие освобождается сразу, а не в конце итерации:
+  // его можно тут же назначить заново
+  uevent_t st = {.is_static = true};
+  bool reassigned = false;
+  void reassign_cb(uevent_t * tev, int fd, short event, void *arg) {
+    uev_t *s = uevent_create_or_assign_event(&st, base, -1, UEV_TIMEOUT, NULL, NULL, "static_first");
+    assert(s != NULL);
+    uevent_free(s);
+    assert(ATOM_LOAD_ACQ(st.base) == NULL);
+    s = uevent_create_or_assign_event(&st, base, -1, UEV_TIMEOUT, NULL, NULL, "static_again");
+    reassigned = s != NULL;
+    uevent_free(s);
+  }
+  uev_t *t = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, reassign_cb, NULL, "static_reassign");
+  assert(t != NULL);
+  assert(uevent_add(t, 1) == UEV_ERR_OK);
+  uevent_base_dispatch(base);
+  assert(reassigned);
+  uevent_free(t);
   uevent_deinit(base);
   PRINT_TEST_PASSED();
 }
@@ -1153,10 +1226,11 @@ void test_refcount_during_callback_execution() {
 
   // 2. Проверка refcount ВО ВРЕМЯ работы колбэка.
   // Ждем 1.5 секунды: 1с до срабатывания таймера + 0.5с пока колбэк "работает".
-  sleep(1.5);
+  usleep(1500000);
   int mid_rcount = atomic_load(&test_uev->refcount);
   PRINT_TEST_INFO("Checking refcount during callback execution: mid_rcount=%d", mid_rcount);
-  assert(mid_rcount == 2 && "expected refcount=2 during callback execution (event + timer ref)");
+  // колбэк в потоке цикла ссылку не берет: событие защищено отложенным освобождением до конца итерации
+  assert(mid_rcount == 1 && "expected refcount=1 during callback execution (event ref only)");
 
   // 3. Проверка refcount ПОСЛЕ завершения колбэка.
   // Ждем еще 1 секунду, чтобы колбэк точно завершился.
@@ -1516,6 +1590,1852 @@ void test_stdin_read_write_event_no_del() {
   PRINT_TEST_PASSED();
 }
 
+void test_timer_wheel_random() {
+  PRINT_TEST_START("timer wheel vs brute force");
+#define WHEEL_TEST_NODES 4096
+  static uev_wheel_node_t nodes[WHEEL_TEST_NODES];
+  static bool linked[WHEEL_TEST_NODES];
+  uint64_t now = 1000;
+  uev_wheel_t *wheel = uev_wheel_create(now);
+  assert(wheel != NULL);
+
+  srand(12345);
+  for (int i = 0; i < WHEEL_TEST_NODES; i++) {
+    // разброс по всем уровням колеса, включая таймеры за пределами диапазона
+    int lvl = rand() % 8;
+    uint64_t range = 1ULL << (lvl * 6);
+    nodes[i].expires = now + (uint64_t)rand() % range;
+    uev_wheel_add(wheel, &nodes[i]);
+    linked[i] = true;
+  }
+  assert(uev_wheel_size(wheel) == WHEEL_TEST_NODES);
+
+  int popped = 0;
+  for (int step = 0; step < 20000 && uev_wheel_size(wheel) > 0; step++) {
+    // случайное удаление и перепланирование
+    int idx = rand() % WHEEL_TEST_NODES;
+    if (linked[idx] && rand() % 4 == 0) {
+      uev_wheel_del(wheel, &nodes[idx]);
+      linked[idx] = false;
+    } else if (linked[idx] && rand() % 4 == 0) {
+      nodes[idx].expires = now + (uint64_t)rand() % 5000;
+      uev_wheel_add(wheel, &nodes[idx]);
+    }
+
+    uint64_t bound;
+    if (uev_wheel_next_expiry(wheel, &bound)) {
+      uint64_t real_min = UINT64_MAX;
+      for (int i = 0; i < WHEEL_TEST_NODES; i++) {
+        if (linked[i] && nodes[i].expires < real_min) real_min = nodes[i].expires;
+      }
+      assert(bound <= real_min);
+    }
+
+    now += (uint64_t)(rand() % 4 == 0 ? rand() % 100000 : rand() % 64);
+    uev_wheel_node_t *node;
+    while ((node = uev_wheel_pop_expired(wheel, now)) != NULL) {
+      assert(node->expires <= now);
+      ptrdiff_t i = node - nodes;
+      assert(linked[i]);
+      linked[i] = false;
+      popped++;
+    }
+    // все истекшие узлы должны быть извлечены
+    for (int i = 0; i < WHEEL_TEST_NODES; i++) {
+      assert(!linked[i] || nodes[i].expires > now);
+    }
+  }
+  PRINT_TEST_INFO("popped=%d left=%u now=%" PRIu64, popped, uev_wheel_size(wheel), now);
+
+  while (uev_wheel_pop_any(wheel) != NULL) {
+  }
+  assert(uev_wheel_size(wheel) == 0);
+  uev_wheel_free(wheel);
+#undef WHEEL_TEST_NODES
+  PRINT_TEST_PASSED();
+}
+
+void test_timer_wheel_backend() {
+  PRINT_TEST_START("timers on UEV_TIMER_WHEEL backend");
+  uevent_base_args_t args = {.max_events = 16, .num_workers = 0, .timer_backend = UEV_TIMER_WHEEL};
+  uevent_base_t *base = uevent_base_new_with_args(&args);
+  assert(base != NULL);
+
+  int order[4] = {0};
+  int fired = 0;
+  int persist_cnt = 0;
+
+  void one_shot_cb(uevent_t * ev, int fd, short event, void *arg) {
+    order[fired++] = (int)(intptr_t)arg;
+  }
+  void persist_cb(uevent_t * ev, int fd, short event, void *arg) {
+    if (++persist_cnt == 5) uevent_del(ev->uev);
+  }
+
+  uev_t *t1 = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, one_shot_cb, (void *)1, "wheel_t1");
+  uev_t *t2 = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, one_shot_cb, (void *)2, "wheel_t2");
+  uev_t *t3 = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, one_shot_cb, (void *)3, "wheel_t3");
+  uev_t *cancelled = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, one_shot_cb, (void *)4, "wheel_cancel");
+  uev_t *persist = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT | UEV_PERSIST, persist_cb, NULL, "wheel_persist");
+  assert(t1 && t2 && t3 && cancelled && persist);
+
+  uint64_t start = tu_clock_gettime_monotonic_ms();
+  assert(uevent_add(t3, 150) == UEV_ERR_OK);
+  assert(uevent_add(t1, 20) == UEV_ERR_OK);
+  assert(uevent_add(t2, 80) == UEV_ERR_OK);
+  assert(uevent_add(cancelled, 40) == UEV_ERR_OK);
+  uevent_set_timeout(persist, 10);
+  uevent_add_with_current_timeout(persist);
+  assert(uevent_pending(cancelled, UEV_TIMEOUT));
+  assert(uevent_del(cancelled) == UEV_ERR_OK);
+  assert(!uevent_pending(cancelled, UEV_TIMEOUT));
+
+  uevent_base_dispatch(base);
+  uint64_t elapsed = tu_clock_gettime_monotonic_ms() - start;
+
+  PRINT_TEST_INFO("fired=%d order=%d,%d,%d persist=%d elapsed=%" PRIu64, fired, order[0], order[1], order[2], persist_cnt, elapsed);
+  assert(fired == 3);
+  assert(order[0] == 1 && order[1] == 2 && order[2] == 3);
+  assert(persist_cnt == 5);
+  assert(elapsed >= 150);
+
+  uevent_free(t1);
+  uevent_free(t2);
+  uevent_free(t3);
+  uevent_free(cancelled);
+  uevent_free(persist);
+  uevent_deinit(base);
+  PRINT_TEST_PASSED();
+}
+
+void test_cross_thread_rearm_queue() {
+  PRINT_TEST_START("cross-thread timer re-arm through base command queue");
+  uevent_base_t *base = uevent_base_new_with_workers(64, 4);
+  assert(base != NULL);
+
+  enum { PRODUCERS = 4,
+         PER_PRODUCER = 8,
+         TIMERS = PRODUCERS * PER_PRODUCER,
+         FIRES = 50,
+         FLOOD = 1000 };
+  atomic_int counts[TIMERS];
+  atomic_int victim_fired;
+  atomic_init(&victim_fired, 0);
+  for (int i = 0; i < TIMERS; i++) atomic_init(&counts[i], 0);
+  uev_t *timers[TIMERS];
+
+  void count_cb(uevent_t * ev, int fd, short event, void *arg) { atomic_fetch_add((atomic_int *)arg, 1); }
+  void victim_cb(uevent_t * ev, int fd, short event, void *arg) { atomic_fetch_add(&victim_fired, 1); }
+  void *dispatch_thread(void *arg) {
+    uevent_base_dispatch((uevent_base_t *)arg);
+    return NULL;
+  }
+  // перевзводит свои таймеры из чужого потока, пока каждый не сработает FIRES раз
+  void *producer_thread(void *arg) {
+    int first = (int)(intptr_t)arg * PER_PRODUCER;
+    for (int left = PER_PRODUCER; left > 0;) {
+      left = 0;
+      for (int i = first; i < first + PER_PRODUCER; i++) {
+        if (atomic_load(&counts[i]) >= FIRES) continue;
+        left++;
+        if (!uevent_pending(timers[i], UEV_TIMEOUT)) (void)uevent_add(timers[i], 1);
+      }
+      usleep(200);
+    }
+    return NULL;
+  }
+
+  uev_t *keeper = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT | UEV_PERSIST, count_cb, &victim_fired, "keeper");
+  uev_t *victim = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, victim_cb, NULL, "victim");
+  assert(keeper && victim);
+  for (int i = 0; i < TIMERS; i++) {
+    timers[i] = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, count_cb, &counts[i], "rearm");
+    assert(timers[i]);
+  }
+  // keeper держит цикл живым, victim_fired он не трогает до истечения часа
+  uevent_set_timeout(keeper, 3600 * 1000);
+  uevent_add_with_current_timeout(keeper);
+
+  pthread_t tid;
+  pthread_t producers[PRODUCERS];
+  pthread_create(&tid, NULL, dispatch_thread, base);
+  msleep(20);
+  for (int t = 0; t < PRODUCERS; t++) {
+    pthread_create(&producers[t], NULL, producer_thread, (void *)(intptr_t)t);
+  }
+
+  // add+del из чужого потока схлопываются в очереди, victim не должен сработать
+  for (int i = 0; i < FLOOD; i++) {
+    assert(uevent_add(victim, 100) == UEV_ERR_OK);
+    assert(uevent_pending(victim, UEV_TIMEOUT));
+    assert(uevent_del(victim) == UEV_ERR_OK);
+    assert(!uevent_pending(victim, UEV_TIMEOUT));
+  }
+
+  for (int t = 0; t < PRODUCERS; t++) {
+    pthread_join(producers[t], NULL);
+  }
+  msleep(150);
+
+  PRINT_TEST_INFO("victim_fired=%d", atomic_load(&victim_fired));
+  assert(atomic_load(&victim_fired) == 0);
+  for (int i = 0; i < TIMERS; i++) assert(atomic_load(&counts[i]) >= FIRES);
+
+  uevent_base_loopbreak(base);
+  pthread_join(tid, NULL);
+  for (int i = 0; i < TIMERS; i++) uevent_free(timers[i]);
+  uevent_free(victim);
+  uevent_free(keeper);
+  uevent_deinit(base);
+  PRINT_TEST_PASSED();
+}
+
+void test_hires_timers() {
+  PRINT_TEST_START("sub-millisecond timers with hires_timers and uevent_add_us");
+
+  uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+  }
+
+  uint64_t fired_at[2] = {0};
+  int order[2] = {0};
+  int fired = 0;
+  void cb(uevent_t * ev, int fd, short event, void *arg) {
+    int id = (int)(intptr_t)arg;
+    fired_at[id] = now_us();
+    order[fired++] = id;
+  }
+
+  uevent_base_args_t args = {.max_events = 8, .num_workers = 0, .hires_timers = true};
+  uevent_base_t *base = uevent_base_new_with_args(&args);
+  assert(base != NULL);
+  uev_t *t0 = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, cb, (void *)0, "us_t0");
+  uev_t *t1 = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, cb, (void *)1, "us_t1");
+  assert(t0 && t1);
+
+  uint64_t start = now_us();
+  assert(uevent_add_us(t1, 500) == UEV_ERR_OK);
+  assert(uevent_add_us(t0, 200) == UEV_ERR_OK);
+  // задержка считается в мс и с наносекундными часами: вовремя сработавший таймер не дает TIMER_LAG
+  int saved_out;
+  int log_fd = log_capture_begin(&saved_out);
+  uevent_base_dispatch(base);
+  assert(!log_capture_end(log_fd, saved_out, "[TIMER_LAG]"));
+
+  PRINT_TEST_INFO("t0=+%" PRIu64 "us t1=+%" PRIu64 "us", fired_at[0] - start, fired_at[1] - start);
+  assert(fired == 2);
+  assert(order[0] == 0 && order[1] == 1);
+  assert(fired_at[0] - start >= 200);
+  assert(fired_at[1] - start >= 500);
+
+  uevent_free(t0);
+  uevent_free(t1);
+  uevent_deinit(base);
+
+  // без hires_timers микросекунды округляются вверх до миллисекунды
+  base = uevent_base_new_with_workers(8, 0);
+  assert(base != NULL);
+  t0 = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, cb, (void *)0, "ms_t0");
+  assert(t0);
+  fired = 0;
+  start = now_us();
+  assert(uevent_add_us(t0, 1500) == UEV_ERR_OK);
+  uevent_base_dispatch(base);
+  PRINT_TEST_INFO("ms mode: t0=+%" PRIu64 "us", fired_at[0] - start);
+  assert(fired == 1);
+  assert(fired_at[0] - start >= 1000);
+
+  uevent_free(t0);
+  uevent_deinit(base);
+  PRINT_TEST_PASSED();
+}
+
+void test_timer_batch_expiry() {
+  PRINT_TEST_START("batched timer expiry: per-base cap, bulk worker insert, del of co-expiring timer");
+  enum { N = 3000 };
+  atomic_int count;
+  atomic_init(&count, 0);
+  void count_cb(uevent_t * ev, int fd, short event, void *arg) { atomic_fetch_add((atomic_int *)arg, 1); }
+
+  // маленький лимит пачки: все таймеры одного тика срабатывают за несколько итераций
+  uevent_base_args_t args = {.max_events = N + 1, .num_workers = 4, .timer_batch_max = 64};
+  uevent_base_t *base = uevent_base_new_with_args(&args);
+  assert(base != NULL);
+  for (int i = 0; i < N; i++) {
+    uev_t *uev = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, count_cb, &count, "batch");
+    assert(uev);
+    assert(uevent_add(uev, 10) == UEV_ERR_OK);
+  }
+  uevent_base_dispatch(base);
+  PRINT_TEST_INFO("fired=%d of %d", atomic_load(&count), N);
+  assert(atomic_load(&count) == N);
+  uevent_deinit(base);
+
+  // таймеры из одной пачки отменяют друг друга: сработать должен только один
+  uev_t *pair[2];
+  atomic_init(&count, 0);
+  void cancel_peer_cb(uevent_t * ev, int fd, short event, void *arg) {
+    atomic_fetch_add(&count, 1);
+    uevent_del(pair[(intptr_t)arg]);
+  }
+  base = uevent_base_new_with_workers(8, 0);
+  assert(base != NULL);
+  pair[0] = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, cancel_peer_cb, (void *)1, "pair0");
+  pair[1] = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, cancel_peer_cb, (void *)0, "pair1");
+  assert(pair[0] && pair[1]);
+  assert(uevent_add(pair[0], 5) == UEV_ERR_OK);
+  assert(uevent_add(pair[1], 5) == UEV_ERR_OK);
+  uevent_base_dispatch(base);
+  assert(atomic_load(&count) == 1);
+  uevent_free(pair[0]);
+  uevent_free(pair[1]);
+  uevent_deinit(base);
+
+  args.timer_batch_max = -1;
+  assert(uevent_base_new_with_args(&args) == NULL);
+  PRINT_TEST_PASSED();
+}
+
+void test_slot_table_growth() {
+  PRINT_TEST_START("slot table grows past max_events and releases idle segments");
+  enum { N = 3000 };
+  atomic_int count;
+  atomic_init(&count, 0);
+  void count_cb(uevent_t * ev, int fd, short event, void *arg) { atomic_fetch_add((atomic_int *)arg, 1); }
+
+  uevent_base_t *base = uevent_base_new_with_workers(4, 0);
+  assert(base != NULL);
+  static uev_t *uevs[N];
+
+  for (int round = 0; round < 2; round++) {
+    atomic_store(&count, 0);
+    for (int i = 0; i < N; i++) {
+      uevs[i] = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, count_cb, &count, "grow");
+      assert(uevs[i] != NULL);
+      assert(uevent_add(uevs[i], 1 + i % 5) == UEV_ERR_OK);
+    }
+    uevent_base_dispatch(base);
+    PRINT_TEST_INFO("round=%d fired=%d of %d", round, atomic_load(&count), N);
+    assert(atomic_load(&count) == N);
+
+    for (int i = 0; i < N; i++) uevent_free(uevs[i]);
+    // указатели на освобожденные слоты остаются безопасными, даже если страницы сегмента отданы
+    for (int i = 0; i < N; i++) assert(!uevent_is_alive(uevs[i]));
+  }
+
+  uevent_deinit(base);
+  PRINT_TEST_PASSED();
+}
+
+void test_base_group() {
+  PRINT_TEST_START("base group: per-loop threads, fd placement and posting to a loop");
+  enum { LOOPS = 3,
+         POSTS = 100 };
+  uevent_base_group_args_t args = {.num_loops = LOOPS, .pin_cpus = true, .policy = UEV_PLACE_ROUND_ROBIN};
+  uevent_base_group_t *group = uevent_base_group_new(&args);
+  assert(group != NULL);
+  assert(uevent_base_group_size(group) == LOOPS);
+  assert(uevent_base_group_get(group, LOOPS) == NULL);
+
+  // round-robin обходит циклы по кругу
+  for (int i = 0; i < 2 * LOOPS; i++) {
+    assert(uevent_base_group_pick(group, i) == uevent_base_group_get(group, i % LOOPS));
+  }
+  assert(uevent_base_group_start(group) == UEV_ERR_OK);
+  assert(uevent_base_group_start(group) == UEV_ERR_BUSY);
+
+  // задачи цикла выполняются в его потоке и в порядке постановки
+  pthread_t loop_thread[LOOPS];
+  unsigned long loop_mask[LOOPS] = {0};
+  atomic_int done[LOOPS];
+  atomic_int order_errors;
+  int last_seq[LOOPS];
+  atomic_init(&order_errors, 0);
+  for (int i = 0; i < LOOPS; i++) {
+    atomic_init(&done[i], 0);
+    last_seq[i] = -1;
+  }
+  typedef struct {
+    int loop;
+    int seq;
+  } post_arg_t;
+  static post_arg_t post_args[LOOPS][POSTS];
+
+  void post_fn(void *arg) {
+    post_arg_t *pa = arg;
+    if (pa->seq == 0) {
+      loop_thread[pa->loop] = pthread_self();
+      assert(syscall(SYS_sched_getaffinity, 0, sizeof(loop_mask[pa->loop]), &loop_mask[pa->loop]) > 0);
+    } else if (!pthread_equal(loop_thread[pa->loop], pthread_self())) {
+      atomic_fetch_add(&order_errors, 1);
+    }
+    if (pa->seq != last_seq[pa->loop] + 1) atomic_fetch_add(&order_errors, 1);
+    last_seq[pa->loop] = pa->seq;
+    atomic_fetch_add(&done[pa->loop], 1);
+  }
+
+  for (int seq = 0; seq < POSTS; seq++) {
+    for (int i = 0; i < LOOPS; i++) {
+      post_args[i][seq] = (post_arg_t){.loop = i, .seq = seq};
+      assert(uevent_base_group_post(group, i, post_fn, &post_args[i][seq]) == UEV_ERR_OK);
+    }
+  }
+  assert(uevent_base_group_post(group, LOOPS, post_fn, NULL) == UEV_ERR_INVAL);
+
+  uint64_t start = tu_clock_gettime_monotonic_ms();
+  for (int i = 0; i < LOOPS; i++) {
+    while (atomic_load(&done[i]) < POSTS && tu_clock_gettime_monotonic_ms() - start < 2000) msleep(1);
+    assert(atomic_load(&done[i]) == POSTS);
+  }
+  assert(atomic_load(&order_errors) == 0);
+  for (int i = 0; i < LOOPS; i++) {
+    assert(!pthread_equal(loop_thread[i], pthread_self()));
+    for (int j = i + 1; j < LOOPS; j++) assert(!pthread_equal(loop_thread[i], loop_thread[j]));
+    // pin_cpus задает loop_placement базы: поток цикла на одном CPU
+    assert(__builtin_popcountl(loop_mask[i]) == 1);
+  }
+
+  // fd, поставленный на выбранный цикл, обслуживается этим циклом
+  int pipefd[2];
+  assert(pipe(pipefd) == 0);
+  atomic_int read_fired;
+  atomic_init(&read_fired, 0);
+  void read_cb(uevent_t * ev, int fd, short event, void *arg) {
+    char c;
+    (void)read(fd, &c, 1);
+    atomic_fetch_add(&read_fired, 1);
+  }
+  uevent_base_t *base = uevent_base_group_pick(group, pipefd[0]);
+  uev_t *rd = uevent_create_or_assign_event(NULL, base, pipefd[0], UEV_READ | UEV_PERSIST, read_cb, NULL, "group_read");
+  assert(rd != NULL);
+  assert(uevent_add(rd, 0) == UEV_ERR_OK);
+  assert(write(pipefd[1], "x", 1) == 1);
+  start = tu_clock_gettime_monotonic_ms();
+  while (atomic_load(&read_fired) == 0 && tu_clock_gettime_monotonic_ms() - start < 2000) msleep(1);
+  assert(atomic_load(&read_fired) == 1);
+
+  uevent_base_group_stop(group);
+  uevent_free(rd);
+  close(pipefd[0]);
+  close(pipefd[1]);
+  uevent_base_group_free(group);
+
+  // least-loaded уводит новые fd с нагруженного цикла, fd-hash стабилен
+  // pin_cpus и CPU в loop_placement — две привязки одного потока
+  int cpu0 = 0;
+  uevent_thread_placement_t place = {.cpus = &cpu0, .ncpus = 1};
+  args.base_args.loop_placement = &place;
+  assert(uevent_base_group_new(&args) == NULL);
+  args.base_args.loop_placement = NULL;
+
+  args.policy = UEV_PLACE_LEAST_LOADED;
+  args.pin_cpus = false;
+  group = uevent_base_group_new(&args);
+  assert(group != NULL);
+  uev_t *busy = uevent_create_or_assign_event(NULL, uevent_base_group_get(group, 0), -1, UEV_TIMEOUT, read_cb, NULL, "busy");
+  assert(uevent_add(busy, 60000) == UEV_ERR_OK);
+  assert(uevent_base_group_pick(group, -1) != uevent_base_group_get(group, 0));
+  uevent_free(busy);
+  uevent_base_group_free(group);
+
+  args.policy = UEV_PLACE_FD_HASH;
+  group = uevent_base_group_new(&args);
+  assert(group != NULL);
+  assert(uevent_base_group_pick(group, -1) == NULL);
+  for (int fd = 0; fd < 16; fd++) assert(uevent_base_group_pick(group, fd) == uevent_base_group_pick(group, fd));
+  uevent_base_group_free(group);
+  PRINT_TEST_PASSED();
+}
+
+void test_io_uring_backend() {
+  PRINT_TEST_START("io_uring backend: fd ping-pong, mask change and timers");
+  uevent_base_args_t args = {.max_events = 64, .io_backend = UEV_IO_URING};
+  uevent_base_t *base = uevent_base_new_with_args(&args);
+  assert(base != NULL);
+  // без io_uring в ядре база откатывается на epoll, поведение должно совпадать
+  PRINT_TEST_INFO("backend=%s", uevent_base_io_backend(base) == UEV_IO_URING ? "io_uring" : "epoll (fallback)");
+
+  enum { ROUNDS = 1000 };
+  int a[2], b[2];
+  assert(pipe(a) == 0 && pipe(b) == 0);
+  int rounds = 0;
+  int timer_fired = 0;
+  uev_t *ra, *rb, *tm;
+
+  // эхо: все, что пришло в a, уходит в b
+  void echo_cb(uevent_t * ev, int fd, short event, void *arg) {
+    char c;
+    while (read(fd, &c, 1) == 1) assert(write(b[1], &c, 1) == 1);
+  }
+  void pong_cb(uevent_t * ev, int fd, short event, void *arg) {
+    char c;
+    while (read(fd, &c, 1) == 1) {
+      if (++rounds < ROUNDS) {
+        assert(write(a[1], &c, 1) == 1);
+      } else {
+        uevent_del(ra);
+        uevent_del(rb);
+      }
+    }
+  }
+  void timer_cb(uevent_t * ev, int fd, short event, void *arg) { timer_fired++; }
+
+  assert(fcntl(a[0], F_SETFL, O_NONBLOCK) == 0 && fcntl(b[0], F_SETFL, O_NONBLOCK) == 0);
+  ra = uevent_create_or_assign_event(NULL, base, a[0], UEV_READ | UEV_PERSIST, echo_cb, NULL, "uring_echo");
+  rb = uevent_create_or_assign_event(NULL, base, b[0], UEV_READ | UEV_PERSIST, pong_cb, NULL, "uring_pong");
+  tm = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, timer_cb, NULL, "uring_timer");
+  assert(ra && rb && tm);
+  assert(uevent_add(ra, 0) == UEV_ERR_OK);
+  // повторный add активного fd меняет регистрацию и не должен ее дублировать
+  assert(uevent_add(ra, 0) == UEV_ERR_OK);
+  assert(uevent_add(rb, 0) == UEV_ERR_OK);
+  assert(uevent_add(tm, 20) == UEV_ERR_OK);
+  assert(write(a[1], "p", 1) == 1);
+
+  uint64_t start = tu_clock_gettime_monotonic_ms();
+  uevent_base_dispatch(base);
+  PRINT_TEST_INFO("rounds=%d timer_fired=%d elapsed_ms=%" PRIu64, rounds, timer_fired, tu_clock_gettime_monotonic_ms() - start);
+  assert(rounds == ROUNDS);
+  assert(timer_fired == 1);
+  assert(!uevent_pending(ra, UEV_READ) && !uevent_pending(rb, UEV_READ));
+
+  uevent_free(ra);
+  uevent_free(rb);
+  uevent_free(tm);
+  uevent_deinit(base);
+  close(a[0]);
+  close(a[1]);
+  close(b[0]);
+  close(b[1]);
+  PRINT_TEST_PASSED();
+}
+
+void test_callback_stats() {
+  PRINT_TEST_START("per-name callback lag and duration histograms");
+  uevent_base_args_t args = {.max_events = 16, .stats = true};
+  uevent_base_t *base = uevent_base_new_with_args(&args);
+  assert(base != NULL);
+
+  enum { FIRES = 10 };
+  int fired = 0;
+  int pipefd[2];
+  assert(pipe(pipefd) == 0);
+
+  void slow_cb(uevent_t * ev, int fd, short event, void *arg) {
+    usleep(2000);
+    if (++fired >= FIRES) uevent_del(ev->uev);
+  }
+  void fd_cb(uevent_t * ev, int fd, short event, void *arg) {
+    char c;
+    assert(read(fd, &c, 1) == 1);
+  }
+  uev_t *slow = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT | UEV_PERSIST, slow_cb, NULL, "stats_slow");
+  uev_t *rd = uevent_create_or_assign_event(NULL, base, pipefd[0], UEV_READ, fd_cb, NULL, "stats_fd");
+  assert(slow && rd);
+  uevent_set_timeout(slow, 5);
+  uevent_add_with_current_timeout(slow);
+  assert(uevent_add(rd, 0) == UEV_ERR_OK);
+  assert(write(pipefd[1], "x", 1) == 1);
+  uevent_base_dispatch(base);
+  assert(fired == FIRES);
+
+  uevent_stat_t st[8];
+  int n = uevent_base_stats_snapshot(base, st, 8);
+  assert(n == 2);
+  assert(uevent_base_stats_snapshot(base, NULL, 0) == n);
+  uevent_stat_t *s_slow = NULL, *s_fd = NULL;
+  for (int i = 0; i < n; i++) {
+    PRINT_TEST_INFO("name=%s count=%" PRIu64 " lag p50/p99/max=%" PRIu64 "/%" PRIu64 "/%" PRIu64 "us dur p50/p99/max=%" PRIu64 "/%" PRIu64 "/%" PRIu64 "us",
+                    st[i].name, st[i].count, st[i].lag_p50_us, st[i].lag_p99_us, st[i].lag_max_us,
+                    st[i].duration_p50_us, st[i].duration_p99_us, st[i].duration_max_us);
+    if (strcmp(st[i].name, "stats_slow") == 0) s_slow = &st[i];
+    if (strcmp(st[i].name, "stats_fd") == 0) s_fd = &st[i];
+  }
+  assert(s_slow && s_fd);
+  assert(s_slow->count == FIRES && s_slow->lag_count == FIRES);
+  assert(s_slow->duration_max_us >= 2000);
+  assert(s_slow->duration_p50_us >= 1500 && s_slow->duration_p50_us <= s_slow->duration_p99_us);
+  assert(s_slow->duration_p99_us <= s_slow->duration_max_us);
+  // у fd-событий нет планового времени, задержка не считается
+  assert(s_fd->count == 1 && s_fd->lag_count == 0 && s_fd->lag_max_us == 0);
+
+  uevent_free(slow);
+  uevent_free(rd);
+  uevent_deinit(base);
+  close(pipefd[0]);
+  close(pipefd[1]);
+
+  // без args.stats снимок пустой
+  base = uevent_base_new(16);
+  assert(base != NULL);
+  assert(uevent_base_stats_snapshot(base, st, 8) == 0);
+  uevent_deinit(base);
+
+  // hires_timers: плановое время в мс сравнивается с наносекундными часами в одних единицах,
+  // а задержка в очереди воркеров не дает WORKER_LAG
+  uevent_base_args_t hargs = {.max_events = 16, .num_workers = 2, .stats = true, .hires_timers = true};
+  base = uevent_base_new_with_args(&hargs);
+  assert(base != NULL);
+  atomic_int hfired;
+  atomic_init(&hfired, 0);
+  void hires_cb(uevent_t * ev, int fd, short event, void *arg) { atomic_fetch_add(&hfired, 1); }
+  uev_t *ht = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, hires_cb, NULL, "stats_hires");
+  assert(ht != NULL);
+  int saved_out;
+  int log_fd = log_capture_begin(&saved_out);
+  for (int i = 0; i < FIRES; i++) {
+    assert(uevent_add(ht, 1) == UEV_ERR_OK);
+    uevent_base_dispatch(base);
+    while (atomic_load(&hfired) <= i) msleep(1);
+  }
+  assert(!log_capture_end(log_fd, saved_out, "[WORKER_LAG]"));
+  assert(uevent_base_stats_snapshot(base, st, 8) == 1);
+  PRINT_TEST_INFO("hires lag p50/max=%" PRIu64 "/%" PRIu64 "us", st[0].lag_p50_us, st[0].lag_max_us);
+  assert(st[0].lag_count == FIRES && st[0].lag_max_us < 1000000);
+  uevent_free(ht);
+  uevent_deinit(base);
+  PRINT_TEST_PASSED();
+}
+
+void test_stream() {
+  PRINT_TEST_START("buffered stream: bulk write, watermark echo and half-close");
+  // поток не потокобезопасен, колбэки идут в потоке цикла
+  uevent_base_t *base = uevent_base_new_with_workers(16, 0);
+  assert(base != NULL);
+  int sv[2];
+  assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+  assert(fcntl(sv[0], F_SETFL, O_NONBLOCK) == 0 && fcntl(sv[1], F_SETFL, O_NONBLOCK) == 0);
+
+  // 1. запись больше буфера сокета: остаток уходит по готовности, write_cb — после опустошения
+  enum { BULK = 4 * 1024 * 1024 };
+  char *bulk = malloc(BULK);
+  assert(bulk != NULL);
+  for (int i = 0; i < BULK; i++) bulk[i] = (char)(i % 251);
+  size_t peer_got = 0;
+  int write_cb_calls = 0;
+  uev_t *peer;
+
+  void bulk_write_cb(uevent_stream_t * st, void *arg) {
+    write_cb_calls++;
+    assert(uevent_stream_output_len(st) == 0);
+  }
+  void peer_read_cb(uevent_t * ev, int fd, short event, void *arg) {
+    char buf[65536];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+      for (ssize_t i = 0; i < n; i++) assert(buf[i] == (char)((peer_got + (size_t)i) % 251));
+      peer_got += (size_t)n;
+    }
+    if (peer_got == BULK) uevent_del(peer);
+  }
+
+  uevent_stream_t *s = uevent_stream_new(base, sv[0], NULL, bulk_write_cb, NULL, NULL, "stream_bulk");
+  assert(s != NULL);
+  assert(uevent_stream_write(s, bulk, BULK) == UEV_ERR_OK);
+  PRINT_TEST_INFO("queued after first writev: %zu", uevent_stream_output_len(s));
+  assert(uevent_stream_output_len(s) > 0);
+  uevent_stream_set_watermarks(s, 0, 0, 0, 1024);
+  // выше write_high запись отклоняется, данные остаются за приложением
+  assert(uevent_stream_write(s, "x", 1) == UEV_ERR_BUSY);
+  peer = uevent_create_or_assign_event(NULL, base, sv[1], UEV_READ | UEV_PERSIST, peer_read_cb, NULL, "stream_peer");
+  assert(peer != NULL && uevent_add(peer, 0) == UEV_ERR_OK);
+  uevent_base_dispatch(base);
+  assert(peer_got == BULK);
+  assert(write_cb_calls == 1);
+  assert(uevent_stream_output_len(s) == 0);
+  uevent_free(peer);
+  uevent_stream_free(s);
+
+  // 2. эхо с отметками: вход ограничен read_high, выход — write_high, поток сам переключает интерес
+  enum { TOTAL = 2 * 1024 * 1024 };
+  size_t sent = 0, echoed = 0;
+  int hup = 0, max_iov = 0;
+  size_t max_input = 0;
+
+  void pump(uevent_stream_t * st) {
+    struct iovec iov[8];
+    int n;
+    while ((n = uevent_stream_peek(st, iov, 8)) > 0) {
+      if (n > max_iov) max_iov = n;
+      if (uevent_stream_write(st, iov[0].iov_base, iov[0].iov_len) != UEV_ERR_OK) break;
+      uevent_stream_consume(st, iov[0].iov_len);
+    }
+  }
+  void echo_read_cb(uevent_stream_t * st, void *arg) {
+    if (uevent_stream_input_len(st) > max_input) max_input = uevent_stream_input_len(st);
+    pump(st);
+  }
+  void echo_write_cb(uevent_stream_t * st, void *arg) {
+    pump(st);
+    if (hup && uevent_stream_input_len(st) == 0 && uevent_stream_output_len(st) == 0) uevent_stream_free(st);
+  }
+  void echo_event_cb(uevent_stream_t * st, short what, void *arg) {
+    assert(what == UEV_HUP);
+    hup++;
+    pump(st);
+    if (uevent_stream_output_len(st) == 0) uevent_stream_free(st);
+  }
+  void peer_cb(uevent_t * ev, int fd, short event, void *arg) {
+    if ((event & UEV_WRITE) && sent < TOTAL) {
+      ssize_t n;
+      while (sent < TOTAL && (n = write(fd, bulk + sent % 251, TOTAL - sent < 65536 ? TOTAL - sent : 65536)) > 0) sent += (size_t)n;
+      if (sent == TOTAL) {
+        assert(shutdown(fd, SHUT_WR) == 0);
+        assert(uevent_set_fd_events(ev->uev, UEV_READ) == UEV_ERR_OK);
+      }
+    }
+    if (event & UEV_READ) {
+      char buf[65536];
+      ssize_t n;
+      while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        for (ssize_t i = 0; i < n; i++) assert(buf[i] == (char)((echoed + (size_t)i) % 251));
+        echoed += (size_t)n;
+      }
+      if (echoed == TOTAL) uevent_del(ev->uev);
+    }
+  }
+
+  s = uevent_stream_new(base, sv[0], echo_read_cb, echo_write_cb, echo_event_cb, NULL, "stream_echo");
+  assert(s != NULL);
+  uevent_stream_set_watermarks(s, 0, 64 * 1024, 16 * 1024, 128 * 1024);
+  assert(uevent_stream_enable(s) == UEV_ERR_OK);
+  peer = uevent_create_or_assign_event(NULL, base, sv[1], UEV_READ | UEV_WRITE | UEV_PERSIST, peer_cb, NULL, "stream_echo_peer");
+  assert(peer != NULL && uevent_add(peer, 0) == UEV_ERR_OK);
+  uevent_base_dispatch(base);
+  PRINT_TEST_INFO("sent=%zu echoed=%zu max_input=%zu max_iov=%d hup=%d", sent, echoed, max_input, max_iov, hup);
+  assert(sent == TOTAL && echoed == TOTAL);
+  assert(hup == 1);
+  // чтение останавливается у read_high, с запасом на один readv в два сегмента
+  assert(max_input < 64 * 1024 + 2 * 16384);
+
+  uevent_free(peer);
+  uevent_deinit(base);
+  close(sv[0]);
+  close(sv[1]);
+  free(bulk);
+  PRINT_TEST_PASSED();
+}
+
+void test_signal_child_events() {
+  PRINT_TEST_START("signalfd and pidfd events: coalesced signals and child exit");
+  uevent_base_t *base = uevent_base_new_with_workers(16, 0);
+  assert(base != NULL);
+  sigset_t old_mask;
+  assert(pthread_sigmask(SIG_SETMASK, NULL, &old_mask) == 0);
+
+  int sig_calls = 0, child_calls = 0, child_status = -1;
+  pid_t pid = -1;
+  uev_t *sig, *child = NULL;
+
+  void child_cb(uevent_t * ev, int fd, short event, void *arg) {
+    assert(event & UEV_CHILD);
+    child_calls++;
+    int st;
+    assert(waitpid(pid, &st, 0) == pid);
+    child_status = WIFEXITED(st) ? WEXITSTATUS(st) : -1;
+    uevent_del(sig);
+  }
+  void sig_cb(uevent_t * ev, int fd, short event, void *arg) {
+    assert(event & UEV_SIGNAL);
+    sig_calls++;
+    pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) _exit(7);
+    child = uevent_child_new(base, pid, child_cb, NULL, "child_exit");
+    assert(child != NULL && uevent_add(child, 0) == UEV_ERR_OK);
+  }
+
+  sig = uevent_signal_new(base, SIGUSR1, sig_cb, NULL, "sigusr1");
+  assert(sig != NULL && uevent_add(sig, 0) == UEV_ERR_OK);
+  // три сигнала до запуска цикла сливаются в один вызов колбэка
+  for (int i = 0; i < 3; i++) assert(raise(SIGUSR1) == 0);
+  uevent_base_dispatch(base);
+  PRINT_TEST_INFO("sig_calls=%d child_calls=%d child_status=%d", sig_calls, child_calls, child_status);
+  assert(sig_calls == 1);
+  assert(child_calls == 1 && child_status == 7);
+  // одноразовое событие pidfd снимается само
+  assert(!uevent_pending(child, UEV_READ));
+
+  uevent_free(sig);
+  uevent_free(child);
+  uevent_deinit(base);
+  assert(pthread_sigmask(SIG_SETMASK, &old_mask, NULL) == 0);
+  PRINT_TEST_PASSED();
+}
+
+void test_post_ring() {
+  PRINT_TEST_START("uevent_post: bounded ring, overflow and cross-thread ordering");
+  uevent_base_args_t args = {.max_events = 16, .post_queue_size = 8};
+  uevent_base_t *base = uevent_base_new_with_args(&args);
+  assert(base != NULL);
+
+  // 1. до запуска цикла: кольцо на 8 ячеек, девятый вызов отклоняется, dispatch выполняет все по порядку
+  int order[8], ran = 0;
+  void seq_fn(void *arg) { order[ran++] = (int)(intptr_t)arg; }
+  for (int i = 0; i < 8; i++) assert(uevent_post(base, seq_fn, (void *)(intptr_t)i) == UEV_ERR_OK);
+  assert(uevent_post(base, seq_fn, NULL) == UEV_ERR_BUSY);
+  assert(uevent_post(base, NULL, NULL) == UEV_ERR_INVAL);
+  uevent_base_dispatch(base);
+  assert(ran == 8);
+  for (int i = 0; i < 8; i++) assert(order[i] == i);
+  uevent_deinit(base);
+
+  // 2. несколько писателей: порядок каждого сохраняется, ничего не теряется
+  enum { PRODUCERS = 4,
+         PER_PRODUCER = 50000 };
+  args.post_queue_size = 0;
+  base = uevent_base_new_with_args(&args);
+  assert(base != NULL);
+  static int next_seq[PRODUCERS];
+  memset(next_seq, 0, sizeof(next_seq));
+  int total = 0, busy = 0;
+  uev_t *keepalive;
+
+  void item_fn(void *arg) {
+    intptr_t v = (intptr_t)arg;
+    int producer = (int)(v / PER_PRODUCER), seq = (int)(v % PER_PRODUCER);
+    assert(seq == next_seq[producer]);
+    next_seq[producer]++;
+    if (++total == PRODUCERS * PER_PRODUCER) uevent_del(keepalive);
+  }
+  void *producer_thread(void *arg) {
+    intptr_t id = (intptr_t)arg;
+    for (intptr_t i = 0; i < PER_PRODUCER; i++) {
+      while (uevent_post(base, item_fn, (void *)(id * PER_PRODUCER + i)) == UEV_ERR_BUSY) {
+        __atomic_fetch_add(&busy, 1, __ATOMIC_RELAXED);
+        sched_yield();
+      }
+    }
+    return NULL;
+  }
+  void keepalive_cb(uevent_t * ev, int fd, short event, void *arg) {}
+
+  keepalive = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT | UEV_PERSIST, keepalive_cb, NULL, "post_keepalive");
+  assert(keepalive != NULL);
+  uevent_set_timeout(keepalive, 1000);
+  uevent_add_with_current_timeout(keepalive);
+
+  pthread_t th[PRODUCERS];
+  uint64_t start = tu_clock_gettime_monotonic_ms();
+  for (intptr_t i = 0; i < PRODUCERS; i++) assert(pthread_create(&th[i], NULL, producer_thread, (void *)i) == 0);
+  uevent_base_dispatch(base);
+  for (int i = 0; i < PRODUCERS; i++) pthread_join(th[i], NULL);
+  PRINT_TEST_INFO("posted=%d busy_retries=%d elapsed_ms=%" PRIu64, total, busy, tu_clock_gettime_monotonic_ms() - start);
+  assert(total == PRODUCERS * PER_PRODUCER);
+  for (int i = 0; i < PRODUCERS; i++) assert(next_seq[i] == PER_PRODUCER);
+
+  uevent_free(keepalive);
+  uevent_deinit(base);
+  PRINT_TEST_PASSED();
+}
+
+void test_busy_poll() {
+  PRINT_TEST_START("adaptive busy-poll: request/response path and idle back-off");
+  uevent_base_args_t args = {.max_events = 16, .busy_poll_us = 200};
+  uevent_base_t *base = uevent_base_new_with_args(&args);
+  assert(base != NULL);
+
+  enum { ROUNDS = 2000 };
+  int sv[2];
+  assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+  assert(fcntl(sv[0], F_SETFL, O_NONBLOCK) == 0);
+  int echoed = 0;
+  uint64_t idle_cpu_start = 0, idle_cpu_ns = 0;
+  uev_t *echo, *idle;
+
+  uint64_t thread_cpu_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+  }
+  void echo_cb(uevent_t * ev, int fd, short event, void *arg) {
+    char c;
+    ssize_t n;
+    while ((n = read(fd, &c, 1)) == 1) {
+      assert(write(fd, &c, 1) == 1);
+      echoed++;
+    }
+    if (n == 0) {
+      // клиент закрылся: дальше цикл простаивает до таймера и не должен крутиться
+      uevent_del(echo);
+      idle_cpu_start = thread_cpu_ns();
+      assert(uevent_add(idle, 300) == UEV_ERR_OK);
+    }
+  }
+  void idle_cb(uevent_t * ev, int fd, short event, void *arg) { idle_cpu_ns = thread_cpu_ns() - idle_cpu_start; }
+  void *client_thread(void *arg) {
+    char c = 'q';
+    for (int i = 0; i < ROUNDS; i++) {
+      assert(write(sv[1], &c, 1) == 1);
+      assert(read(sv[1], &c, 1) == 1);
+    }
+    close(sv[1]);
+    return NULL;
+  }
+
+  echo = uevent_create_or_assign_event(NULL, base, sv[0], UEV_READ | UEV_PERSIST, echo_cb, NULL, "busy_echo");
+  idle = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, idle_cb, NULL, "busy_idle");
+  assert(echo && idle);
+  assert(uevent_add(echo, 0) == UEV_ERR_OK);
+  pthread_t th;
+  uint64_t start = tu_clock_gettime_monotonic_ms();
+  assert(pthread_create(&th, NULL, client_thread, NULL) == 0);
+  uevent_base_dispatch(base);
+  pthread_join(th, NULL);
+  PRINT_TEST_INFO("rounds=%d elapsed_ms=%" PRIu64 " idle_cpu_us=%" PRIu64, echoed, tu_clock_gettime_monotonic_ms() - start, idle_cpu_ns / 1000);
+  assert(echoed == ROUNDS);
+  // 300 мс простоя: опрос без сна длится не дольше окна, дальше цикл спит в epoll_wait
+  assert(idle_cpu_ns < 50 * 1000000ULL);
+
+  uevent_free(echo);
+  uevent_free(idle);
+  uevent_deinit(base);
+  close(sv[0]);
+  PRINT_TEST_PASSED();
+}
+
+void test_state_word_padded_slots() {
+  PRINT_TEST_START("single-word event state and cache-line padded slots");
+  uevent_base_args_t args = {.max_events = 16, .pad_slots = true};
+  uevent_base_t *base = uevent_base_new_with_args(&args);
+  assert(base != NULL);
+
+  enum { N = 600 }; // больше двух сегментов таблицы
+  static uev_t *uevs[N];
+  int fired = 0;
+  void cb(uevent_t * ev, int fd, short event, void *arg) {
+    fired++;
+    // колбэк выполняется под битом блокировки
+    assert(ev->state & UEV_ST_LOCKED);
+  }
+  for (int i = 0; i < N; i++) {
+    uevs[i] = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, cb, NULL, "padded");
+    assert(uevs[i] != NULL);
+    // каждый слот начинается со своей кеш-линии
+    assert(((uintptr_t)uevs[i] & 63) == 0);
+    for (int j = 0; j < i && j < 4; j++) assert((uintptr_t)uevs[i] / 64 != (uintptr_t)uevs[j] / 64);
+  }
+
+  uevent_t *ev = uevs[0]->ev;
+  assert(atomic_load(&ev->state) == 0);
+  assert(uevent_add(uevs[0], 5) == UEV_ERR_OK);
+  assert(ev->state & UEV_ST_ACTIVE_TIMER);
+  assert(uevent_del(uevs[0]) == UEV_ERR_OK);
+  assert(!(ev->state & UEV_ST_ACTIVE_TIMER));
+
+  int pipefd[2];
+  assert(pipe(pipefd) == 0);
+  uev_t *rd = uevent_create_or_assign_event(NULL, base, pipefd[0], UEV_READ | UEV_PERSIST, cb, NULL, "padded_fd");
+  assert(rd != NULL && uevent_add(rd, 0) == UEV_ERR_OK);
+  assert(rd->ev->state & UEV_ST_ACTIVE_FD);
+  assert(uevent_del(rd) == UEV_ERR_OK);
+  assert(!(rd->ev->state & UEV_ST_ACTIVE_FD));
+  uevent_free(rd);
+
+  for (int i = 0; i < N; i++) assert(uevent_add(uevs[i], 1 + i % 10) == UEV_ERR_OK);
+  uevent_base_dispatch(base);
+  assert(fired == N);
+  for (int i = 0; i < N; i++) uevent_free(uevs[i]);
+  uevent_deinit(base);
+  close(pipefd[0]);
+  close(pipefd[1]);
+  PRINT_TEST_PASSED();
+}
+
+void test_base_now() {
+  PRINT_TEST_START("cached loop clock: uevent_base_now and timers added from the loop");
+  uevent_base_t *base = uevent_base_new_with_workers(16, 0);
+  assert(base != NULL);
+
+  int fired = 0;
+  uint64_t armed_at = 0, fired_at = 0;
+  uev_t *first, *second;
+  void first_cb(uevent_t * ev, int fd, short event, void *arg) {
+    uint64_t now = uevent_base_now(base);
+    assert(now != 0);
+    uint64_t real = tu_clock_gettime_monotonic_ms();
+    assert(real >= now && real - now < 1000);
+    // часы итерации не двигаются внутри колбэка
+    usleep(20000);
+    assert(uevent_base_now(base) == now);
+    uevent_base_update_time(base);
+    assert(uevent_base_now(base) >= now + 20);
+    armed_at = uevent_base_now(base);
+    assert(uevent_add(second, 30) == UEV_ERR_OK);
+    fired++;
+  }
+  void second_cb(uevent_t * ev, int fd, short event, void *arg) {
+    fired_at = uevent_base_now(base);
+    fired++;
+  }
+
+  first = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, first_cb, NULL, "now_first");
+  second = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, second_cb, NULL, "now_second");
+  assert(first && second);
+  assert(uevent_add(first, 10) == UEV_ERR_OK);
+  uevent_base_dispatch(base);
+  PRINT_TEST_INFO("armed_at=%" PRIu64 " fired_at=%" PRIu64, armed_at, fired_at);
+  assert(fired == 2);
+  // таймер из цикла отсчитан от времени итерации и не срабатывает раньше него
+  assert(fired_at >= armed_at + 30);
+
+  uevent_free(first);
+  uevent_free(second);
+  uevent_deinit(base);
+  PRINT_TEST_PASSED();
+}
+
+void test_virtual_clock() {
+  PRINT_TEST_START("virtual clock: a day of timers without sleeping, pluggable time source");
+  for (int backend = UEV_TIMER_HEAP; backend <= UEV_TIMER_WHEEL; backend++) {
+    uevent_base_args_t args = {.max_events = 16, .timer_backend = backend, .virtual_clock = true};
+    uevent_base_t *base = uevent_base_new_with_args(&args);
+    assert(base != NULL);
+
+    enum { HOUR_MS = 3600 * 1000, HOURS = 24 };
+    int hourly = 0, once = 0;
+    uint64_t start_vt = uevent_base_now(base);
+    uev_t *hour, *backoff[2];
+    void hour_cb(uevent_t * ev, int fd, short event, void *arg) {
+      hourly++;
+      assert(uevent_base_now(base) == start_vt + (uint64_t)hourly * HOUR_MS);
+      if (hourly == HOURS) uevent_del(hour);
+    }
+    void backoff_cb(uevent_t * ev, int fd, short event, void *arg) {
+      // экспоненциальный откат 1, 2, 4 ... секунд, пара событий взводит друг друга
+      once++;
+      if (once < 16) assert(uevent_add(backoff[once % 2], 1000 << once) == UEV_ERR_OK);
+    }
+
+    hour = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT | UEV_PERSIST, hour_cb, NULL, "vclock_hour");
+    backoff[0] = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, backoff_cb, NULL, "vclock_backoff");
+    backoff[1] = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, backoff_cb, NULL, "vclock_backoff");
+    assert(hour && backoff[0] && backoff[1]);
+    uevent_set_timeout(hour, HOUR_MS);
+    uevent_add_with_current_timeout(hour);
+    assert(uevent_add(backoff[0], 1000) == UEV_ERR_OK);
+
+    uint64_t wall = tu_clock_gettime_monotonic_ms();
+    uevent_base_dispatch(base);
+    wall = tu_clock_gettime_monotonic_ms() - wall;
+    PRINT_TEST_INFO("backend=%s virtual_ms=%" PRIu64 " wall_ms=%" PRIu64, backend == UEV_TIMER_WHEEL ? "wheel" : "heap",
+                    uevent_base_now(base) - start_vt, wall);
+    assert(hourly == HOURS);
+    assert(once == 16);
+    assert(wall < 5000);
+
+    uevent_free(hour);
+    uevent_free(backoff[0]);
+    uevent_free(backoff[1]);
+    uevent_deinit(base);
+  }
+
+  // пользовательский источник времени без виртуального режима
+  uint64_t fake_ms = 123456;
+  uint64_t fake_clock(void *arg) { return *(uint64_t *)arg; }
+  uevent_base_args_t args = {.max_events = 16, .clock_fn = fake_clock, .clock_arg = &fake_ms};
+  uevent_base_t *base = uevent_base_new_with_args(&args);
+  assert(base != NULL);
+  assert(uevent_base_now(base) == 123456);
+  fake_ms += 500;
+  uevent_base_update_time(base);
+  assert(uevent_base_now(base) == 123956);
+  uevent_deinit(base);
+  PRINT_TEST_PASSED();
+}
+
+void test_listener_group() {
+  PRINT_TEST_START("listener: batched accept across a base group with EPOLLEXCLUSIVE and SO_REUSEPORT");
+  enum { LOOPS = 2,
+         CONNS = 200 };
+  uevent_base_group_args_t args = {.num_loops = LOOPS};
+  uevent_base_group_t *group = uevent_base_group_new(&args);
+  assert(group != NULL);
+  assert(uevent_base_group_start(group) == UEV_ERR_OK);
+
+  atomic_int accepted;
+  atomic_init(&accepted, 0);
+  void accept_cb(uevent_listener_t * l, int fd, const struct sockaddr *addr, socklen_t addrlen, void *arg) {
+    assert(fd >= 0 && addr->sa_family == AF_INET);
+    assert(fcntl(fd, F_GETFL) & O_NONBLOCK);
+    close(fd);
+    atomic_fetch_add(&accepted, 1);
+  }
+  void connect_all(const struct sockaddr_in *sin, int expect) {
+    for (int i = 0; i < CONNS; i++) {
+      int c = socket(AF_INET, SOCK_STREAM, 0);
+      assert(c >= 0);
+      assert(connect(c, (const struct sockaddr *)sin, sizeof(*sin)) == 0);
+      close(c);
+    }
+    uint64_t start = tu_clock_gettime_monotonic_ms();
+    while (atomic_load(&accepted) < expect && tu_clock_gettime_monotonic_ms() - start < 3000) msleep(1);
+    assert(atomic_load(&accepted) == expect);
+  }
+
+  // общий сокет: каждый цикл ждет его с EPOLLEXCLUSIVE, соединения могут уйти одному циклу
+  struct sockaddr_in sin = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+  int lfd = uevent_listen_reuseport((struct sockaddr *)&sin, sizeof(sin), 256);
+  assert(lfd >= 0);
+  socklen_t len = sizeof(sin);
+  assert(getsockname(lfd, (struct sockaddr *)&sin, &len) == 0);
+  uevent_listener_t *shared[LOOPS];
+  assert(uevent_base_group_listen(group, lfd, accept_cb, NULL, "listen_excl", shared) == UEV_ERR_OK);
+  connect_all(&sin, CONNS);
+  unsigned long sum = 0;
+  for (int i = 0; i < LOOPS; i++) {
+    assert(uevent_listener_fd(shared[i]) == lfd);
+    assert(uevent_listener_base(shared[i]) == uevent_base_group_get(group, i));
+    sum += uevent_listener_accepted(shared[i]);
+  }
+  PRINT_TEST_INFO("exclusive: loop0=%lu loop1=%lu", uevent_listener_accepted(shared[0]), uevent_listener_accepted(shared[1]));
+  assert(sum == CONNS);
+
+  // SO_REUSEPORT: по своему сокету на цикл, на тот же порт
+  uevent_listener_t *ports[LOOPS];
+  assert(uevent_base_group_listen_reuseport(group, (struct sockaddr *)&sin, sizeof(sin), 256, accept_cb, NULL, "listen_port", ports) == UEV_ERR_OK);
+  // общий сокет тоже держит порт: закрываем его, чтобы ядро делило соединения только между новыми
+  uevent_base_group_stop(group);
+  for (int i = 0; i < LOOPS; i++) uevent_listener_free(shared[i]);
+  close(lfd);
+  assert(uevent_base_group_start(group) == UEV_ERR_OK);
+  atomic_store(&accepted, 0);
+  connect_all(&sin, CONNS);
+  sum = 0;
+  for (int i = 0; i < LOOPS; i++) {
+    assert(uevent_listener_fd(ports[i]) != lfd);
+    sum += uevent_listener_accepted(ports[i]);
+  }
+  PRINT_TEST_INFO("reuseport: loop0=%lu loop1=%lu", uevent_listener_accepted(ports[0]), uevent_listener_accepted(ports[1]));
+  assert(sum == CONNS);
+
+  uevent_base_group_stop(group);
+  for (int i = 0; i < LOOPS; i++) uevent_listener_free(ports[i]);
+  uevent_base_group_free(group);
+
+  // EMFILE: ждущие соединения сбрасываются через запасной дескриптор, слушатель не глохнет
+  enum { SHED = 3 };
+  uevent_base_t *base = uevent_base_new(16);
+  assert(base != NULL);
+  sin.sin_port = 0;
+  lfd = uevent_listen_reuseport((struct sockaddr *)&sin, sizeof(sin), 16);
+  assert(lfd >= 0);
+  len = sizeof(sin);
+  assert(getsockname(lfd, (struct sockaddr *)&sin, &len) == 0);
+  atomic_store(&accepted, 0);
+  uevent_listener_t *l = uevent_listener_new(base, lfd, accept_cb, NULL, "listen_emfile");
+  assert(l != NULL && uevent_listener_enable(l) == UEV_ERR_OK);
+  void stop_cb(uevent_t * ev, int fd, short events, void *arg) { uevent_base_loopbreak(arg); }
+  uev_t *stop = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, stop_cb, base, "listen_emfile_stop");
+  assert(stop != NULL);
+  int clients[SHED + 1];
+  for (int i = 0; i <= SHED; i++) {
+    clients[i] = socket(AF_INET, SOCK_STREAM, 0);
+    assert(clients[i] >= 0);
+    struct timeval tv = {.tv_sec = 1};
+    assert(setsockopt(clients[i], SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) == 0);
+  }
+  for (int i = 0; i < SHED; i++) assert(connect(clients[i], (struct sockaddr *)&sin, sizeof(sin)) == 0);
+  // новый дескриптор получит номер не меньше наименьшего свободного: лимит на нем
+  struct rlimit old_rl, rl;
+  assert(getrlimit(RLIMIT_NOFILE, &old_rl) == 0);
+  int free_fd = dup(0);
+  assert(free_fd >= 0);
+  close(free_fd);
+  rl = old_rl;
+  rl.rlim_cur = (rlim_t)free_fd;
+  assert(setrlimit(RLIMIT_NOFILE, &rl) == 0);
+  assert(uevent_add(stop, 100) == UEV_ERR_OK);
+  uevent_base_dispatch(base);
+  assert(setrlimit(RLIMIT_NOFILE, &old_rl) == 0);
+  assert(atomic_load(&accepted) == 0);
+  for (int i = 0; i < SHED; i++) {
+    char c;
+    assert(read(clients[i], &c, 1) == 0);
+    close(clients[i]);
+  }
+  // дескрипторы вернулись: следующее соединение доходит до колбэка
+  assert(connect(clients[SHED], (struct sockaddr *)&sin, sizeof(sin)) == 0);
+  assert(uevent_add(stop, 100) == UEV_ERR_OK);
+  uevent_base_dispatch(base);
+  assert(atomic_load(&accepted) == 1);
+  assert(uevent_listener_accepted(l) == 1);
+  close(clients[SHED]);
+  uevent_free(stop);
+  uevent_listener_free(l);
+  close(lfd);
+  uevent_deinit(base);
+  PRINT_TEST_PASSED();
+}
+
+void test_priorities() {
+  PRINT_TEST_START("priorities: level 0 first, lower levels limited by a per-iteration budget");
+  uevent_base_args_t args = {.max_events = 16, .priorities = 2, .prio_budget = 1};
+  uevent_base_t *base = uevent_base_new_with_args(&args);
+  assert(base != NULL);
+
+  enum { LOW = 3 };
+  int order[8], n = 0;
+  int hi_pipe[2], lo_pipe[LOW][2];
+  uev_t *hi, *lo[LOW];
+  void hi_cb(uevent_t * ev, int fd, short event, void *arg) {
+    char c;
+    while (read(fd, &c, 1) == 1) {}
+    order[n++] = 0;
+  }
+  void lo_cb(uevent_t * ev, int fd, short event, void *arg) {
+    char c;
+    while (read(fd, &c, 1) == 1) {}
+    order[n++] = 1;
+    // первый младший будит старший: тот обгоняет младших, отложенных бюджетом
+    if (n == 2) assert(write(hi_pipe[1], "h", 1) == 1);
+    if (n == LOW + 2) uevent_base_loopbreak(base);
+  }
+
+  assert(pipe(hi_pipe) == 0 && fcntl(hi_pipe[0], F_SETFL, O_NONBLOCK) == 0);
+  hi = uevent_create_or_assign_event(NULL, base, hi_pipe[0], UEV_READ | UEV_PERSIST, hi_cb, NULL, "prio_hi");
+  assert(hi != NULL);
+  assert(uevent_set_priority(hi, 0) == UEV_ERR_OK);
+  assert(uevent_set_priority(hi, 2) == UEV_ERR_INVAL);
+  for (int i = 0; i < LOW; i++) {
+    assert(pipe(lo_pipe[i]) == 0 && fcntl(lo_pipe[i][0], F_SETFL, O_NONBLOCK) == 0);
+    lo[i] = uevent_create_or_assign_event(NULL, base, lo_pipe[i][0], UEV_READ | UEV_PERSIST, lo_cb, NULL, "prio_lo");
+    assert(lo[i] != NULL);
+    assert(uevent_set_priority(lo[i], 1) == UEV_ERR_OK);
+    assert(uevent_add(lo[i], 0) == UEV_ERR_OK);
+    assert(write(lo_pipe[i][1], "l", 1) == 1);
+  }
+  assert(uevent_add(hi, 0) == UEV_ERR_OK);
+  assert(write(hi_pipe[1], "h", 1) == 1);
+
+  uevent_base_dispatch(base);
+  // без бюджета было бы 0 1 1 1 0
+  const int expect[] = {0, 1, 0, 1, 1};
+  assert(n == LOW + 2);
+  for (int i = 0; i < n; i++) assert(order[i] == expect[i]);
+
+  uevent_free(hi);
+  close(hi_pipe[0]);
+  close(hi_pipe[1]);
+  for (int i = 0; i < LOW; i++) {
+    uevent_free(lo[i]);
+    close(lo_pipe[i][0]);
+    close(lo_pipe[i][1]);
+  }
+  uevent_deinit(base);
+
+  // база без приоритетов принимает только уровень 0
+  uevent_base_args_t plain = {.max_events = 16};
+  base = uevent_base_new_with_args(&plain);
+  assert(base != NULL);
+  uev_t *t = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, hi_cb, NULL, "prio_plain");
+  assert(t != NULL);
+  assert(uevent_set_priority(t, 0) == UEV_ERR_OK);
+  assert(uevent_set_priority(t, 1) == UEV_ERR_INVAL);
+  uevent_free(t);
+  uevent_deinit(base);
+  PRINT_TEST_PASSED();
+}
+
+void test_event_handles() {
+  PRINT_TEST_START("generation handles: stale after free and slot reuse, reuse deferred to iteration end");
+  enum { N = 768 };
+  uevent_base_t *base = uevent_base_new_with_workers(16, 0);
+  assert(base != NULL);
+  void nop_cb(uevent_t * ev, int fd, short event, void *arg) {}
+
+  uev_t *a = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, nop_cb, NULL, "handle_a");
+  assert(a != NULL);
+  uev_handle_t ha = uevent_handle(a);
+  uev_t *got = uevent_handle_get(base, ha);
+  assert(ha != 0 && got == a);
+  uevent_put(got);
+  assert(uevent_handle_get(base, 0) == NULL);
+  assert(uevent_handle_get(base, ((uev_handle_t)1 << 32) | 0xffffffU) == NULL);
+  // ссылка из дескриптора держит слот: после uevent_free он не уходит другому событию до put
+  got = uevent_handle_get(base, ha);
+  assert(got == a);
+  uevent_free(a);
+  assert(uevent_handle(a) == 0);
+  assert(uevent_handle_get(base, ha) == NULL);
+  uev_t *other = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, nop_cb, NULL, "handle_other");
+  assert(other != NULL && other != a);
+  uevent_free(other);
+  uevent_put(got);
+
+  // слот занят новым событием, старый дескриптор его не находит
+  uev_t *b = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, nop_cb, NULL, "handle_b");
+  assert(b == a);
+  uev_handle_t hb = uevent_handle(b);
+  got = uevent_handle_get(base, hb);
+  assert(hb != ha && got == b);
+  uevent_put(got);
+  assert(uevent_handle_get(base, ha) == NULL);
+
+  // в работающем цикле слот освобожденного события не выдается до конца итерации
+  uev_t *victim = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, nop_cb, NULL, "handle_victim");
+  assert(victim != NULL);
+  uev_handle_t hv = uevent_handle(victim);
+  uev_t *fresh = NULL, *reused = NULL, *next = NULL;
+  int step = 0;
+  void step_cb(uevent_t * ev, int fd, short event, void *arg) {
+    if (step++ == 0) {
+      uevent_free(victim);
+      assert(uevent_handle_get(base, hv) == NULL);
+      fresh = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, nop_cb, NULL, "handle_fresh");
+      assert(fresh != NULL && fresh != victim);
+      // ключ таймера от времени итерации: второй шаг будет уже в следующей
+      assert(uevent_add(next, 1) == UEV_ERR_OK);
+    } else {
+      reused = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, nop_cb, NULL, "handle_reused");
+      assert(reused == victim);
+      assert(uevent_handle_get(base, hv) == NULL);
+    }
+  }
+  uevent_free(b);
+  b = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, step_cb, NULL, "handle_step");
+  next = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, step_cb, NULL, "handle_step2");
+  assert(b != NULL && next != NULL);
+  assert(uevent_add(b, 1) == UEV_ERR_OK);
+  uevent_base_dispatch(base);
+  assert(step == 2 && reused == victim);
+  uevent_free(fresh);
+  uevent_free(reused);
+  uevent_free(b);
+  uevent_free(next);
+
+  // поколения переживают обнуление страниц отданных сегментов
+  static uev_t *uevs[N];
+  static uev_handle_t hs[N];
+  for (int round = 0; round < 2; round++) {
+    for (int i = 0; i < N; i++) {
+      uevs[i] = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, nop_cb, NULL, "handle_many");
+      assert(uevs[i] != NULL);
+      if (round == 1) assert(uevent_handle_get(base, hs[i]) == NULL);
+    }
+    for (int i = 0; i < N; i++) {
+      if (round == 0) hs[i] = uevent_handle(uevs[i]);
+      got = uevent_handle_get(base, uevent_handle(uevs[i]));
+      assert(got == uevs[i]);
+      uevent_put(got);
+      uevent_free(uevs[i]);
+    }
+  }
+
+  uevent_deinit(base);
+  PRINT_TEST_PASSED();
+}
+
+void test_epoll_changelist() {
+  PRINT_TEST_START("epoll changelist: del+add in a callback collapses into one epoll_ctl");
+  for (int use = 0; use < 2; use++) {
+    uevent_base_args_t args = {.max_events = 16, .changelist = use != 0};
+    uevent_base_t *base = uevent_base_new_with_args(&args);
+    assert(base != NULL);
+
+    int p[2], q[2], r[2];
+    assert(pipe(p) == 0 && fcntl(p[0], F_SETFL, O_NONBLOCK) == 0);
+    assert(pipe(q) == 0 && fcntl(q[0], F_SETFL, O_NONBLOCK) == 0);
+    assert(pipe(r) == 0 && fcntl(r[0], F_SETFL, O_NONBLOCK) == 0);
+    int b_calls = 0;
+    uev_t *a, *b;
+    void nop_cb(uevent_t * ev, int fd, short event, void *arg) {}
+    void b_cb(uevent_t * ev, int fd, short event, void *arg) {
+      // данные не вычитываются: о готовности снова сообщит только повторная регистрация
+      if (++b_calls == 2) uevent_base_loopbreak(base);
+    }
+    void a_cb(uevent_t * ev, int fd, short event, void *arg) {
+      char c;
+      while (read(fd, &c, 1) == 1) {}
+      assert(uevent_del(b) == UEV_ERR_OK);
+      assert(uevent_add(b, 0) == UEV_ERR_OK);
+      // регистрация и снятие в одной итерации не доходят до ядра
+      uev_t *tmp = uevent_create_or_assign_event(NULL, base, r[0], UEV_READ | UEV_PERSIST, nop_cb, NULL, "changelist_tmp");
+      assert(tmp != NULL);
+      assert(uevent_add(tmp, 0) == UEV_ERR_OK);
+      uevent_free(tmp);
+    }
+    a = uevent_create_or_assign_event(NULL, base, p[0], UEV_READ | UEV_PERSIST, a_cb, NULL, "changelist_a");
+    b = uevent_create_or_assign_event(NULL, base, q[0], UEV_READ | UEV_PERSIST, b_cb, NULL, "changelist_b");
+    assert(a != NULL && b != NULL);
+    assert(uevent_add(a, 0) == UEV_ERR_OK);
+    assert(uevent_add(b, 0) == UEV_ERR_OK);
+    assert(write(q[1], "y", 1) == 1);
+    assert(write(p[1], "x", 1) == 1);
+
+    uevent_base_dispatch(base);
+    PRINT_TEST_INFO("changelist=%d b_calls=%d ctl_saved=%lu", use, b_calls, uevent_base_ctl_saved(base));
+    assert(b_calls == 2);
+    // del+add -> один MOD (1), add+del -> ни одного вызова (2)
+    assert(uevent_base_ctl_saved(base) == (use ? 3UL : 0UL));
+
+    uevent_free(a);
+    uevent_free(b);
+    uevent_deinit(base);
+    for (int i = 0; i < 2; i++) {
+      close(p[i]);
+      close(q[i]);
+      close(r[i]);
+    }
+  }
+  PRINT_TEST_PASSED();
+}
+
+void test_oneshot_fd_rearm() {
+  PRINT_TEST_START("one-shot fd events stay in epoll with EPOLLONESHOT and re-arm with MOD");
+  uevent_base_t *base = uevent_base_new_with_workers(16, 0);
+  assert(base != NULL);
+  int sv[2];
+  assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+
+  int fired = 0;
+  void req_cb(uevent_t * ev, int fd, short event, void *arg) {
+    char c;
+    while (read(fd, &c, 1) == 1) {}
+    fired++;
+  }
+  uev_t *uev = uevent_create_or_assign_event(NULL, base, sv[0], UEV_READ, req_cb, NULL, "oneshot_req");
+  assert(uev != NULL);
+
+  for (int round = 1; round <= 3; round++) {
+    assert(uevent_add(uev, 0) == UEV_ERR_OK);
+    assert(uevent_pending(uev, UEV_READ));
+    assert(write(sv[1], "q", 1) == 1);
+    // после срабатывания событие снято, активных нет и цикл выходит
+    uevent_base_dispatch(base);
+    assert(fired == round);
+    assert(!uevent_pending(uev, UEV_READ));
+    // ядро выключило регистрацию, но fd остался в epoll до повторного uevent_add
+    assert(fd_in_some_epoll(sv[0]));
+  }
+
+  // выключенная регистрация не будит цикл: данные без uevent_add не доставляются
+  assert(write(sv[1], "q", 1) == 1);
+  uev_t *guard = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, req_cb, NULL, "oneshot_guard");
+  assert(guard != NULL);
+  assert(uevent_add(guard, 20) == UEV_ERR_OK);
+  uevent_base_dispatch(base);
+  assert(fired == 4); // только guard
+
+  // явный uevent_del взведенного события снимает fd с epoll
+  assert(uevent_add(uev, 0) == UEV_ERR_OK);
+  assert(uevent_del(uev) == UEV_ERR_OK);
+  assert(!fd_in_some_epoll(sv[0]));
+
+  // выключенную регистрацию освобожденного события забирает следующее событие на том же fd
+  assert(uevent_add(uev, 0) == UEV_ERR_OK);
+  assert(write(sv[1], "q", 1) == 1);
+  uevent_base_dispatch(base);
+  assert(fired == 5);
+  assert(fd_in_some_epoll(sv[0]));
+  uevent_free(uev);
+  uev = uevent_create_or_assign_event(NULL, base, sv[0], UEV_READ, req_cb, NULL, "oneshot_next");
+  assert(uev != NULL);
+  assert(uevent_add(uev, 0) == UEV_ERR_OK);
+  assert(write(sv[1], "q", 1) == 1);
+  uevent_base_dispatch(base);
+  assert(fired == 6);
+
+  // fd закрыт после срабатывания и его номер достался другому событию: освобождение
+  // старого не трогает чужую регистрацию
+  int old_fd = sv[0];
+  close(sv[0]);
+  close(sv[1]);
+  assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+  assert(sv[0] == old_fd);
+  uev_t *reused = uevent_create_or_assign_event(NULL, base, sv[0], UEV_READ, req_cb, NULL, "oneshot_reused");
+  assert(reused != NULL);
+  assert(uevent_add(reused, 0) == UEV_ERR_OK);
+  uevent_free(uev);
+  assert(fd_in_some_epoll(sv[0]));
+  uev = reused;
+  assert(write(sv[1], "q", 1) == 1);
+  uevent_base_dispatch(base);
+  assert(fired == 7);
+
+  uevent_free(guard);
+  uevent_free(uev);
+  uevent_deinit(base);
+  close(sv[0]);
+  close(sv[1]);
+  PRINT_TEST_PASSED();
+}
+
+void test_coroutines() {
+  PRINT_TEST_START("stackful coroutines resumed from the event loop");
+  uevent_base_t *base = uevent_base_new_with_workers(64, 0);
+  assert(base != NULL);
+  uev_co_sched_t *sched = uev_co_sched_new(base, NULL);
+  assert(sched != NULL);
+  // база с воркерами возобновляла бы корутины из чужих потоков
+  uevent_base_t *wbase = uevent_base_new_with_workers(64, 2);
+  assert(wbase != NULL);
+  assert(uev_co_sched_new(wbase, NULL) == NULL);
+  uevent_deinit(wbase);
+  int sv[2];
+  assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+
+  // вне корутины uev_co_read — обычный неблокирующий read
+  char c;
+  assert(uev_co_read(sv[0], &c, 1) == -1 && errno == EAGAIN);
+  assert(uev_co_self() == NULL);
+
+  char trace[32] = {0};
+  int ntrace = 0;
+  int user_cb_calls = 0;
+  int waited = 0;
+
+  // сервер: ждет запрос на чтении, отвечает
+  void server(void *arg) {
+    (void)arg;
+    assert(uev_co_self() != NULL);
+    char buf[8];
+    ssize_t n = uev_co_read(sv[0], buf, sizeof(buf));
+    assert(n == 4 && memcmp(buf, "ping", 4) == 0);
+    trace[ntrace++] = 's';
+    assert(uev_co_write(sv[0], "pong", 4) == 4);
+  }
+  // клиент: спит, шлет запрос и ждет ответ
+  void client(void *arg) {
+    (void)arg;
+    uint64_t t0 = uevent_base_now(base);
+    assert(uev_co_sleep(20) == UEV_ERR_OK);
+    assert(uevent_base_now(base) - t0 >= 19);
+    trace[ntrace++] = 'c';
+    assert(uev_co_write(sv[1], "ping", 4) == 4);
+    char buf[8];
+    assert(uev_co_read(sv[1], buf, sizeof(buf)) == 4 && memcmp(buf, "pong", 4) == 0);
+    trace[ntrace++] = 'r';
+  }
+  // чужое событие: пока корутина его ждет, колбэк пользователя не вызывается,
+  // после ожидания событие перевзводится из самой корутины
+  void user_cb(uevent_t * ev, int fd, short event, void *arg) {
+    user_cb_calls++;
+  }
+  uev_t *tm = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, user_cb, NULL, "co_user_timer");
+  assert(tm != NULL);
+  void waiter(void *arg) {
+    (void)arg;
+    for (int i = 0; i < 3; i++) {
+      assert(uevent_add(tm, 5) == UEV_ERR_OK);
+      assert(uev_co_wait(tm) & UEV_TIMEOUT);
+      waited++;
+    }
+  }
+  // уступающие по очереди корутины чередуются
+  void yielder(void *arg) {
+    for (int i = 0; i < 3; i++) {
+      trace[ntrace++] = *(char *)arg;
+      uev_co_yield();
+    }
+  }
+
+  assert(uev_co_spawn(sched, server, NULL, "co_server") == UEV_ERR_OK);
+  assert(uev_co_spawn(sched, client, NULL, "co_client") == UEV_ERR_OK);
+  assert(uev_co_spawn(sched, waiter, NULL, "co_waiter") == UEV_ERR_OK);
+  assert(uev_co_spawn(sched, yielder, "a", "co_yield_a") == UEV_ERR_OK);
+  assert(uev_co_spawn(sched, yielder, "b", "co_yield_b") == UEV_ERR_OK);
+  assert(uev_co_sched_live(sched) == 5);
+
+  uevent_base_dispatch(base);
+  assert(uev_co_sched_live(sched) == 0);
+  assert(strcmp(trace, "ababab" "csr") == 0);
+  assert(waited == 3);
+  assert(user_cb_calls == 0);
+
+  // после ожидания колбэк пользователя вернулся на место
+  assert(uevent_add(tm, 1) == UEV_ERR_OK);
+  uevent_base_dispatch(base);
+  assert(user_cb_calls == 1);
+
+  // незавершенная корутина уничтожается вместе с планировщиком
+  void sleeper(void *arg) {
+    (void)arg;
+    uev_co_sleep(60000);
+    abort();
+  }
+  assert(uev_co_spawn(sched, sleeper, NULL, "co_sleeper") == UEV_ERR_OK);
+  void stop_cb(uevent_t * ev, int fd, short event, void *arg) {
+    uevent_base_loopbreak(base);
+  }
+  uev_t *stop = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, stop_cb, NULL, "co_stop");
+  assert(uevent_add(stop, 10) == UEV_ERR_OK);
+  uevent_base_dispatch(base);
+  assert(uev_co_sched_live(sched) == 1);
+  uev_co_sched_free(sched);
+
+  uevent_free(stop);
+  uevent_free(tm);
+  uevent_deinit(base);
+  close(sv[0]);
+  close(sv[1]);
+  PRINT_TEST_PASSED();
+}
+
+void test_slab_allocator() {
+  PRINT_TEST_START("dynamic events come from the per-base slab with per-thread caches");
+  uevent_base_t *base = uevent_base_new_with_workers(16, 0);
+  assert(base != NULL);
+  uevent_slab_stats_t st;
+  assert(uevent_base_slab_stats(NULL, &st) == UEV_ERR_INVAL);
+  assert(uevent_base_slab_stats(base, &st) == UEV_ERR_OK);
+  assert(st.live == 0 && st.slabs == 0); // служебное событие статическое
+
+  enum { N = 1000 };
+  static uev_t *uevs[N];
+  for (int i = 0; i < N; i++) {
+    uevs[i] = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, NULL, NULL, "slab_ev");
+    assert(uevs[i] != NULL);
+  }
+  assert(uevent_base_slab_stats(base, &st) == UEV_ERR_OK);
+  assert(st.live == N);
+  unsigned long slabs = st.slabs;
+  assert(slabs >= 2 && slabs < 10);
+
+  // освобождение в своем потоке: объекты остаются в кеше и снова выдаются без новых блоков
+  for (int i = 0; i < N / 2; i++) uevent_free(uevs[i]);
+  for (int i = 0; i < N / 2; i++) {
+    uevs[i] = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, NULL, NULL, "slab_ev");
+    assert(uevs[i] != NULL);
+  }
+  assert(uevent_base_slab_stats(base, &st) == UEV_ERR_OK);
+  assert(st.live == N && st.slabs == slabs && st.remote_frees == 0);
+
+  // чужой поток освобождает все: каждое освобождение удаленное, кеш потока
+  // при его завершении возвращается в склад базы
+  void *free_all(void *arg) {
+    (void)arg;
+    for (int i = 0; i < N; i++) uevent_free(uevs[i]);
+    return NULL;
+  }
+  pthread_t th;
+  assert(pthread_create(&th, NULL, free_all, NULL) == 0);
+  pthread_join(th, NULL);
+  assert(uevent_base_slab_stats(base, &st) == UEV_ERR_OK);
+  assert(st.live == 0 && st.remote_frees == N);
+
+  for (int i = 0; i < N; i++) {
+    uevs[i] = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT, NULL, NULL, "slab_ev");
+    assert(uevs[i] != NULL);
+  }
+  assert(uevent_base_slab_stats(base, &st) == UEV_ERR_OK);
+  assert(st.live == N && st.slabs == slabs);
+  for (int i = 0; i < N; i++) uevent_free(uevs[i]);
+  assert(uevent_base_slab_stats(base, &st) == UEV_ERR_OK);
+  assert(st.live == 0);
+
+  uevent_deinit(base);
+  PRINT_TEST_PASSED();
+}
+
+void test_worker_affinity() {
+  PRINT_TEST_START("worker affinity: per-worker queues, no dropped callbacks, stealing on backlog");
+  enum { W = 4, NFD = 8 };
+  uevent_base_args_t args = {.max_events = 64, .num_workers = W, .worker_affinity = true};
+  uevent_base_t *base = uevent_base_new_with_args(&args);
+  assert(base != NULL);
+  uev_t *keep = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT | UEV_PERSIST, NULL, NULL, "aff_keep");
+  assert(uevent_add(keep, 10000) == UEV_ERR_OK);
+
+  typedef struct {
+    int fd[2];
+    uev_t *uev;
+    pthread_t thread;
+    _Atomic int calls;
+    _Atomic int bytes;
+    _Atomic bool other_thread;
+    int delay_ms;
+  } aff_conn_t;
+  static aff_conn_t conns[NFD];
+  static aff_conn_t more[16];
+  memset(conns, 0, sizeof(conns));
+  memset(more, 0, sizeof(more));
+
+  void conn_cb(uevent_t * ev, int fd, short event, void *arg) {
+    aff_conn_t *c = arg;
+    if (atomic_fetch_add(&c->calls, 1) == 0) {
+      c->thread = pthread_self();
+    } else if (!pthread_equal(c->thread, pthread_self())) {
+      atomic_store(&c->other_thread, true);
+    }
+    char buf[64];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) atomic_fetch_add(&c->bytes, (int)n);
+    if (c->delay_ms) usleep(c->delay_ms * 1000);
+  }
+  for (int i = 0; i < NFD; i++) {
+    assert(pipe(conns[i].fd) == 0);
+    assert(fcntl(conns[i].fd[0], F_SETFL, O_NONBLOCK) == 0);
+    conns[i].uev = uevent_create_or_assign_event(NULL, base, conns[i].fd[0], UEV_READ | UEV_PERSIST, conn_cb, &conns[i], "aff_conn");
+    assert(uevent_add(conns[i].uev, 0) == UEV_ERR_OK);
+  }
+
+  pthread_t loop;
+  void *loop_fn(void *arg) {
+    uevent_base_dispatch(arg);
+    return NULL;
+  }
+  assert(pthread_create(&loop, NULL, loop_fn, base) == 0);
+
+  bool wait_bytes(aff_conn_t * c, int want) {
+    for (int t = 0; t < 2000 && atomic_load(&c->bytes) < want; t++) usleep(1000);
+    return atomic_load(&c->bytes) == want;
+  }
+
+  // по одной задаче за раз воровать нечего: все колбэки fd выполняет один и тот же воркер
+  for (int round = 1; round <= 10; round++) {
+    for (int i = 0; i < NFD; i++) {
+      assert(write(conns[i].fd[1], "x", 1) == 1);
+      assert(wait_bytes(&conns[i], round));
+    }
+  }
+  assert(uevent_base_worker_stolen(base) == 0);
+  for (int i = 0; i < NFD; i++) assert(!atomic_load(&conns[i].other_thread));
+
+  // срабатывание во время колбэка не теряется: при EPOLLET второго фронта не будет
+  aff_conn_t *slow = &conns[0];
+  slow->delay_ms = 50;
+  int calls = atomic_load(&slow->calls);
+  assert(write(slow->fd[1], "a", 1) == 1);
+  while (atomic_load(&slow->calls) == calls) usleep(1000);
+  usleep(5000);
+  assert(write(slow->fd[1], "b", 1) == 1);
+  assert(wait_bytes(slow, 12));
+  slow->delay_ms = 0;
+
+  // очередь одного воркера с задачами нескольких fd разбирают свободные воркеры;
+  // при числе воркеров степени двойки маршрут — fd по модулю их числа
+  aff_conn_t *same[NFD];
+  int nsame = 0;
+  for (int i = 0; i < NFD; i++) {
+    if (conns[i].fd[0] % W == conns[0].fd[0] % W) same[nsame++] = &conns[i];
+  }
+  int extra = 0;
+  for (int i = 0; nsame < 6 && i < 16; i++) {
+    assert(pipe(more[i].fd) == 0);
+    assert(fcntl(more[i].fd[0], F_SETFL, O_NONBLOCK) == 0);
+    extra = i + 1;
+    if (more[i].fd[0] % W != conns[0].fd[0] % W) continue;
+    more[i].uev = uevent_create_or_assign_event(NULL, base, more[i].fd[0], UEV_READ | UEV_PERSIST, conn_cb, &more[i], "aff_more");
+    assert(uevent_add(more[i].uev, 0) == UEV_ERR_OK);
+    same[nsame++] = &more[i];
+  }
+  assert(nsame >= 4);
+  for (int i = 0; i < nsame; i++) same[i]->delay_ms = 20;
+  for (int i = 0; i < nsame; i++) assert(write(same[i]->fd[1], "s", 1) == 1);
+  for (int t = 0; t < 2000 && uevent_base_worker_stolen(base) == 0; t++) usleep(1000);
+  assert(uevent_base_worker_stolen(base) > 0);
+
+  uevent_base_loopbreak(base);
+  pthread_join(loop, NULL);
+  uevent_free(keep);
+  for (int i = 0; i < NFD; i++) {
+    uevent_free(conns[i].uev);
+    close(conns[i].fd[0]);
+    close(conns[i].fd[1]);
+  }
+  for (int i = 0; i < extra; i++) {
+    uevent_free(more[i].uev);
+    close(more[i].fd[0]);
+    close(more[i].fd[1]);
+  }
+  uevent_deinit(base);
+  PRINT_TEST_PASSED();
+}
+
+void test_thread_placement() {
+  PRINT_TEST_START("thread placement: loop and worker cpus and nice, numa-local base memory, invalid args rejected");
+  static const int cpu0[] = {0};
+  static const int bad_cpu[] = {-1};
+  uevent_thread_placement_t bad[] = {
+      {.cpus = bad_cpu, .ncpus = 1},
+      {.cpus = NULL, .ncpus = 1},
+      {.sched_policy = SCHED_FIFO, .sched_priority = 0},
+      {.sched_priority = 5},
+      {.nice = 20},
+  };
+  for (size_t i = 0; i < ARRAY_SIZE(bad); i++) {
+    uevent_base_args_t args = {.max_events = 64, .loop_placement = &bad[i]};
+    assert(uevent_base_new_with_args(&args) == NULL);
+    args = (uevent_base_args_t){.max_events = 64, .num_workers = 1, .worker_placement = &bad[i], .worker_placement_cnt = 1};
+    assert(uevent_base_new_with_args(&args) == NULL);
+  }
+  uevent_base_args_t neg = {.max_events = 64, .worker_placement_cnt = -1};
+  assert(uevent_base_new_with_args(&neg) == NULL);
+
+  uevent_thread_placement_t loop_place = {.cpus = cpu0, .ncpus = 1, .nice = 3};
+  uevent_thread_placement_t worker_place[] = {
+      {.cpus = cpu0, .ncpus = 1, .nice = 5},
+      {.cpus = cpu0, .ncpus = 1, .nice = 7},
+  };
+  uevent_base_args_t args = {
+      .max_events = 64,
+      .num_workers = 2,
+      .loop_placement = &loop_place,
+      .worker_placement = worker_place,
+      .worker_placement_cnt = 2,
+      .numa_local = true,
+  };
+  uevent_base_t *base = uevent_base_new_with_args(&args);
+  assert(base != NULL);
+
+  // маска CPU и nice потока, в котором выполняется вызов
+  typedef struct {
+    unsigned long mask;
+    int nice;
+  } place_seen_t;
+  void seen_self(place_seen_t * out) {
+    unsigned long mask = 0;
+    assert(syscall(SYS_sched_getaffinity, 0, sizeof(mask), &mask) > 0);
+    out->mask = mask;
+    out->nice = getpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid));
+  }
+  static place_seen_t loop_seen;
+  static place_seen_t worker_seen[8];
+  static _Atomic int worker_calls;
+  memset(&loop_seen, 0, sizeof(loop_seen));
+  memset(worker_seen, 0, sizeof(worker_seen));
+  atomic_store(&worker_calls, 0);
+
+  void loop_fn(void *arg) {
+    seen_self(&loop_seen);
+  }
+  void worker_cb(uevent_t * ev, int fd, short event, void *arg) {
+    int n = atomic_fetch_add(&worker_calls, 1);
+    if (n < (int)ARRAY_SIZE(worker_seen)) seen_self(&worker_seen[n]);
+    if (n + 1 == (int)ARRAY_SIZE(worker_seen)) uevent_base_loopbreak(arg);
+  }
+  uev_t *timers[4];
+  for (int i = 0; i < 4; i++) {
+    timers[i] = uevent_create_or_assign_event(NULL, base, -1, UEV_TIMEOUT | UEV_PERSIST, worker_cb, base, "place_timer");
+    assert(uevent_add(timers[i], 5) == UEV_ERR_OK);
+  }
+  assert(uevent_post(base, loop_fn, NULL) == UEV_ERR_OK);
+
+  // nice меняется у потока цикла насовсем, поэтому цикл крутится в отдельном потоке
+  void *loop_thread(void *arg) {
+    uevent_base_dispatch(arg);
+    return NULL;
+  }
+  pthread_t loop;
+  assert(pthread_create(&loop, NULL, loop_thread, base) == 0);
+  pthread_join(loop, NULL);
+
+  assert(loop_seen.mask == 1UL);
+  assert(loop_seen.nice == 3);
+  assert(atomic_load(&worker_calls) >= (int)ARRAY_SIZE(worker_seen));
+  for (size_t i = 0; i < ARRAY_SIZE(worker_seen); i++) {
+    assert(worker_seen[i].mask == 1UL);
+    assert(worker_seen[i].nice == 5 || worker_seen[i].nice == 7);
+  }
+
+  for (int i = 0; i < 4; i++) uevent_free(timers[i]);
+  uevent_deinit(base);
+  PRINT_TEST_PASSED();
+}
+
 int main(int argc, char **argv) {
   printf("Starting uevent library tests...\n\n");
 #ifdef DEBUG
@@ -1568,6 +3488,31 @@ int main(int argc, char **argv) {
       {"self_readding_timers_race", test_self_readding_timers_race},
       {"wakeup_and_timeout_accuracy", test_wakeup_and_timeout_accuracy},
       {"stdin_read_write_event_no_del", test_stdin_read_write_event_no_del},
+      {"timer_wheel_random", test_timer_wheel_random},
+      {"timer_wheel_backend", test_timer_wheel_backend},
+      {"cross_thread_rearm_queue", test_cross_thread_rearm_queue},
+      {"hires_timers", test_hires_timers},
+      {"timer_batch_expiry", test_timer_batch_expiry},
+      {"slot_table_growth", test_slot_table_growth},
+      {"base_group", test_base_group},
+      {"io_uring_backend", test_io_uring_backend},
+      {"callback_stats", test_callback_stats},
+      {"stream", test_stream},
+      {"signal_child_events", test_signal_child_events},
+      {"post_ring", test_post_ring},
+      {"busy_poll", test_busy_poll},
+      {"state_word_padded_slots", test_state_word_padded_slots},
+      {"base_now", test_base_now},
+      {"virtual_clock", test_virtual_clock},
+      {"listener_group", test_listener_group},
+      {"priorities", test_priorities},
+      {"event_handles", test_event_handles},
+      {"epoll_changelist", test_epoll_changelist},
+      {"oneshot_fd_rearm", test_oneshot_fd_rearm},
+      {"coroutines", test_coroutines},
+      {"slab_allocator", test_slab_allocator},
+      {"worker_affinity", test_worker_affinity},
+      {"thread_placement", test_thread_placement},
   };
 
   int rc = run_named_test(argc > 1 ? argv[1] : NULL, tests, ARRAY_SIZE(tests));
@@ -1619,6 +3564,31 @@ int main(int argc, char **argv) {
   test_self_readding_timers_race();
   test_wakeup_and_timeout_accuracy();
   test_stdin_read_write_event_no_del();
+  test_timer_wheel_random();
+  test_timer_wheel_backend();
+  test_cross_thread_rearm_queue();
+  test_hires_timers();
+  test_timer_batch_expiry();
+  test_slot_table_growth();
+  test_base_group();
+  test_io_uring_backend();
+  test_callback_stats();
+  test_stream();
+  test_signal_child_events();
+  test_post_ring();
+  test_busy_poll();
+  test_state_word_padded_slots();
+  test_base_now();
+  test_virtual_clock();
+  test_listener_group();
+  test_priorities();
+  test_event_handles();
+  test_epoll_changelist();
+  test_oneshot_fd_rearm();
+  test_coroutines();
+  test_slab_allocator();
+  test_worker_affinity();
+  test_thread_placement();
 
   printf("\nAll tests completed successfully!\n");
   return 0;
@@ -7,6 +7,7 @@
 #include <fcntl.h>
 #include <inttypes.h>
 #include <pthread.h>
+#include <sched.h>
 #include <stdarg.h>
 #include <stdatomic.h>
 #include <stdbool.h>
@@ -15,6 +16,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
 #include <sys/time.h>
 #include <unistd.h>
 
@@ -24,12 +28,27 @@
 #include "../timeutil/timeutil.h"
 #include "uevent.h"
 #include "uevent_internal.h"
+#include "uevent_placement.h"
+#include "uevent_post.h"
+#include "uevent_slab.h"
+#include "uevent_stats.h"
+#include "uevent_uring.h"
+#include "uevent_wheel.h"
 #include "uevent_worker.h"
 
+#include <signal.h>
 #include <time.h>
 
 #define EPOLL_MAX_TIMEOUT_MS 60000U
 #define UEVENT_DEFAULT_WORKERS_NUM 6
+#define UEVENT_DEFAULT_TIMER_BATCH 500
+#define UEVENT_DEFAULT_POST_QUEUE 1024
+#define UEV_BUSY_POLL_MIN_NS 1000U // окно опроса короче микросекунды не имеет смысла, опрос выключается
+#define UEV_URING_MIN_ENTRIES 64U
+#define UEV_URING_MAX_ENTRIES 4096U // при заполнении очередь отправки сбрасывается в ядро досрочно
+#define UEV_SLOT_SEG_SIZE 256U // слотов в сегменте таблицы (6 КБ при sizeof(uev_t) == 24)
+#define UEV_SLOT_PADDED 64U    // шаг слота с pad_slots: по кеш-линии на слот
+_Static_assert(sizeof(uev_t) <= UEV_SLOT_PADDED, "uev_t does not fit into a padded slot");
 
 // logger fallback
 #ifdef IS_DYNAMIC_LIB
@@ -92,6 +111,47 @@ __attribute__((weak)) int msleep(uint64_t ms) {
   ((type *)((char *)(ptr) - offsetof(type, member)))
 #endif
 
+// истекший таймер, извлеченный в пачку uevent_handle_timers
+typedef struct {
+  uev_t *uev;           // событие, пачка держит на него ссылку таймера
+  uint64_t cron_time;   // время срабатывания в мс по часам базы (тики / timer_ticks_per_ms)
+  unsigned int del_seq; // del_seq события на момент извлечения
+} expired_timer_info_t;
+
+// готовый fd, ожидающий разбора по приоритетам
+typedef struct {
+  uev_t *uev;
+  uint32_t epoll_events;
+  bool held; // перенесен с прошлой итерации и держит ссылку
+} uev_ready_t;
+
+// отложенное изменение регистрации fd в epoll, копится за итерацию цикла
+typedef struct {
+  uev_t *uev;
+  int fd;
+  bool registered;  // fd был зарегистрирован в ядре до первого изменения в итерации
+  unsigned int ops; // сколько вызовов epoll_ctl стоили бы изменения без списка
+} uev_change_t;
+
+// сегмент таблицы слотов: память слотов не перемещается и не возвращается до uevent_deinit,
+// поэтому выданные uev_t* остаются валидными; у простаивающих сегментов системе отдаются только страницы
+typedef struct {
+  uev_t *slots;              // UEV_SLOT_SEG_SIZE слотов с шагом slot_stride (mmap)
+  unsigned short *free_offs; // стек свободных смещений внутри сегмента
+  unsigned int free_cnt;     // число свободных слотов в сегменте
+  bool released;             // страницы отданы системе через MADV_DONTNEED
+  uint32_t gen_floor;        // старшее поколение, выданное в сегменте: переживает обнуление страниц
+} uev_slot_seg_t;
+
+// каталог сегментов для разбора дескрипторов без блокировки: растет удвоением,
+// прежние копии остаются читаемыми до uevent_deinit
+typedef struct uev_seg_dir_t {
+  struct uev_seg_dir_t *prev; // предыдущая копия каталога
+  _Atomic unsigned int cnt;   // опубликованных сегментов
+  unsigned int cap;
+  uev_t *slots[]; // начало памяти слотов сегмента
+} uev_seg_dir_t;
+
 struct uevent_base_t {
   uevent_t wakeup_event;             // служебное событие для пробуждения epoll_wait
   pthread_mutex_t base_mut;          // мьютекс для защиты event_list и timer_heap
@@ -99,23 +159,108 @@ struct uevent_base_t {
   pthread_cond_t base_cond;          // условие к мьютексу
   struct epoll_event *events;        // массив epoll событий
   minheap_t *timer_heap;             // куча таймеров (minheap)
+  uev_wheel_t *timer_wheel;          // колесо таймеров (если выбран UEV_TIMER_WHEEL)
+  uev_timer_backend_t timer_backend; // бэкенд очереди таймеров
+  bool hires_timers;                 // ключи таймеров в наносекундах, ожидание через epoll_pwait2
+  _Atomic uint64_t now_cache;        // время итерации в тиках очереди таймеров, пишет поток цикла
+  uevent_clock_fn_t clock_fn;        // пользовательский источник времени или NULL
+  void *clock_arg;                   // аргумент clock_fn
+  bool virtual_clock;                // время двигает цикл: сон до таймера заменяется переводом часов
+  _Atomic uint64_t vclock;           // виртуальное время в тиках очереди таймеров
+  unsigned int timer_batch_max;      // сколько истекших таймеров обрабатывается за одну итерацию
+  expired_timer_info_t *timer_batch; // пачка истекших таймеров, используется только потоком цикла
+  uevent_worker_batch_item_t *worker_batch; // пачка задач для пула воркеров
   uevent_worker_pool_t *worker_pool; // пул воркеров для асинхронных колбэков
-  uev_t *uev_arr;                    // массив с обертками событий
-  int epoll_fd;                      // epoll fd
+  uev_slot_seg_t *uev_segs;          // сегменты таблицы слотов с обертками событий
+  _Atomic(uev_seg_dir_t *) seg_dir;  // каталог сегментов для uevent_handle_get()
+  int epoll_fd;                      // epoll fd, -1 для io_uring
+  uev_io_backend_t io_backend;       // бэкенд fd
+  uev_uring_t *uring;                // кольцо io_uring или NULL
+  uev_stats_t *stats;                // статистика колбэков по именам событий или NULL
+  uev_post_ring_t *post_ring;        // кольцо вызовов uevent_post(), читает поток цикла
+  uev_slab_t *ev_slab;               // память динамических uevent_t базы
+  uint64_t busy_poll_ns;             // настроенное окно опроса без сна, 0 — режим выключен
+  uint64_t busy_window_ns;           // текущее окно с учетом отката, меняет только поток цикла
+  uint64_t busy_deadline_ns;         // до какого момента ждать с нулевым таймаутом, 0 — не опрашиваем
   unsigned int max_events;           // размер массива events
-  unsigned int *free_uev_arr;        // массив индексов свободных слотов ev_arr
-  unsigned int uev_arr_sz;           // размер массива с обертками событий
-  unsigned int free_uev_arr_cnt;     // кол-во свободных слотов
+  unsigned int uev_segs_cnt;         // число сегментов
+  unsigned int uev_segs_min;         // сегменты, созданные вместе с базой, их страницы не отдаются
+  unsigned int uev_seg_hint;         // первый сегмент, в котором могут быть свободные слоты
+  unsigned int uev_segs_released;    // число сегментов с отданными страницами
+  unsigned int free_uev_cnt;         // кол-во свободных слотов во всех сегментах
+  size_t slot_stride;                // шаг слотов в сегменте: sizeof(uev_t) или кеш-линия
   _Atomic int num_active_fd;         // число активных fd-событий
   _Atomic int num_active_timers;     // число активных таймеров
   _Atomic bool wakeup_fd_written;    // true, если в wakeup_fd уже записано значение
   _Atomic bool running;              // true, если event loop запущен
   _Atomic bool stopped;              // true, если event loop завершился
+  pthread_t loop_thread;             // поток, в котором крутится event loop
+  _Atomic(uevent_t *) cmd_head;      // очередь команд таймеров от других потоков (MPSC стек)
+  _Atomic(uevent_t *) retire_head;   // события без ссылок, ждут конца итерации цикла (MPSC стек)
+  _Atomic int num_pending_cmds;      // число событий в очереди команд
+  unsigned int num_prios;            // уровней приоритета, 1 — без приоритетов
+  unsigned int prio_budget;          // колбэков fd ниже уровня 0 за итерацию, 0 — без ограничения
+  uev_ready_t *ready;                // готовые fd итерации, упорядочиваются по приоритету
+  uev_ready_t *ready_sorted;
+  unsigned int ready_cap;
+  uev_ready_t *deferred;             // fd, не уложившиеся в бюджет, ждут следующей итерации
+  unsigned int deferred_cnt;
+  unsigned int deferred_cap;
+  bool changelist;                   // uevent_add/uevent_del из потока цикла копятся в changes
+  uev_change_t *changes;             // изменения регистрации fd до следующего epoll_wait
+  unsigned int changes_cnt;
+  unsigned int changes_cap;
+  _Atomic unsigned long ctl_saved;   // сэкономленные списком вызовы epoll_ctl
+  pthread_mutex_t stale_mut;         // мьютекс для защиты stale_fds
+  uint64_t *stale_fds;               // биты fd, где осталась выключенная регистрация освобожденного события
+  size_t stale_words;
+  _Atomic unsigned int stale_cnt;    // установленных битов stale_fds
+  uev_placement_t loop_place;        // CPU и планировщик потока цикла
+  bool loop_placed;                  // loop_place применяется при входе в uevent_base_dispatch()
+  int numa_node;                     // узел NUMA для слотов, events[] и кучи таймеров, -1 — без привязки
 };
 
+// значение cmd_key для отложенного удаления таймера
+#define UEV_CMD_DEL UINT64_MAX
+// значение cmd_key без непримененной команды
+#define UEV_CMD_NONE (UINT64_MAX - 1)
+
+// время для ключей очереди таймеров: мс, в режиме hires_timers — нс по CLOCK_MONOTONIC
+// (по этим же часам ядро отсчитывает таймаут epoll_pwait2)
+static uint64_t timer_now(const uevent_base_t *base) {
+  if (base->virtual_clock) return atomic_load_explicit(&base->vclock, memory_order_relaxed);
+  if (base->clock_fn != NULL) return base->clock_fn(base->clock_arg);
+  if (!base->hires_timers) return tu_clock_gettime_monotonic_ms();
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * NSEC_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+// число тиков очереди таймеров в одной миллисекунде
+static inline uint64_t timer_ticks_per_ms(const uevent_base_t *base) {
+  return (base != NULL && base->hires_timers) ? NSEC_PER_MSEC : 1U;
+}
+
+// перечитать часы и обновить кешированное время итерации
+static inline uint64_t timer_now_update(uevent_base_t *base) {
+  uint64_t now = timer_now(base);
+  atomic_store_explicit(&base->now_cache, now, memory_order_relaxed);
+  return now;
+}
+
+// кешированное время итерации, обновляется после epoll_wait и перед расчетом таймаута
+static inline uint64_t timer_now_cached(const uevent_base_t *base) {
+  return atomic_load_explicit(&base->now_cache, memory_order_relaxed);
+}
+
 // forward declaration
 static void uevent_init_ev(uevent_t *event, uevent_base_t *base, int fd, short events, uevent_cb_t cb, void *arg, const char *name);
 static int uev_return(uevent_base_t *base, uev_t *uev);
+static void ready_release(uevent_base_t *base);
+static void changelist_flush(uevent_base_t *base);
+static bool retire_push(uev_t *uev);
+static void retire_drain(uevent_base_t *base);
+static void stale_fd_mark(uevent_base_t *base, int fd);
 
 static void wakeup_fd_read_cb(uevent_t *ev, int fd, short events, void *arg) {
   TINIT;
@@ -133,7 +278,7 @@ static void wakeup_fd_read_cb(uevent_t *ev, int fd, short events, void *arg) {
     syslog2(LOG_ERR, "[TIMER_ERR] failed to read from wakeup_fd=%d: %s", fd, strerror(errno));
   } else {
     syslog2(LOG_DEBUG, "[TIMER_WAK] read wakeup_fd=%d OK", fd);
-    atomic_store_explicit(&ev->base->wakeup_fd_written, false, memory_order_release);
+    atomic_store(&ev->base->wakeup_fd_written, false);
   }
   TMARK(2, "wakeup_fd_read_cb END");
 }
@@ -148,43 +293,41 @@ static void uevent_base_wakeup(uevent_base_t *base) {
   if (base == NULL) {
     return;
   }
-  if (atomic_load_explicit(&base->wakeup_fd_written, memory_order_acquire)) {
+  // флаг ставится до записи: если поставить после, цикл может успеть вычитать fd
+  // между write и установкой флага, и следующие пробуждения будут потеряны
+  if (atomic_exchange(&base->wakeup_fd_written, true)) {
     return;
   }
   uint64_t val = 1;
   int fd = base->wakeup_event.fd;
   ssize_t res = write(fd, &val, sizeof(val));
   if ((res < 0) && (errno != EAGAIN)) {
+    atomic_store(&base->wakeup_fd_written, false);
     syslog2(LOG_WARNING, "failed to write to wakeup_fd=%d error='%s'", fd, strerror(errno));
   } else {
-    atomic_store_explicit(&base->wakeup_fd_written, true, memory_order_release);
     syslog2(LOG_DEBUG, "[TIMER_WAK] write wakeup_fd=%d OK", fd);
   }
 }
 
 static inline bool uevent_try_lock(uevent_t *ev) {
   FUNC_START_DEBUG;
-  bool expected = false;
-  return atomic_compare_exchange_strong_explicit(
-      &ev->modification_lock,
-      &expected,
-      true,
-      memory_order_acquire,
-      memory_order_relaxed);
+  uint32_t st = atomic_load_explicit(&ev->state, memory_order_relaxed);
+  while ((st & UEV_ST_LOCKED) == 0) {
+    if (atomic_compare_exchange_weak_explicit(&ev->state, &st, st | UEV_ST_LOCKED, memory_order_acquire, memory_order_relaxed)) {
+      return true;
+    }
+  }
+  return false;
 }
 
 static void uevent_unlock(uevent_t *ev) {
-  atomic_store_explicit(&ev->modification_lock, false, memory_order_release);
+  atomic_fetch_and_explicit(&ev->state, ~UEV_ST_LOCKED, memory_order_release);
 }
 
 // сбросить все поля статического события
 static void uevent_reset_static_ev(uevent_t *ev) {
   ATOM_STORE_REL(ev->base, NULL);
-  ATOM_STORE_REL(ev->modification_lock, 0);
-  ATOM_STORE_REL(ev->active_fd, 0);
-  ATOM_STORE_REL(ev->active_timer, 0);
-  ATOM_STORE_REL(ev->pending_free, 0);
-  ATOM_STORE_REL(ev->is_in_worker_pool, 0);
+  ATOM_STORE_REL(ev->state, 0);
   ev->uev = NULL; // Обнуляем ev->uev для статических событий
   ev->fd = -1;
   ev->events = 0;
@@ -192,8 +335,13 @@ static void uevent_reset_static_ev(uevent_t *ev) {
   ev->cb_wrapper = NULL;
   ev->arg = NULL;
   ev->name = NULL;
-  ev->timer_node.key = 0;
-  ev->timer_node.idx = 0;
+  // нулевой узел не стоит ни в куче (idx == 0), ни в колесе (list.next == NULL)
+  memset(&ev->wheel_node, 0, sizeof(ev->wheel_node));
+  ev->cmd_next = NULL;
+  ev->priority = 0;
+  ATOM_STORE_REL(ev->cmd_key, UEV_CMD_NONE);
+  ATOM_STORE_RELAX(ev->worker_pending, 0);
+  ev->stat_entry = NULL;
 }
 
 // внутренняя функция освобождения памяти или сброса для статического события
@@ -206,47 +354,74 @@ static void uevent_destroy_uev_internal_unsafe(uev_t *uev) {
   // возвращаем слот назад
   uev_return(base, uev);
 
+  // выключенная одноразовая регистрация сама не уходит, пока fd открыт. DEL по номеру fd
+  // здесь нельзя: fd мог быть закрыт и выдан другому событию. Помечаем номер, регистрацию
+  // заберет следующий ADD на нем, если получит EEXIST
+  if (base != NULL && base->epoll_fd >= 0 && ev->fd >= 0 && uev_st_test(ev, UEV_ST_ONESHOT)) {
+    uev_st_clear(ev, UEV_ST_ONESHOT);
+    stale_fd_mark(base, ev->fd);
+  }
+
+  // signalfd и pidfd создает библиотека, она их и закрывает
+  if ((ev->events & (UEV_SIGNAL | UEV_CHILD)) && ev->fd >= 0) {
+    close(ev->fd);
+    ev->fd = -1;
+  }
+
   // Освобождаем (сбрасываем) событие
   if (ev->is_static) {
     uevent_reset_static_ev(ev);
   } else {
     ev->uev = NULL; // Обнуляем ev->uev для динамических событий
-    free(ev);
+    uev_slab_release(base->ev_slab, ev);
   }
 }
 
+int64_t uev_base_timer_lag_ms(const uevent_base_t *base, uint64_t cron_time) {
+  return (int64_t)(timer_now(base) / timer_ticks_per_ms(base)) - (int64_t)cron_time;
+}
+
+bool uev_base_has_workers(const uevent_base_t *base) {
+  return base->worker_pool != NULL;
+}
+
 // логируем задержку таймера, если это таймер
 static void log_timer_delay_if_needed(uev_t *uev, short triggered_events, uint64_t cron_time) {
   if ((triggered_events & UEV_TIMEOUT) == 0) return;
 
-  uint64_t now_ms = tu_clock_gettime_monotonic_ms();
-  int64_t diff_ms = (int64_t)now_ms - (int64_t)cron_time;
+  // время итерации цикла переводим из тиков очереди таймеров в мс, как и cron_time
+  uevent_base_t *base = ATOM_LOAD_ACQ(uev->ev->base);
+  if (base == NULL) return;
+  uint64_t now = timer_now_cached(base) / timer_ticks_per_ms(base);
+  int64_t diff_ms = (int64_t)now - (int64_t)cron_time;
 
   if (syslog2_get_pri() & LOG_MASK(LOG_DEBUG)) {
-    syslog2(LOG_DEBUG, "[TIMER_DBG] name='%s' cron_time=%" PRIu64 " exec_time=%" PRIu64 " diff_ms=%" PRId64, uev->ev->name, cron_time, now_ms, diff_ms);
+    syslog2(LOG_DEBUG, "[TIMER_DBG] name='%s' cron_time=%" PRIu64 " exec_time=%" PRIu64 " diff_ms=%" PRId64, uev->ev->name, cron_time, now, diff_ms);
   } else if (diff_ms > 1000) {
-    syslog2(LOG_WARNING, "[TIMER_LAG] name='%s' cron_time=%" PRIu64 " exec_time=%" PRIu64 " diff_ms=%" PRId64, uev->ev->name, cron_time, now_ms, diff_ms);
+    syslog2(LOG_WARNING, "[TIMER_LAG] name='%s' cron_time=%" PRIu64 " exec_time=%" PRIu64 " diff_ms=%" PRId64, uev->ev->name, cron_time, now, diff_ms);
   }
 }
 
 static void dispatch_event_callback(uev_t *uev, short triggered_events, uint64_t cron_time) {
   FUNC_START_DEBUG;
-  if (!uevent_try_ref(uev)) return;
-
   uevent_t *ev = ATOM_LOAD_ACQ(uev->ev);
+  if (ev == NULL) return;
   uevent_base_t *base = atomic_load_explicit(&ev->base, memory_order_acquire);
 
   if ((base != NULL) && (base->worker_pool != NULL)) {
-    if (!atomic_load_explicit(&base->running, memory_order_acquire)) {
-      uevent_put(uev);
-      return;
+    // задача переживает итерацию: держим ссылку
+    if (!uevent_try_ref(uev)) return;
+    if (atomic_load_explicit(&base->running, memory_order_acquire)) {
+      uevent_worker_pool_insert(base->worker_pool, uev, triggered_events, cron_time);
     }
-    uevent_worker_pool_insert(base->worker_pool, uev, triggered_events, cron_time);
-  } else {
-    ev->cb_wrapper(ev, ev->fd, triggered_events, cron_time, ev->cb, ev->arg);
+    uevent_put(uev);
+    return;
   }
 
-  uevent_put(uev);
+  // колбэк в потоке цикла: до конца итерации событие не освобождается (см. retire_push),
+  // поэтому ссылка не берется, достаточно проверить отметку освобождения
+  if (uev_st_test(ev, UEV_ST_PENDING_FREE)) return;
+  ev->cb_wrapper(ev, ev->fd, triggered_events, cron_time, ev->cb, ev->arg);
 }
 
 // обработать callback события
@@ -256,7 +431,7 @@ static void uevent_handle_ev_cb(uevent_t *ev, short triggered_events, uint64_t c
   if ((ev == NULL) || (triggered_events == 0)) {
     return;
   }
-  if (atomic_load_explicit(&ev->pending_free, memory_order_acquire)) {
+  if (uev_st_test(ev, UEV_ST_PENDING_FREE)) {
     return;
   }
   uev_t *uev = ATOM_LOAD_ACQ(ev->uev);
@@ -276,61 +451,157 @@ static void uevent_handle_ev_cb(uevent_t *ev, short triggered_events, uint64_t c
 static inline bool uevent_base_has_events(const uevent_base_t *base) {
   int nev = atomic_load_explicit(&base->num_active_fd, memory_order_acquire);
   int ntm = atomic_load_explicit(&base->num_active_timers, memory_order_acquire);
-  return (nev > 0) || (ntm > 0);
+  int ncmd = atomic_load_explicit(&base->num_pending_cmds, memory_order_acquire);
+  return (nev > 0) || (ntm > 0) || (ncmd > 0) || !uev_post_ring_empty(base->post_ring);
 }
 
-// Инициализация массива свободных слотов
-static int uev_slots_init(uevent_base_t *base, int max_events) {
-  if (base == NULL) return -1;
+static inline uev_t *uev_seg_slot(const uevent_base_t *base, const uev_slot_seg_t *seg, unsigned int off) {
+  return (uev_t *)((char *)seg->slots + (size_t)off * base->slot_stride);
+}
 
-  pthread_mutex_init(&base->slots_mut, NULL);
+static inline size_t uev_seg_bytes(const uevent_base_t *base) {
+  return UEV_SLOT_SEG_SIZE * base->slot_stride;
+}
 
-  base->uev_arr = calloc(max_events, sizeof(uev_t));
-  if (base->uev_arr == NULL) {
+// опубликовать сегмент в каталоге: адрес записывается до счетчика, читатели видят только готовые
+static int uev_seg_dir_push(uevent_base_t *base, uev_t *slots) {
+  uev_seg_dir_t *dir = atomic_load_explicit(&base->seg_dir, memory_order_relaxed);
+  unsigned int cnt = dir ? atomic_load_explicit(&dir->cnt, memory_order_relaxed) : 0;
+  if (dir == NULL || cnt == dir->cap) {
+    unsigned int cap = dir ? dir->cap * 2 : 16U;
+    uev_seg_dir_t *next = malloc(sizeof(uev_seg_dir_t) + cap * sizeof(uev_t *));
+    if (next == NULL) return -1;
+    next->prev = dir;
+    next->cap = cap;
+    if (cnt > 0) memcpy(next->slots, dir->slots, cnt * sizeof(uev_t *));
+    atomic_init(&next->cnt, cnt);
+    atomic_store_explicit(&base->seg_dir, next, memory_order_release);
+    dir = next;
+  }
+  dir->slots[cnt] = slots;
+  atomic_store_explicit(&dir->cnt, cnt + 1, memory_order_release);
+  return 0;
+}
+
+// добавить сегмент в таблицу слотов, вызывается под slots_mut (или до публикации базы)
+static int uev_slots_grow(uevent_base_t *base) {
+  uev_slot_seg_t *segs = realloc(base->uev_segs, (base->uev_segs_cnt + 1) * sizeof(uev_slot_seg_t));
+  if (segs == NULL) return -1;
+  base->uev_segs = segs;
+
+  uev_slot_seg_t *seg = &segs[base->uev_segs_cnt];
+  seg->slots = mmap(NULL, uev_seg_bytes(base), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (seg->slots == MAP_FAILED) return -1;
+  uev_numa_bind(seg->slots, uev_seg_bytes(base), base->numa_node);
+  seg->free_offs = malloc(UEV_SLOT_SEG_SIZE * sizeof(unsigned short));
+  if (seg->free_offs == NULL) {
+    munmap(seg->slots, uev_seg_bytes(base));
     return -1;
   }
 
-  base->free_uev_arr = malloc(max_events * sizeof(unsigned int));
-  if (base->free_uev_arr == NULL) {
-    free(base->uev_arr);
+  // младшие смещения на вершине стека: сегмент заполняется с начала
+  for (unsigned int i = 0; i < UEV_SLOT_SEG_SIZE; i++) {
+    seg->free_offs[i] = (unsigned short)(UEV_SLOT_SEG_SIZE - 1 - i);
+  }
+  seg->free_cnt = UEV_SLOT_SEG_SIZE;
+  seg->released = false;
+  seg->gen_floor = 0;
+  if (uev_seg_dir_push(base, seg->slots) != 0) {
+    munmap(seg->slots, uev_seg_bytes(base));
+    free(seg->free_offs);
     return -1;
   }
 
-  for (unsigned int i = 0; i < (unsigned)max_events; i++) {
-    base->free_uev_arr[i] = i;
-  }
+  base->uev_segs_cnt++;
+  base->free_uev_cnt += UEV_SLOT_SEG_SIZE;
+  return 0;
+}
 
-  base->uev_arr_sz = (unsigned)max_events;
-  base->free_uev_arr_cnt = (unsigned)max_events;
+// Инициализация таблицы слотов: сегменты на max_events слотов
+static int uev_slots_init(uevent_base_t *base, int max_events) {
+  if (base == NULL) return -1;
+
+  pthread_mutex_init(&base->slots_mut, NULL);
 
+  unsigned int nsegs = ((unsigned)max_events + UEV_SLOT_SEG_SIZE - 1) / UEV_SLOT_SEG_SIZE;
+  for (unsigned int i = 0; i < nsegs; i++) {
+    if (uev_slots_grow(base) != 0) return -1;
+  }
+  base->uev_segs_min = nsegs;
+  base->uev_seg_hint = 0;
   return 0;
 }
 
-// Деинициализация массива свободных слотов
+// Деинициализация таблицы слотов
 static void uev_slots_deinit(uevent_base_t *base) {
   if (base == NULL) return;
   pthread_mutex_destroy(&base->slots_mut);
-  if (base->free_uev_arr) free(base->free_uev_arr);
-  base->free_uev_arr = NULL;
-  if (base->uev_arr) free(base->uev_arr);
-  base->uev_arr = NULL;
-  base->free_uev_arr_cnt = 0;
-  base->uev_arr_sz = 0;
+  for (unsigned int i = 0; i < base->uev_segs_cnt; i++) {
+    munmap(base->uev_segs[i].slots, uev_seg_bytes(base));
+    free(base->uev_segs[i].free_offs);
+  }
+  free(base->uev_segs);
+  base->uev_segs = NULL;
+  base->uev_segs_cnt = 0;
+  for (uev_seg_dir_t *dir = atomic_load(&base->seg_dir), *prev; dir != NULL; dir = prev) {
+    prev = dir->prev;
+    free(dir);
+  }
+  atomic_store(&base->seg_dir, NULL);
+  base->free_uev_cnt = 0;
+}
+
+static inline unsigned int uev_slots_capacity(const uevent_base_t *base) {
+  return base->uev_segs_cnt * UEV_SLOT_SEG_SIZE;
 }
 
-// Получение свободного слота
+// массив кучи после создания и каждого роста: realloc мог перенести его на другие страницы
+static void timer_heap_numa_bind(uevent_base_t *base) {
+  if (base->timer_heap == NULL || base->numa_node < 0) return;
+  size_t bytes = 0;
+  void *arr = mh_storage(base->timer_heap, &bytes);
+  uev_numa_bind(arr, bytes, base->numa_node);
+}
+
+// Получение свободного слота, при нехватке таблица растет на сегмент.
+// Вызывается под base_mut: вместе с таблицей растет куча таймеров.
 static uev_t *uev_get_unused(uevent_base_t *base) {
   if (base == NULL) return NULL;
 
   pthread_mutex_lock(&base->slots_mut);
-  if (base->free_uev_arr_cnt == 0) {
-    pthread_mutex_unlock(&base->slots_mut);
-    syslog2(LOG_ERR, "error: no ev_arr free slots left");
-    return NULL;
-  }
-  unsigned idx = base->free_uev_arr[--base->free_uev_arr_cnt];
+  while (base->uev_seg_hint < base->uev_segs_cnt && base->uev_segs[base->uev_seg_hint].free_cnt == 0) {
+    base->uev_seg_hint++;
+  }
+  if (base->uev_seg_hint == base->uev_segs_cnt) {
+    if ((uev_slots_grow(base) != 0) ||
+        (base->timer_heap && mh_reserve(base->timer_heap, uev_slots_capacity(base)) != 0)) {
+      pthread_mutex_unlock(&base->slots_mut);
+      syslog2(LOG_ERR, "error: failed to grow ev_arr slots=%u", uev_slots_capacity(base));
+      return NULL;
+    }
+    timer_heap_numa_bind(base);
+    syslog2(LOG_INFO, "[SLOTS] grown to slots=%u", uev_slots_capacity(base));
+  }
+
+  unsigned int seg_idx = base->uev_seg_hint;
+  uev_slot_seg_t *seg = &base->uev_segs[seg_idx];
+  unsigned int off = seg->free_offs[--seg->free_cnt];
+  if (seg->released) {
+    seg->released = false; // страницы вернутся обнуленными при первом обращении
+    base->uev_segs_released--;
+  }
+  base->free_uev_cnt--;
+
+  uev_t *uev = uev_seg_slot(base, seg, off);
+  uev->slot_idx = seg_idx * UEV_SLOT_SEG_SIZE + off;
+  // новое поколение старше всех выданных в сегменте, даже если страницы обнулялись
+  uint32_t gen = atomic_load_explicit(&uev->gen, memory_order_relaxed);
+  if (gen < seg->gen_floor) gen = seg->gen_floor;
+  if (++gen == 0) gen = 1; // 0 — пустой дескриптор
+  seg->gen_floor = gen;
+  atomic_store_explicit(&uev->gen, gen, memory_order_release);
   pthread_mutex_unlock(&base->slots_mut);
-  return &base->uev_arr[idx];
+  return uev;
 }
 
 // Возврат слота в список свободных
@@ -340,14 +611,31 @@ static int uev_return(uevent_base_t *base, uev_t *uev) {
     return -1;
   }
 
-  ptrdiff_t idx = uev - base->uev_arr;
-  if (idx < 0 || idx >= base->uev_arr_sz) {
+  pthread_mutex_lock(&base->slots_mut);
+  unsigned int seg_idx = uev->slot_idx / UEV_SLOT_SEG_SIZE;
+  unsigned int off = uev->slot_idx % UEV_SLOT_SEG_SIZE;
+  if (seg_idx >= base->uev_segs_cnt || uev_seg_slot(base, &base->uev_segs[seg_idx], off) != uev) {
+    pthread_mutex_unlock(&base->slots_mut);
     syslog2(LOG_ERR, "error: invalid arr idx");
     return -1;
   }
 
-  pthread_mutex_lock(&base->slots_mut);
-  base->free_uev_arr[base->free_uev_arr_cnt++] = (unsigned)idx;
+  uev_slot_seg_t *seg = &base->uev_segs[seg_idx];
+  seg->free_offs[seg->free_cnt++] = (unsigned short)off;
+  base->free_uev_cnt++;
+  if (seg_idx < base->uev_seg_hint) base->uev_seg_hint = seg_idx;
+
+  // после пика отдаем страницы опустевшего сегмента, если и без него остается
+  // хотя бы сегмент свободных резидентных слотов (иначе на границе будет дребезг)
+  if (seg->free_cnt == UEV_SLOT_SEG_SIZE && seg_idx >= base->uev_segs_min) {
+    unsigned int resident_free = base->free_uev_cnt - (base->uev_segs_released + 1) * UEV_SLOT_SEG_SIZE;
+    if (resident_free >= UEV_SLOT_SEG_SIZE &&
+        madvise(seg->slots, uev_seg_bytes(base), MADV_DONTNEED) == 0) {
+      seg->released = true;
+      base->uev_segs_released++;
+      syslog2(LOG_INFO, "[SLOTS] released pages of segment=%u", seg_idx);
+    }
+  }
   pthread_mutex_unlock(&base->slots_mut);
   return 0;
 }
@@ -356,12 +644,53 @@ uevent_base_t *uevent_base_new(int max_events) {
   return uevent_base_new_with_workers(max_events, UEVENT_DEFAULT_WORKERS_NUM);
 }
 
-static void init_base_defaults(uevent_base_t *base, int max_events) {
+// число CPU, на которых процессу разрешено выполняться
+static int available_cpus(void) {
+  cpu_set_t set;
+  if (sched_getaffinity(0, sizeof(set), &set) != 0) return (int)sysconf(_SC_NPROCESSORS_ONLN);
+  return CPU_COUNT(&set);
+}
+
+static void init_base_defaults(uevent_base_t *base, const uevent_base_args_t *args) {
   const uevent_t tpl = {.is_static = true};
   memcpy(&base->wakeup_event, &tpl, sizeof(tpl));
-  base->max_events = max_events;
+  base->max_events = args->max_events;
+  base->slot_stride = args->pad_slots ? UEV_SLOT_PADDED : sizeof(uev_t);
   base->epoll_fd = -1;
   base->worker_pool = NULL;
+  base->timer_backend = args->timer_backend;
+  base->hires_timers = args->hires_timers;
+  base->io_backend = args->io_backend;
+  base->timer_batch_max = args->timer_batch_max > 0 ? (unsigned)args->timer_batch_max : UEVENT_DEFAULT_TIMER_BATCH;
+  base->busy_poll_ns = (uint64_t)args->busy_poll_us * NSEC_PER_USEC;
+  if (base->busy_poll_ns != 0 && available_cpus() < 2) {
+    // на одном CPU опрос без сна только отнимает время у потока, который готовит событие
+    syslog2(LOG_NOTICE, "busy_poll_us=%d ignored: process runs on a single CPU", args->busy_poll_us);
+    base->busy_poll_ns = 0;
+  }
+  base->busy_window_ns = base->busy_poll_ns;
+  base->clock_fn = args->clock_fn;
+  base->clock_arg = args->clock_arg;
+  // виртуальные часы стартуют с показаний источника и дальше двигаются только циклом
+  atomic_store_explicit(&base->vclock, timer_now(base), memory_order_relaxed);
+  base->virtual_clock = args->virtual_clock;
+  base->num_prios = args->priorities > 1 ? (unsigned)args->priorities : 1U;
+  base->prio_budget = (unsigned)args->prio_budget;
+  base->changelist = args->changelist;
+}
+
+// размещение потока цикла и узел NUMA для памяти базы, -1 при недопустимых параметрах
+static int init_base_placement(uevent_base_t *base, const uevent_base_args_t *args) {
+  base->numa_node = -1;
+  if (args->loop_placement != NULL) {
+    if (uev_placement_init(&base->loop_place, args->loop_placement) != 0) return -1;
+    base->loop_placed = true;
+  }
+  if (args->numa_local) {
+    base->numa_node = uev_numa_node_of(base->loop_placed && base->loop_place.pin ? &base->loop_place.cpus : NULL);
+    syslog2(LOG_INFO, "base memory preferred on numa node=%d", base->numa_node);
+  }
+  return 0;
 }
 
 static void init_base_atomics(uevent_base_t *base) {
@@ -369,14 +698,37 @@ static void init_base_atomics(uevent_base_t *base) {
   atomic_store_explicit(&base->num_active_fd, 0, memory_order_release);
   atomic_store_explicit(&base->num_active_timers, 0, memory_order_release);
   atomic_store_explicit(&base->stopped, true, memory_order_release);
+  atomic_store_explicit(&base->cmd_head, NULL, memory_order_release);
+  atomic_store_explicit(&base->retire_head, NULL, memory_order_release);
+  atomic_store_explicit(&base->num_pending_cmds, 0, memory_order_release);
 }
 
 static int prepare_base_components(uevent_base_t *base,
-                                   int max_events,
-                                   int num_workers,
+                                   const uevent_base_args_t *args,
                                    int *wakeup_fd) {
-  base->epoll_fd = epoll_create1(0);
-  if (base->epoll_fd == -1) return -1;
+  int max_events = args->max_events;
+  if (base->io_backend == UEV_IO_URING) {
+    unsigned int entries = (unsigned int)max_events < UEV_URING_MAX_ENTRIES ? (unsigned int)max_events : UEV_URING_MAX_ENTRIES;
+    base->uring = uev_uring_create(entries < UEV_URING_MIN_ENTRIES ? UEV_URING_MIN_ENTRIES : entries);
+    if (base->uring == NULL) {
+      syslog2(LOG_NOTICE, "io_uring unavailable (%s), falling back to epoll", strerror(errno));
+      base->io_backend = UEV_IO_EPOLL;
+    }
+  }
+  if (base->io_backend == UEV_IO_EPOLL) {
+    base->epoll_fd = epoll_create1(0);
+    if (base->epoll_fd == -1) return -1;
+  }
+  if (args->stats) {
+    base->stats = uev_stats_create();
+    if (base->stats == NULL) return -1;
+  }
+
+  base->ev_slab = uev_slab_create(sizeof(uevent_t), args->pad_slots ? UEV_SLOT_PADDED : 16U);
+  if (base->ev_slab == NULL) return -1;
+
+  base->post_ring = uev_post_ring_create(args->post_queue_size > 0 ? (size_t)args->post_queue_size : UEVENT_DEFAULT_POST_QUEUE);
+  if (base->post_ring == NULL) return -1;
 
   *wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
   if (*wakeup_fd == -1) {
@@ -386,17 +738,36 @@ static int prepare_base_components(uevent_base_t *base,
 
   base->events = calloc(max_events, sizeof(struct epoll_event));
   if (!base->events) return -1;
+  uev_numa_bind(base->events, (size_t)max_events * sizeof(struct epoll_event), base->numa_node);
 
-  base->timer_heap = mh_create(max_events);
-  if (!base->timer_heap) return -1;
+
+  base->timer_batch = calloc(base->timer_batch_max, sizeof(expired_timer_info_t));
+  if (!base->timer_batch) return -1;
+  if (args->num_workers > 0) {
+    base->worker_batch = calloc(base->timer_batch_max, sizeof(uevent_worker_batch_item_t));
+    if (!base->worker_batch) return -1;
+  }
 
   if (uev_slots_init(base, max_events) != 0) return -1;
 
+  // куча таймеров рассчитана на все слоты таблицы и растет вместе с ней
+  if (base->timer_backend == UEV_TIMER_WHEEL) {
+    base->timer_wheel = uev_wheel_create(timer_now_update(base));
+    if (!base->timer_wheel) return -1;
+  } else {
+    (void)timer_now_update(base);
+    base->timer_heap = mh_create(uev_slots_capacity(base));
+    if (!base->timer_heap) return -1;
+    timer_heap_numa_bind(base);
+  }
+
   if (pthread_mutex_init(&base->base_mut, NULL) != 0) return -1;
+  if (pthread_mutex_init(&base->stale_mut, NULL) != 0) return -1;
   if (pthread_cond_init(&base->base_cond, NULL) != 0) return -1;
 
-  if (num_workers > 0) {
-    base->worker_pool = uevent_worker_pool_create(num_workers);
+  if (args->num_workers > 0) {
+    base->worker_pool = uevent_worker_pool_create_placed(args->num_workers, args->worker_affinity,
+                                                         args->worker_placement, args->worker_placement_cnt);
     if (base->worker_pool == NULL) return -1;
   }
 
@@ -410,28 +781,60 @@ static void cleanup_base_components(uevent_base_t *base, int wakeup_fd) {
   }
   pthread_cond_destroy(&base->base_cond);
   pthread_mutex_destroy(&base->base_mut);
+  pthread_mutex_destroy(&base->stale_mut);
+  free(base->stale_fds);
   uev_slots_deinit(base);
   if (base->timer_heap) mh_free(base->timer_heap);
+  uev_wheel_free(base->timer_wheel);
+  free(base->timer_batch);
+  free(base->worker_batch);
   free(base->events);
   if (wakeup_fd != -1) close(wakeup_fd);
   if (base->epoll_fd != -1) close(base->epoll_fd);
+  uev_uring_free(base->uring);
+  uev_stats_free(base->stats);
+  uev_post_ring_free(base->post_ring);
+  uev_slab_free(base->ev_slab);
+  ready_release(base);
+  free(base->changes);
 }
 
 // Создание новой базы событий с рабочими потоками
 uevent_base_t *uevent_base_new_with_workers(int max_events, int num_workers) {
-  if ((max_events <= 0) || (num_workers < 0)) {
+  uevent_base_args_t args = {
+      .max_events = max_events,
+      .num_workers = num_workers,
+      .timer_backend = UEV_TIMER_HEAP,
+  };
+  return uevent_base_new_with_args(&args);
+}
+
+// Создание новой базы событий по набору параметров
+uevent_base_t *uevent_base_new_with_args(const uevent_base_args_t *args) {
+  if ((args == NULL) || (args->max_events <= 0) || (args->num_workers < 0) || (args->timer_batch_max < 0) ||
+      (args->post_queue_size < 0) || (args->busy_poll_us < 0) || (args->priorities < 0) ||
+      (args->priorities > UINT8_MAX + 1) || (args->prio_budget < 0) || (args->worker_placement_cnt < 0)) {
+    return NULL;
+  }
+  if ((args->timer_backend != UEV_TIMER_HEAP) && (args->timer_backend != UEV_TIMER_WHEEL)) {
+    return NULL;
+  }
+  if ((args->io_backend != UEV_IO_EPOLL) && (args->io_backend != UEV_IO_URING)) {
     return NULL;
   }
 
   uevent_base_t *base = calloc(1, sizeof(uevent_base_t));
   if (!base) return NULL;
 
-  init_base_defaults(base, max_events);
+  init_base_defaults(base, args);
   init_base_atomics(base);
+  if (init_base_placement(base, args) != 0) {
+    free(base);
+    return NULL;
+  }
 
   int wakeup_event_fd = -1;
-  if (prepare_base_components(base, max_events, num_workers, &wakeup_event_fd) !=
-      0) {
+  if (prepare_base_components(base, args, &wakeup_event_fd) != 0) {
     cleanup_base_components(base, wakeup_event_fd);
     free(base);
     return NULL;
@@ -486,10 +889,17 @@ bool uevent_pending(uev_t *uev, int mask) {
   if (uev == NULL) return res;
   uevent_t *ev = ATOM_LOAD_RELAX(uev->ev);
 
-  if (((mask & UEV_TIMEOUT) != 0) && (atomic_load_explicit(&ev->active_timer, memory_order_acquire) != 0)) {
-    res = true;
+  if (((mask & UEV_TIMEOUT) != 0)) {
+    // непримененная команда из очереди базы важнее текущего состояния; ключ сбрасывается
+    // только после применения, поэтому смотрим на него, а не на флаг очереди
+    uint64_t key = atomic_load_explicit(&ev->cmd_key, memory_order_acquire);
+    if (key != UEV_CMD_NONE) {
+      res = key != UEV_CMD_DEL;
+    } else {
+      res = uev_st_test(ev, UEV_ST_ACTIVE_TIMER);
+    }
   }
-  if ((!res) && ((mask & UEV_FD_EVENTS) != 0) && (atomic_load_explicit(&ev->active_fd, memory_order_acquire) != 0)) {
+  if ((!res) && ((mask & UEV_FD_EVENTS) != 0) && (uev_st_test(ev, UEV_ST_ACTIVE_FD))) {
     res = true;
   }
   uevent_put(uev);
@@ -504,11 +914,45 @@ void uevent_active(uev_t *uev) {
   (void)uevent_add(uev, UEV_TIMEOUT_FIRE_NOW);
 }
 
-static uevent_t *uevent_alloc_ev(uevent_t *ev) {
+static uevent_t *uevent_alloc_ev(uevent_base_t *base, uevent_t *ev) {
   if (ev != NULL) return ev;
+  return uev_slab_alloc(base->ev_slab);
+}
 
-  uevent_t *event = calloc(1, sizeof(uevent_t));
-  return event;
+uev_t *uevent_signal_new(uevent_base_t *base, int signum, uevent_cb_t cb, void *arg, const char *name) {
+  if (base == NULL) return NULL;
+  sigset_t mask;
+  sigemptyset(&mask);
+  if (sigaddset(&mask, signum) != 0) return NULL;
+  // без блокировки сигнал уйдет обработчику по умолчанию, а не в signalfd
+  if (pthread_sigmask(SIG_BLOCK, &mask, NULL) != 0) return NULL;
+
+  int fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+  if (fd < 0) {
+    syslog2(LOG_ERR, "error: signalfd signum=%d: %s", signum, strerror(errno));
+    return NULL;
+  }
+  uev_t *uev = uevent_create_or_assign_event(NULL, base, fd, UEV_READ | UEV_SIGNAL | UEV_PERSIST, cb, arg, name);
+  if (uev == NULL) close(fd);
+  return uev;
+}
+
+uev_t *uevent_child_new(uevent_base_t *base, pid_t pid, uevent_cb_t cb, void *arg, const char *name) {
+  if (base == NULL || pid <= 0) return NULL;
+#ifdef SYS_pidfd_open
+  int fd = (int)syscall(SYS_pidfd_open, pid, 0);
+#else
+  int fd = -1;
+  errno = ENOSYS;
+#endif
+  if (fd < 0) {
+    syslog2(LOG_ERR, "error: pidfd_open pid=%d: %s", (int)pid, strerror(errno));
+    return NULL;
+  }
+  (void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+  uev_t *uev = uevent_create_or_assign_event(NULL, base, fd, UEV_READ | UEV_CHILD, cb, arg, name);
+  if (uev == NULL) close(fd);
+  return uev;
 }
 
 uev_t *uevent_create_or_assign_event(uevent_t *ev, uevent_base_t *base, int fd, short events, uevent_cb_t cb, void *arg, const char *name) {
@@ -529,7 +973,7 @@ uev_t *uevent_create_or_assign_event(uevent_t *ev, uevent_base_t *base, int fd,
       goto fail;
     }
   }
-  ev = uevent_alloc_ev(ev);
+  ev = uevent_alloc_ev(base, ev);
   if (ev == NULL) {
     goto fail;
   }
@@ -563,7 +1007,7 @@ fail_unlock:
   pthread_mutex_unlock(&base->base_mut);
 fail_event:
   if (!ev->is_static) {
-    free(ev);
+    uev_slab_release(base->ev_slab, ev);
   }
 fail:
   return NULL;
@@ -586,21 +1030,221 @@ static uint32_t convert_to_epoll_events(short event) {
   return epoll_events;
 }
 
+static bool timer_cmd_should_defer(uevent_base_t *base);
+
+// SQE из потока цикла уходят в ядро пачкой вместе с ожиданием, из других потоков — сразу
+static bool uring_should_flush(uevent_base_t *base) {
+  return timer_cmd_should_defer(base);
+}
+
+// поставить multishot poll на fd события, при смене маски старый poll снимается в той же пачке
+static int uring_ctl(uevent_base_t *base, uev_t *uev, uint32_t poll_mask, bool was_active) {
+  uevent_t *ev = ATOM_LOAD_RELAX(uev->ev);
+  bool flush = uring_should_flush(base);
+  if (was_active && uev_uring_poll_remove(base->uring, (uint64_t)(uintptr_t)uev, false) != 0) return -1;
+  return uev_uring_poll_add(base->uring, ev->fd, poll_mask, (uint64_t)(uintptr_t)uev, flush);
+}
+
+// одноразовое fd-событие держит регистрацию в epoll: после срабатывания ядро само выключает ее
+// (EPOLLONESHOT), повторный uevent_add включает ее одним EPOLL_CTL_MOD вместо DEL и ADD.
+// Выключенная регистрация событий не дает и снимается ядром при закрытии fd
+static bool fd_uses_oneshot(const uevent_base_t *base, const uevent_t *ev) {
+  return base->uring == NULL && ev != &base->wakeup_event && (ev->events & (UEV_PERSIST | UEV_EXCLUSIVE)) == 0;
+}
+
+static uint32_t fd_epoll_events(const uevent_base_t *base, const uevent_t *ev) {
+  uint32_t events = convert_to_epoll_events(ev->events) | EPOLLET;
+  if (ev->events & UEV_EXCLUSIVE) events |= EPOLLEXCLUSIVE;
+  if (fd_uses_oneshot(base, ev)) events |= EPOLLONESHOT;
+  return events;
+}
+
+// пометить fd с выключенной регистрацией освобожденного одноразового события
+static void stale_fd_mark(uevent_base_t *base, int fd) {
+  size_t word = (size_t)fd / 64U;
+  uint64_t bit = 1ULL << ((unsigned int)fd % 64U);
+  pthread_mutex_lock(&base->stale_mut);
+  if (word >= base->stale_words) {
+    size_t words = base->stale_words ? base->stale_words : 16U;
+    while (words <= word) words *= 2;
+    uint64_t *bits = realloc(base->stale_fds, words * sizeof(uint64_t));
+    if (bits == NULL) {
+      // без пометки новое событие на этом fd получит EEXIST, как до одноразовых регистраций
+      pthread_mutex_unlock(&base->stale_mut);
+      return;
+    }
+    memset(bits + base->stale_words, 0, (words - base->stale_words) * sizeof(uint64_t));
+    base->stale_fds = bits;
+    base->stale_words = words;
+  }
+  if ((base->stale_fds[word] & bit) == 0) {
+    base->stale_fds[word] |= bit;
+    atomic_fetch_add_explicit(&base->stale_cnt, 1, memory_order_relaxed);
+  }
+  pthread_mutex_unlock(&base->stale_mut);
+}
+
+// снять пометку fd, true — она была
+static bool stale_fd_take(uevent_base_t *base, int fd) {
+  if (atomic_load_explicit(&base->stale_cnt, memory_order_relaxed) == 0) return false;
+  size_t word = (size_t)fd / 64U;
+  uint64_t bit = 1ULL << ((unsigned int)fd % 64U);
+  bool was = false;
+  pthread_mutex_lock(&base->stale_mut);
+  if (word < base->stale_words && (base->stale_fds[word] & bit) != 0) {
+    base->stale_fds[word] &= ~bit;
+    atomic_fetch_sub_explicit(&base->stale_cnt, 1, memory_order_relaxed);
+    was = true;
+  }
+  pthread_mutex_unlock(&base->stale_mut);
+  return was;
+}
+
+// EPOLL_CTL_ADD. Успешный ADD означает, что старой регистрации на номере fd уже нет: пометка
+// снимается. EEXIST на помеченном fd — выключенная регистрация освобожденного события, ее
+// забираем; на непомеченном fd она принадлежит другому событию базы и не исправляется
+static int fd_epoll_add(uevent_base_t *base, int fd, struct epoll_event *ep_ev) {
+  int ret = epoll_ctl(base->epoll_fd, EPOLL_CTL_ADD, fd, ep_ev);
+  if (ret == 0) {
+    (void)stale_fd_take(base, fd);
+    return 0;
+  }
+  if (errno != EEXIST || !stale_fd_take(base, fd)) return ret;
+  if (ep_ev->events & EPOLLEXCLUSIVE) {
+    (void)epoll_ctl(base->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    return epoll_ctl(base->epoll_fd, EPOLL_CTL_ADD, fd, ep_ev);
+  }
+  return epoll_ctl(base->epoll_fd, EPOLL_CTL_MOD, fd, ep_ev);
+}
+
+// зарегистрировать fd в epoll (in_kernel — уже зарегистрирован), возвращает 0 или -1 (errno).
+// Регистрацию, которую ядро сняло без нас (fd закрыт, другой поток сделал DEL), ставим заново
+static int fd_epoll_ctl(uevent_base_t *base, int fd, bool in_kernel, struct epoll_event *ep_ev) {
+  if (!in_kernel) return fd_epoll_add(base, fd, ep_ev);
+  if (ep_ev->events & EPOLLEXCLUSIVE) {
+    // EPOLLEXCLUSIVE не допускает EPOLL_CTL_MOD: регистрация пересоздается
+    (void)epoll_ctl(base->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    return fd_epoll_add(base, fd, ep_ev);
+  }
+  int ret = epoll_ctl(base->epoll_fd, EPOLL_CTL_MOD, fd, ep_ev);
+  if (ret != 0 && errno == ENOENT) ret = fd_epoll_add(base, fd, ep_ev);
+  return ret;
+}
+
+// --- список изменений epoll: регистрации fd из потока цикла применяются итогом перед epoll_wait ---
+
+// записать изменение регистрации fd вместо вызова epoll_ctl; false — список не используется,
+// вызывать сразу. registered — был ли fd в ядре до этого изменения, ops — цена изменения в вызовах
+static bool changelist_record(uevent_base_t *base, uev_t *uev, bool registered, unsigned int ops) {
+  uevent_t *ev = ATOM_LOAD_RELAX(uev->ev);
+  if (!base->changelist || ev == &base->wakeup_event || timer_cmd_should_defer(base) ||
+      !atomic_load_explicit(&base->running, memory_order_acquire)) {
+    return false;
+  }
+
+  uev_change_t *ch = NULL;
+  if (uev_st_test(ev, UEV_ST_CHANGED)) {
+    for (unsigned int i = 0; i < base->changes_cnt; i++) {
+      if (base->changes[i].uev == uev) {
+        ch = &base->changes[i];
+        break;
+      }
+    }
+  }
+  if (ch == NULL) {
+    if (base->changes_cnt == base->changes_cap) {
+      unsigned int cap = base->changes_cap ? base->changes_cap * 2 : 64U;
+      uev_change_t *changes = realloc(base->changes, cap * sizeof(uev_change_t));
+      if (changes == NULL) return false;
+      base->changes = changes;
+      base->changes_cap = cap;
+    }
+    ch = &base->changes[base->changes_cnt++];
+    *ch = (uev_change_t){.uev = uev, .fd = ev->fd, .registered = registered, .ops = 0};
+    uev_st_set(ev, UEV_ST_CHANGED);
+  }
+  ch->ops += ops;
+  return true;
+}
+
+// отложенная регистрация не удалась: снимаем событие с fd, как если бы uevent_add вернул ошибку
+static void changelist_rollback(uevent_base_t *base, uev_t *uev, uevent_t *ev) {
+  syslog2(LOG_ERR, "error: deferred epoll_ctl failed name='%s' fd=%d: %s", ev->name, ev->fd, strerror(errno));
+  if (!atomic_deactivate_fd(ev)) return;
+  atomic_fetch_sub_explicit(&base->num_active_fd, 1, memory_order_acq_rel);
+  uevent_put(uev);
+}
+
+// применить итог изменений: состояние ядра сводится к текущему ACTIVE_FD событий.
+// Вызывается потоком цикла до retire_drain, пока события списка еще не уничтожены
+static void changelist_flush(uevent_base_t *base) {
+  unsigned long recorded = 0, issued = 0;
+  for (unsigned int i = 0; i < base->changes_cnt; i++) {
+    uev_change_t *ch = &base->changes[i];
+    recorded += ch->ops;
+    uevent_t *ev = ATOM_LOAD_ACQ(ch->uev->ev);
+    if (ev != NULL) uev_st_clear(ev, UEV_ST_CHANGED);
+
+    if (ev == NULL || !uev_st_test(ev, UEV_ST_ACTIVE_FD)) {
+      if (ch->registered) {
+        (void)epoll_ctl(base->epoll_fd, EPOLL_CTL_DEL, ch->fd, NULL);
+        issued++;
+      }
+      continue;
+    }
+
+    struct epoll_event ep_ev = {.events = fd_epoll_events(base, ev), .data.ptr = ch->uev};
+    // повтор при расхождении с ядром в счет не идет: он редок и без списка был бы тем же
+    issued += ch->registered && (ev->events & UEV_EXCLUSIVE) ? 2U : 1U;
+    if (fd_epoll_ctl(base, ch->fd, ch->registered, &ep_ev) != 0) {
+      changelist_rollback(base, ch->uev, ev);
+    } else if (fd_uses_oneshot(base, ev)) {
+      uev_st_set(ev, UEV_ST_ONESHOT);
+    }
+  }
+  base->changes_cnt = 0;
+  if (recorded > issued) atomic_fetch_add_explicit(&base->ctl_saved, recorded - issued, memory_order_relaxed);
+}
+
+unsigned long uevent_base_worker_stolen(const uevent_base_t *base) {
+  return base ? uevent_worker_pool_stolen(base->worker_pool) : 0;
+}
+
+int uevent_base_slab_stats(const uevent_base_t *base, uevent_slab_stats_t *out) {
+  if (base == NULL || out == NULL) return UEV_ERR_INVAL;
+  uev_slab_counters(base->ev_slab, &out->live, &out->slabs, &out->remote_frees);
+  return UEV_ERR_OK;
+}
+
+unsigned long uevent_base_ctl_saved(const uevent_base_t *base) {
+  if (base == NULL) return 0;
+  return atomic_load_explicit(&base->ctl_saved, memory_order_relaxed);
+}
+
 static int insert_fd_to_epoll(uev_t *uev) {
   uevent_t *ev = ATOM_LOAD_RELAX(uev->ev);
   uevent_base_t *base = atomic_load_explicit(&ev->base, memory_order_acquire);
   uint32_t epoll_events = convert_to_epoll_events(ev->events);
   struct epoll_event ep_ev = {0};
-  ep_ev.events = epoll_events | EPOLLET;
+  ep_ev.events = fd_epoll_events(base, ev);
   ep_ev.data.ptr = uev;
 
-  int was_active = atomic_load_explicit(&ev->active_fd, memory_order_acquire);
-  int op = was_active ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
-  int epoll_ret = epoll_ctl(base->epoll_fd, op, ev->fd, &ep_ev);
+  int was_active = uev_st_test(ev, UEV_ST_ACTIVE_FD);
+  // выключенная после срабатывания одноразовая регистрация включается через MOD
+  bool in_kernel = was_active || uev_st_test(ev, UEV_ST_ONESHOT);
+  int epoll_ret;
+  if (base->uring != NULL) {
+    epoll_ret = uring_ctl(base, uev, epoll_events, was_active);
+  } else if (changelist_record(base, uev, in_kernel, was_active && (ev->events & UEV_EXCLUSIVE) ? 2U : 1U)) {
+    epoll_ret = 0;
+  } else {
+    epoll_ret = fd_epoll_ctl(base, ev->fd, in_kernel, &ep_ev);
+    if (epoll_ret == 0 && fd_uses_oneshot(base, ev)) uev_st_set(ev, UEV_ST_ONESHOT);
+  }
 
   if (epoll_ret == 0) {
     if (!was_active) {
-      atomic_store_explicit(&ev->active_fd, true, memory_order_release);
+      uev_st_set(ev, UEV_ST_ACTIVE_FD);
       if (ev != &base->wakeup_event) {
         atomic_fetch_add_explicit(&base->num_active_fd, 1, memory_order_acq_rel);
         uevent_ref(uev);
@@ -611,9 +1255,44 @@ static int insert_fd_to_epoll(uev_t *uev) {
   return UEV_ERR_EPOLL;
 }
 
+// мкс монотонных часов для замера длительности колбэка
+static uint64_t stats_now_us(const uevent_base_t *base) {
+  struct timespec ts;
+  clock_gettime(base->hires_timers ? CLOCK_MONOTONIC : CLOCK_MONOTONIC_RAW, &ts);
+  return (uint64_t)ts.tv_sec * USEC_PER_SEC + (uint64_t)ts.tv_nsec / NSEC_PER_USEC;
+}
+
+// задержка срабатывания таймера в мкс: cron_time в мс, часы базы (виртуальные или пользовательские) в тиках
+static uint64_t stats_lag_us(const uevent_base_t *base, uint64_t cron_time) {
+  uint64_t now = timer_now(base);
+  uint64_t cron = cron_time * timer_ticks_per_ms(base);
+  if (now <= cron) return 0;
+  return base->hires_timers ? (now - cron) / NSEC_PER_USEC : (now - cron) * USEC_PER_MSEC;
+}
+
+// вызвать колбэк с замером задержки и длительности, вызывается под UEV_ST_LOCKED события
+static void stats_call_cb(uevent_base_t *base, uevent_t *ev, int fd, short events, uint64_t cron_time, uevent_cb_t cb, void *arg) {
+  if (ev->stat_entry == NULL) ev->stat_entry = uev_stats_lookup(base->stats, ev->name);
+
+  bool has_lag = (events & UEV_TIMEOUT) != 0 && cron_time != 0;
+  uint64_t lag = has_lag ? stats_lag_us(base, cron_time) : 0;
+  uint64_t start = stats_now_us(base);
+  cb(ev, fd, events, arg);
+  uint64_t finish = stats_now_us(base);
+
+  uev_stat_record(ev->stat_entry, has_lag, lag, finish - start);
+}
+
 static void uevent_user_cb_wrapper(uevent_t *ev, int fd, short events, uint64_t cron_time, uevent_cb_t cb, void *arg) {
   FUNC_START_DEBUG;
-  if (!uevent_try_lock(ev)) return;
+  if (!uevent_try_lock(ev)) {
+    // в режиме привязки срабатывание не теряется: воркер поставит задачу события заново
+    uevent_base_t *base = ATOM_LOAD_ACQ(ev->base);
+    if (base != NULL && uevent_worker_pool_is_affinity(base->worker_pool) && uev_st_test(ev, UEV_ST_IN_WORKER)) {
+      atomic_fetch_or(&ev->worker_pending, events);
+    }
+    return;
+  }
 
   uevent_base_t *base = ATOM_LOAD_ACQ(ev->base);
   if (base == NULL) {
@@ -629,26 +1308,13 @@ static void uevent_user_cb_wrapper(uevent_t *ev, int fd, short events, uint64_t
     return;
   }
 
-  // uint64_t start = tu_clock_gettime_monotonic_ms();
   if (cb) {
-    cb(ev, fd, events, arg);
+    if (base->stats != NULL) {
+      stats_call_cb(base, ev, fd, events, cron_time, cb, arg);
+    } else {
+      cb(ev, fd, events, arg);
+    }
   }
-  // uint64_t finish = tu_clock_gettime_monotonic_ms();
-
-  // Метрики:
-  // int64_t diff_cron_to_exec = (int64_t)start - (int64_t)cron_time;
-  // int64_t duration = (int64_t)finish - (int64_t)start;
-
-  // // Логирование метрик
-  // uev_t *uev = ATOM_LOAD_ACQ(ev->uev);
-  // if(!uev) return;
-  // syslog2(LOG_DEBUG,
-  //         "[TIMER_PROFILE] refcount=%d name='%s' diff_cron_to_exec=%" PRId64 " duration=%" PRId64 " cron_time=%" PRIu64,
-  //         ATOM_LOAD_ACQ(uev->refcount),
-  //         ev->name,
-  //         diff_cron_to_exec,
-  //         duration,
-  //         cron_time);
 
   uevent_unlock(ev);
 }
@@ -661,40 +1327,210 @@ static void uevent_init_ev(uevent_t *ev, uevent_base_t *base, int fd, short even
   ev->cb_wrapper = uevent_user_cb_wrapper;
   ev->arg = arg;
   atomic_store_explicit(&ev->base, base, memory_order_release);
-  atomic_store_explicit(&ev->modification_lock, false, memory_order_release);
-  atomic_store_explicit(&ev->active_fd, 0, memory_order_release);
-  atomic_store_explicit(&ev->active_timer, 0, memory_order_release);
-  atomic_store_explicit(&ev->pending_free, false, memory_order_relaxed);
-  ev->timer_node.key = 0;
+  // бит воркера сохраняем: переиспользуемое событие могло еще стоять в пуле
+  atomic_fetch_and_explicit(&ev->state, UEV_ST_IN_WORKER, memory_order_release);
+  memset(&ev->wheel_node, 0, sizeof(ev->wheel_node));
+  ev->cmd_next = NULL;
+  ev->priority = 0;
+  atomic_store_explicit(&ev->cmd_key, UEV_CMD_NONE, memory_order_relaxed);
+  atomic_store_explicit(&ev->worker_pending, 0, memory_order_relaxed);
+  ev->stat_entry = NULL;
   if (name != NULL) {
     ev->name = name;
   }
 }
 
-static void insert_timer_to_heap(uev_t *uev, uint64_t cur_time_ms, int timeout_ms, bool no_lock) {
+// --- очередь таймеров: общий интерфейс для кучи и колеса, вызывается под base_mut ---
+
+// ближайшее время срабатывания (для колеса — нижняя граница), false если таймеров нет
+static bool timer_q_next_key(uevent_base_t *base, uint64_t *key) {
+  if (base->timer_backend == UEV_TIMER_WHEEL) {
+    return uev_wheel_next_expiry(base->timer_wheel, key);
+  }
+  minheap_node_t *min = mh_get_min(base->timer_heap);
+  if (min == NULL) return false;
+  *key = min->key;
+  return true;
+}
+
+// вставить или перепланировать таймер, возвращает true если он стал ближайшим
+static bool timer_q_insert(uevent_base_t *base, uevent_t *ev, uint64_t key) {
+  if (base->timer_backend == UEV_TIMER_WHEEL) {
+    uint64_t before = UINT64_MAX;
+    uint64_t after = UINT64_MAX;
+    (void)timer_q_next_key(base, &before);
+    ev->wheel_node.expires = key;
+    uev_wheel_add(base->timer_wheel, &ev->wheel_node);
+    (void)timer_q_next_key(base, &after);
+    return after < before;
+  }
+  ev->timer_node.key = key;
+  mh_insert(base->timer_heap, &ev->timer_node);
+  return mh_get_min(base->timer_heap) == &ev->timer_node;
+}
+
+// время срабатывания таймера, узлы кучи и колеса лежат в union
+static inline uint64_t timer_q_key(const uevent_base_t *base, const uevent_t *ev) {
+  return base->timer_backend == UEV_TIMER_WHEEL ? ev->wheel_node.expires : ev->timer_node.key;
+}
+
+static void timer_q_remove(uevent_base_t *base, uevent_t *ev) {
+  if (base->timer_backend == UEV_TIMER_WHEEL) {
+    uev_wheel_del(base->timer_wheel, &ev->wheel_node);
+  } else {
+    mh_delete_node(base->timer_heap, &ev->timer_node);
+  }
+}
+
+// извлечь истекший к моменту now таймер или NULL
+static uevent_t *timer_q_pop_expired(uevent_base_t *base, uint64_t now) {
+  if (base->timer_backend == UEV_TIMER_WHEEL) {
+    uev_wheel_node_t *node = uev_wheel_pop_expired(base->timer_wheel, now);
+    return node ? container_of(node, uevent_t, wheel_node) : NULL;
+  }
+  minheap_node_t *min = mh_get_min(base->timer_heap);
+  if (min == NULL || min->key > now) return NULL;
+  minheap_node_t *expired = mh_extract_min(base->timer_heap);
+  return expired ? container_of(expired, uevent_t, timer_node) : NULL;
+}
+
+// извлечь любой таймер (для очистки) или NULL
+static uevent_t *timer_q_pop_any(uevent_base_t *base) {
+  if (base->timer_backend == UEV_TIMER_WHEEL) {
+    uev_wheel_node_t *node = uev_wheel_pop_any(base->timer_wheel);
+    return node ? container_of(node, uevent_t, wheel_node) : NULL;
+  }
+  minheap_node_t *expired = mh_extract_min(base->timer_heap);
+  return expired ? container_of(expired, uevent_t, timer_node) : NULL;
+}
+
+// поставить таймер в очередь таймеров, вызывается под base_mut
+static bool timer_arm_locked(uevent_base_t *base, uev_t *uev, uint64_t key) {
+  uevent_t *ev = ATOM_LOAD_ACQ(uev->ev);
+  bool is_first = timer_q_insert(base, ev, key);
+
+  if (!uev_st_test(ev, UEV_ST_ACTIVE_TIMER)) {
+    atomic_fetch_add_explicit(&base->num_active_timers, 1, memory_order_acq_rel);
+    uev_st_set(ev, UEV_ST_ACTIVE_TIMER);
+    uevent_ref(uev);
+  }
+  return is_first;
+}
+
+// --- очередь команд таймеров: другие потоки не берут base_mut, цикл применяет команды пачкой ---
+
+// true, если вызов идет не из потока работающего цикла и команду нужно отложить
+static bool timer_cmd_should_defer(uevent_base_t *base) {
+  if (!atomic_load_explicit(&base->running, memory_order_acquire)) return false;
+  return !pthread_equal(pthread_self(), base->loop_thread);
+}
+
+// время для нового таймера: в потоке цикла — время итерации, иначе текущие часы
+static uint64_t timer_now_for_add(uevent_base_t *base) {
+  if (!timer_cmd_should_defer(base) && atomic_load_explicit(&base->running, memory_order_acquire)) {
+    return timer_now_cached(base);
+  }
+  return timer_now(base);
+}
+
+// записать команду в событие и поставить его в очередь базы, если его там еще нет
+static void timer_cmd_post(uevent_base_t *base, uev_t *uev, uint64_t key) {
+  uevent_t *ev = ATOM_LOAD_RELAX(uev->ev);
+
+  // повторная команда для уже стоящего в очереди события просто перезаписывает предыдущую
+  atomic_store(&ev->cmd_key, key);
+  if (uev_st_set(ev, UEV_ST_CMD_QUEUED)) return;
+
+  uevent_ref(uev); // ссылка очереди, снимается после применения команды
+  atomic_fetch_add_explicit(&base->num_pending_cmds, 1, memory_order_acq_rel);
+
+  uevent_t *head = atomic_load_explicit(&base->cmd_head, memory_order_relaxed);
+  do {
+    ev->cmd_next = head;
+  } while (!atomic_compare_exchange_weak(&base->cmd_head, &head, ev));
+
+  // будим цикл только первой командой пачки
+  if (head == NULL) {
+    uevent_base_wakeup(base);
+  }
+}
+
+static void remove_event_from_heap(uev_t *uev, bool no_lock);
+
+static void timer_cmd_exec_locked(uevent_base_t *base, uev_t *uev, uint64_t key) {
+  uevent_t *ev = ATOM_LOAD_ACQ(uev->ev);
+  if (key == UEV_CMD_DEL) {
+    remove_event_from_heap(uev, true);
+  } else if (!uev_st_test(ev, UEV_ST_PENDING_FREE)) {
+    (void)timer_arm_locked(base, uev, key);
+  }
+}
+
+// применить (или отбросить) все накопленные команды, вызывается под base_mut
+static void timer_cmd_apply_locked(uevent_base_t *base, bool discard) {
+  uevent_t *ev = atomic_exchange(&base->cmd_head, NULL);
+
+  // стек хранит команды в обратном порядке, разворачиваем
+  uevent_t *fifo = NULL;
+  while (ev != NULL) {
+    uevent_t *next = ev->cmd_next;
+    ev->cmd_next = fifo;
+    fifo = ev;
+    ev = next;
+  }
+
+  while (fifo != NULL) {
+    ev = fifo;
+    fifo = ev->cmd_next;
+    uev_t *uev = ev->uev;
+
+    // ключ сбрасывается в UEV_CMD_NONE только за примененной командой: uevent_pending
+    // отвечает по нему, пока более новая команда не применена, даже после снятия флага
+    uint64_t key = atomic_load(&ev->cmd_key);
+    while (key != UEV_CMD_NONE) {
+      if (!discard) timer_cmd_exec_locked(base, uev, key);
+      if (atomic_compare_exchange_strong(&ev->cmd_key, &key, UEV_CMD_NONE)) break;
+    }
+    uev_st_clear(ev, UEV_ST_CMD_QUEUED);
+    // команда, записанная до снятия флага, в очередь не встала: догоняем ее здесь
+    for (key = atomic_load(&ev->cmd_key); key != UEV_CMD_NONE;) {
+      if (!discard) timer_cmd_exec_locked(base, uev, key);
+      if (atomic_compare_exchange_strong(&ev->cmd_key, &key, UEV_CMD_NONE)) break;
+    }
+
+    atomic_fetch_sub_explicit(&base->num_pending_cmds, 1, memory_order_acq_rel);
+    uevent_put(uev);
+  }
+}
+
+static void timer_cmd_apply(uevent_base_t *base, bool discard) {
+  if (atomic_load_explicit(&base->cmd_head, memory_order_acquire) == NULL) return;
+  (void)pthread_mutex_lock(&base->base_mut);
+  timer_cmd_apply_locked(base, discard);
+  (void)pthread_mutex_unlock(&base->base_mut);
+}
+
+// now и delay в тиках очереди таймеров базы (мс или нс)
+static void insert_timer_to_heap(uev_t *uev, uint64_t now, uint64_t delay, bool no_lock) {
   uevent_t *ev = ATOM_LOAD_ACQ(uev->ev);
   uevent_base_t *base = ATOM_LOAD_ACQ(ev->base);
   if (!base) return;
 
+  uint64_t new_key = now + delay;
+
+  if (!no_lock && timer_cmd_should_defer(base)) {
+    timer_cmd_post(base, uev, new_key);
+    return;
+  }
+
   if (!no_lock && pthread_mutex_lock(&base->base_mut) != 0) {
     syslog2(LOG_ERR, "error locking base mutex");
     return;
   }
 
-  timeout_ms = timeout_ms >= 0 ? timeout_ms : 0;
-  uint64_t new_key = cur_time_ms + (unsigned)timeout_ms;
-  ev->timer_node.key = new_key;
-
-  mh_insert(base->timer_heap, &ev->timer_node);
-
-  if (!ATOM_LOAD_ACQ(ev->active_timer)) {
-    atomic_fetch_add_explicit(&base->num_active_timers, 1, memory_order_acq_rel);
-    atomic_store_explicit(&ev->active_timer, true, memory_order_release);
-    uevent_ref(uev);
-  }
+  bool is_first = timer_arm_locked(base, uev, new_key);
 
-  bool wakeup = !ATOM_LOAD_ACQ(base->wakeup_fd_written) &&
-                mh_get_min(base->timer_heap) == &ev->timer_node;
+  bool wakeup = !ATOM_LOAD_ACQ(base->wakeup_fd_written) && is_first;
 
   if (!no_lock) {
     pthread_mutex_unlock(&base->base_mut);
@@ -705,11 +1541,12 @@ static void insert_timer_to_heap(uev_t *uev, uint64_t cur_time_ms, int timeout_m
   }
 }
 
-static int uevent_add_internal_unsafe(uevent_t *ev, uint64_t cur_time_ms, int timeout_ms, bool no_lock) {
+// delay в тиках очереди таймеров, отрицательный — сработать немедленно даже без UEV_TIMEOUT
+static int uevent_add_internal_unsafe(uevent_t *ev, uint64_t now, int64_t delay, bool no_lock) {
   TINIT;
   TMARK(10, "uevent_add_internal");
 
-  if (atomic_load_explicit(&ev->pending_free, memory_order_acquire)) {
+  if (uev_st_test(ev, UEV_ST_PENDING_FREE)) {
     TMARK(10, "uevent_add_internal");
     return UEV_ERR_PENDING_FREE;
   }
@@ -722,14 +1559,15 @@ static int uevent_add_internal_unsafe(uevent_t *ev, uint64_t cur_time_ms, int ti
       return ret;
     }
   }
-  if (((ev->events & UEV_TIMEOUT) != 0) || (timeout_ms < 0)) {
-    insert_timer_to_heap(ev->uev, cur_time_ms, timeout_ms, no_lock);
+  if (((ev->events & UEV_TIMEOUT) != 0) || (delay < 0)) {
+    insert_timer_to_heap(ev->uev, now, delay > 0 ? (uint64_t)delay : 0U, no_lock);
   }
   TMARK(10, "uevent_add_internal");
   return ret;
 }
 
-int uevent_add(uev_t *uev, int timeout_ms) {
+// общая часть uevent_add/uevent_add_us, timeout в мс или мкс
+static int uevent_add_common(uev_t *uev, int timeout, bool timeout_in_us) {
   if (uev == NULL) {
     return UEV_ERR_INVAL;
   }
@@ -742,23 +1580,52 @@ int uevent_add(uev_t *uev, int timeout_ms) {
     uevent_put(uev);
     return UEV_ERR_BUSY;
   }
-  if (timeout_ms == -2) {
-    timeout_ms = atomic_load_explicit(&uev->ev->timeout_ms, memory_order_acquire);
+  if (!timeout_in_us && timeout == UEV_TIMEOUT_FROM_EVENT) {
+    timeout = atomic_load_explicit(&uev->ev->timeout_ms, memory_order_acquire);
   }
-  int ret = uevent_add_internal_unsafe(ev, tu_clock_gettime_monotonic_ms(), timeout_ms, false);
+
+  uevent_base_t *base = ATOM_LOAD_ACQ(ev->base);
+  uint64_t ticks_per_ms = timer_ticks_per_ms(base);
+  int64_t delay = -1;
+  if (timeout >= 0 && !timeout_in_us) {
+    delay = (int64_t)timeout * (int64_t)ticks_per_ms;
+  } else if (timeout >= 0) {
+    // без hires_timers микросекунды округляются вверх до целой миллисекунды
+    delay = ticks_per_ms == 1U ? ((int64_t)timeout + USEC_PER_MSEC - 1) / USEC_PER_MSEC
+                               : (int64_t)timeout * NSEC_PER_USEC;
+  }
+  uint64_t now = base ? timer_now_for_add(base) : 0U;
+
+  int ret = uevent_add_internal_unsafe(ev, now, delay, false);
   uevent_unlock(ev);
   uevent_put(uev);
   return ret;
 }
 
-static void remove_event_from_epoll(uev_t *uev) {
+int uevent_add(uev_t *uev, int timeout_ms) {
+  return uevent_add_common(uev, timeout_ms, false);
+}
+
+int uevent_add_us(uev_t *uev, int timeout_us) {
+  return uevent_add_common(uev, timeout_us, true);
+}
+
+// снять fd-событие; fired — снятие после срабатывания одноразового события в потоке цикла
+static void remove_event_from_epoll(uev_t *uev, bool fired) {
   uevent_t *ev = ATOM_LOAD_RELAX(uev->ev);
   uevent_base_t *base = ATOM_LOAD_ACQ(ev->base);
   if (base == NULL) return;
   if (!atomic_deactivate_fd(ev)) return;
 
   if (internal_is_fd_event(ev)) {
-    (void)epoll_ctl(base->epoll_fd, EPOLL_CTL_DEL, ev->fd, NULL);
+    if (fired && uev_st_test(ev, UEV_ST_ONESHOT)) {
+      // ядро уже выключило регистрацию, она остается для повторного uevent_add
+    } else if (base->uring != NULL) {
+      (void)uev_uring_poll_remove(base->uring, (uint64_t)(uintptr_t)uev, uring_should_flush(base));
+    } else {
+      uev_st_clear(ev, UEV_ST_ONESHOT);
+      if (!changelist_record(base, uev, true, 1U)) (void)epoll_ctl(base->epoll_fd, EPOLL_CTL_DEL, ev->fd, NULL);
+    }
   }
 
   if (ev != &base->wakeup_event) {
@@ -772,16 +1639,24 @@ static void remove_event_from_heap(uev_t *uev, bool no_lock) {
   uevent_base_t *base = atomic_load_explicit(&ev->base, memory_order_acquire);
   if (base == NULL) return;
 
+  if (!no_lock && timer_cmd_should_defer(base)) {
+    if (uev_st_test(ev, UEV_ST_ACTIVE_TIMER) ||
+        uev_st_test(ev, UEV_ST_CMD_QUEUED)) {
+      timer_cmd_post(base, uev, UEV_CMD_DEL);
+    }
+    return;
+  }
+
   if (!atomic_deactivate_timer(ev)) {
     return;
   }
   if (!no_lock) {
     if (pthread_mutex_lock(&base->base_mut) != 0) {
-      atomic_store_explicit(&ev->active_timer, true, memory_order_release);
+      uev_st_set(ev, UEV_ST_ACTIVE_TIMER);
       return;
     }
   }
-  mh_delete_node(base->timer_heap, &ev->timer_node);
+  timer_q_remove(base, ev);
   atomic_fetch_sub_explicit(&base->num_active_timers, 1, memory_order_acq_rel);
   if (!no_lock) {
     (void)pthread_mutex_unlock(&base->base_mut);
@@ -789,7 +1664,26 @@ static void remove_event_from_heap(uev_t *uev, bool no_lock) {
   uevent_put(uev);
 }
 
-int uevent_del(uev_t *uev) {
+int uevent_set_fd_events(uev_t *uev, short events) {
+  if (uev == NULL) return UEV_ERR_INVAL;
+  if (uevent_try_ref(uev) == NULL) return UEV_ERR_PENDING_FREE;
+
+  uevent_t *ev = ATOM_LOAD_RELAX(uev->ev);
+  int ret = UEV_ERR_OK;
+  if (ev->fd < 0 || uev_st_test(ev, UEV_ST_PENDING_FREE)) {
+    ret = ev->fd < 0 ? UEV_ERR_INVAL : UEV_ERR_PENDING_FREE;
+  } else if ((events & UEV_FD_EVENTS) == 0) {
+    remove_event_from_epoll(uev, false);
+    ev->events = (short)(ev->events & ~UEV_FD_EVENTS);
+  } else {
+    ev->events = (short)((ev->events & ~UEV_FD_EVENTS) | (events & UEV_FD_EVENTS));
+    ret = insert_fd_to_epoll(uev);
+  }
+  uevent_put(uev);
+  return ret;
+}
+
+static int event_del(uev_t *uev, bool fired) {
   FUNC_START_DEBUG;
   TINIT;
   TMARK(10, "uevent_del");
@@ -806,7 +1700,8 @@ int uevent_del(uev_t *uev) {
   uevent_t *ev = ATOM_LOAD_RELAX(uev->ev);
 
   syslog2(LOG_DEBUG, "[UEVENT_DEL] deleting event name='%s'", ev->name);
-  remove_event_from_epoll(uev);
+  atomic_fetch_add_explicit(&ev->del_seq, 1, memory_order_acq_rel);
+  remove_event_from_epoll(uev, fired);
   remove_event_from_heap(uev, false);
   uevent_put(uev);
 
@@ -814,29 +1709,22 @@ int uevent_del(uev_t *uev) {
   return UEV_ERR_OK;
 }
 
-typedef struct {
-  uevent_t *ev;
-  uint64_t cron_time;
-} expired_timer_info_t;
-
-typedef struct {
-  expired_timer_info_t *batch;
-  int *count;
-  int capacity;
-} collection_context_t;
+int uevent_del(uev_t *uev) {
+  return event_del(uev, false);
+}
 
 // если это PERSIST-таймер и не помечен на удаление — перепланировать
 static void cron_persist_event_if_needed_internal_unsafe(uevent_base_t *base, uev_t *uev, uint64_t cron_key) {
   if (!uev) return;
 
   uevent_t *ev = ATOM_LOAD_ACQ(uev->ev);
-  if (!ev || ATOM_LOAD_ACQ(ev->pending_free) || !base || !ATOM_LOAD_ACQ(base->running)) return;
+  if (!ev || uev_st_test(ev, UEV_ST_PENDING_FREE) || !base || !ATOM_LOAD_ACQ(base->running)) return;
 
   if (!internal_is_persist_timer(ev)) return;
 
   int timeout = ATOM_LOAD_ACQ(ev->timeout_ms);
   timeout = get_min_timeout_internal(timeout);
-  insert_timer_to_heap(uev, cron_key, timeout, true);
+  insert_timer_to_heap(uev, cron_key, (uint64_t)timeout * timer_ticks_per_ms(base), true);
 }
 
 // вызвать колбэк таймера, если он есть
@@ -845,97 +1733,157 @@ static void call_cb_if_exists(uevent_t *ev, uint64_t cron_key) {
   if (ev->cb != NULL) uevent_handle_ev_cb(ev, UEV_TIMEOUT, cron_key);
 }
 
-// обработать все истекшие таймеры
-static void uevent_handle_timers(uevent_base_t *base) {
-  if (!atomic_load_explicit(&base->running, memory_order_acquire)) return;
-
-  FUNC_START_DEBUG;
+// извлечь до timer_batch_max истекших таймеров за один захват base_mut, PERSIST перевзводятся сразу
+static unsigned int collect_expired_timers(uevent_base_t *base) {
   TINIT;
-  TMARK(0, "START");
-
-  if (base == NULL) return;
-
-  if (!atomic_load_explicit(&base->running, memory_order_acquire)) {
-    syslog2(LOG_DEBUG, "[TIMER_HANDLE] event loop is not running. processing timers aborted");
-    return;
-  }
-
   TMARK(10, "mutex_lock base");
   (void)pthread_mutex_lock(&base->base_mut);
   TMARK(10, "mutex_lock base OK");
 
-  uint64_t now = tu_clock_gettime_monotonic_ms();
-  uint16_t max = 500;
-
-  minheap_node_t *prev = NULL;
-  while (max-- > 0) {
-    minheap_node_t *min = mh_get_min(base->timer_heap);
-    if (min == NULL) break;
+  uint64_t now = timer_now_cached(base);
+  uint64_t ticks_per_ms = timer_ticks_per_ms(base);
+  unsigned int count = 0;
 
-    if (min->key > now) break;
+  while (count < base->timer_batch_max) {
+    uevent_t *ev = timer_q_pop_expired(base, now);
+    if (ev == NULL) break;
 
-    if (prev == min) break;
-
-    TMARK(10, "extract_min");
-    minheap_node_t *expired = mh_extract_min(base->timer_heap);
-    TMARK(10, "extract_min ok");
-    if (expired == NULL) break;
-
-    uint64_t cron = expired->key;
-    uevent_t *ev = container_of(expired, uevent_t, timer_node);
+    uint64_t cron = timer_q_key(base, ev);
     uev_t *uev = ATOM_LOAD_ACQ(ev->uev);
     if (!uev) {
       syslog2(LOG_NOTICE, "[TIMER] Skipping timer with NULL uev, name='%s'", ev->name);
       continue;
     }
 
-    atomic_store_explicit(&ev->active_timer, false, memory_order_release);
+    uev_st_clear(ev, UEV_ST_ACTIVE_TIMER);
     atomic_fetch_sub_explicit(&base->num_active_timers, 1, memory_order_acq_rel);
 
-    if (uevent_put(uev)) continue; // после извлечения из кучи нужно удалить ссылку
-
-    TMARK(10, "cron_persist_timer_if_needed_internal");
+    // ссылка таймера переходит в пачку и снимается после вызова колбэка
     cron_persist_event_if_needed_internal_unsafe(base, uev, cron);
-    TMARK(10, "cron_persist_timer_if_needed_internal ok");
 
-    (void)pthread_mutex_unlock(&base->base_mut);
+    expired_timer_info_t *item = &base->timer_batch[count++];
+    item->uev = uev;
+    item->cron_time = cron / ticks_per_ms; // колбэки получают время в мс
+    item->del_seq = atomic_load_explicit(&ev->del_seq, memory_order_acquire);
+  }
 
-    TMARK(10, "call_cb_if_exists");
-    call_cb_if_exists(ev, cron);
-    TMARK(10, "call_cb_if_exists OK");
+  (void)pthread_mutex_unlock(&base->base_mut);
+  TMARK(10, "collect FINISH");
+  return count;
+}
 
-    TMARK(10, "mutex lock base");
-    (void)pthread_mutex_lock(&base->base_mut);
-    TMARK(10, "mutex lock base ok");
+// true, если колбэк таймера из пачки еще нужно вызвать
+static bool expired_timer_still_wanted(const expired_timer_info_t *item) {
+  uevent_t *ev = ATOM_LOAD_ACQ(item->uev->ev);
+  if (ev == NULL || ev->cb == NULL || uev_st_test(ev, UEV_ST_PENDING_FREE)) return false;
+  // uevent_del после извлечения (например, из колбэка соседнего таймера) отменяет срабатывание
+  return atomic_load_explicit(&ev->del_seq, memory_order_acquire) == item->del_seq;
+}
+
+// уровень приоритета таймера из пачки
+static unsigned int expired_timer_prio(const expired_timer_info_t *item) {
+  uevent_t *ev = ATOM_LOAD_ACQ(item->uev->ev);
+  return ev != NULL ? ev->priority : 0U;
+}
+
+// устойчивая сортировка пачки по приоритету: вставками, пачка ограничена timer_batch_max
+static void sort_expired_timers(uevent_base_t *base, unsigned int count) {
+  for (unsigned int i = 1; i < count; i++) {
+    expired_timer_info_t item = base->timer_batch[i];
+    unsigned int prio = expired_timer_prio(&item);
+    unsigned int j = i;
+    for (; j > 0 && expired_timer_prio(&base->timer_batch[j - 1]) > prio; j--) {
+      base->timer_batch[j] = base->timer_batch[j - 1];
+    }
+    base->timer_batch[j] = item;
   }
+}
 
-  (void)pthread_mutex_unlock(&base->base_mut);
+// раздать колбэки пачки: в пул воркеров одной вставкой или по очереди в потоке цикла
+static void dispatch_expired_timers(uevent_base_t *base, unsigned int count) {
+  if (base->num_prios > 1) sort_expired_timers(base, count);
+  if (base->worker_pool == NULL) {
+    for (unsigned int i = 0; i < count; i++) {
+      expired_timer_info_t *item = &base->timer_batch[i];
+      bool wanted = expired_timer_still_wanted(item);
+      uev_t *uev = item->uev;
+      item->uev = NULL;
+      // ссылку таймера снимаем до колбэка, как и без пачки: колбэк держит свою
+      if (uevent_put(uev) || !wanted) continue;
+      call_cb_if_exists(ATOM_LOAD_ACQ(uev->ev), item->cron_time);
+    }
+    return;
+  }
+
+  if (!atomic_load_explicit(&base->running, memory_order_acquire)) return;
+
+  int n = 0;
+  for (unsigned int i = 0; i < count; i++) {
+    expired_timer_info_t *item = &base->timer_batch[i];
+    if (!expired_timer_still_wanted(item)) continue;
+    log_timer_delay_if_needed(item->uev, UEV_TIMEOUT, item->cron_time);
+    base->worker_batch[n].uev = item->uev;
+    base->worker_batch[n].cron_time = item->cron_time;
+    base->worker_batch[n].triggered_events = UEV_TIMEOUT;
+    n++;
+  }
+  (void)uevent_worker_pool_insert_batch(base->worker_pool, base->worker_batch, n);
+}
+
+// обработать истекшие таймеры: одна пачка за итерацию цикла
+static void uevent_handle_timers(uevent_base_t *base) {
+  if (!atomic_load_explicit(&base->running, memory_order_acquire)) return;
+
+  FUNC_START_DEBUG;
+  TINIT;
+  TMARK(0, "START");
+
+  unsigned int count = collect_expired_timers(base);
+  if (count == 0) return;
+
+  dispatch_expired_timers(base, count);
+
+  for (unsigned int i = 0; i < count; i++) {
+    if (base->timer_batch[i].uev != NULL) uevent_put(base->timer_batch[i].uev);
+  }
   TMARK(10, "FINISH");
 }
 
-static int calculate_epoll_timeout(uevent_base_t *base) {
-  int epoll_timeout = EPOLL_MAX_TIMEOUT_MS;
+// таймаут ожидания в тиках очереди таймеров (мс или нс)
+static uint64_t calculate_epoll_timeout(uevent_base_t *base) {
+  uint64_t epoll_timeout = EPOLL_MAX_TIMEOUT_MS * timer_ticks_per_ms(base);
   wakeup_fd_reset(base);
+  // после сброса wakeup_fd: команда, пришедшая позже, снова разбудит epoll_wait
+  timer_cmd_apply(base, false);
+  // отложенные удаления могли снять последние события: не засыпать, цикл сам завершится
+  if (!uevent_base_has_events(base)) return 0;
+  // перенесенные бюджетом приоритетов fd ждут следующей итерации без сна
+  if (base->deferred_cnt > 0) return 0;
+  // освобожденные в этой итерации события уничтожаются на ее границе, не дожидаясь сна
+  if (atomic_load_explicit(&base->retire_head, memory_order_acquire) != NULL) return 0;
+  // вызов, поставленный до сброса wakeup_fd, уже не разбудит epoll_wait
+  atomic_thread_fence(memory_order_seq_cst);
+  if (!uev_post_ring_empty(base->post_ring)) return 0;
   if (atomic_load_explicit(&base->num_active_timers, memory_order_acquire) == 0) {
     return epoll_timeout;
   }
 
   if (pthread_mutex_lock(&base->base_mut) != 0) {
     syslog2(LOG_ERR, "failed to lock base mutex");
-    return 100;
+    return 100U * timer_ticks_per_ms(base);
   }
 
-  minheap_node_t *min_node = mh_get_min(base->timer_heap);
-  if (min_node != NULL) {
-    uint64_t current_time = tu_clock_gettime_monotonic_ms();
-    uevent_t *ev = container_of(min_node, uevent_t, timer_node);
-    syslog2(LOG_DEBUG, "name='%s' min_node->key=%" PRIu64 " cur_time=%" PRIu64, ev->name, min_node->key, current_time);
-    if (min_node->key <= current_time) {
+  uint64_t min_key;
+  if (timer_q_next_key(base, &min_key)) {
+    // колбэки прошлой итерации могли занять время: часы перечитываются перед сном
+    uint64_t current_time = timer_now_update(base);
+    syslog2(LOG_DEBUG, "min_key=%" PRIu64 " cur_time=%" PRIu64, min_key, current_time);
+    if (min_key <= current_time) {
       epoll_timeout = 0;
     } else {
-      uint64_t diff = min_node->key - current_time;
-      if (diff < (uint64_t)epoll_timeout) {
-        epoll_timeout = (int)diff;
+      uint64_t diff = min_key - current_time;
+      if (diff < epoll_timeout) {
+        epoll_timeout = diff;
       }
     }
   }
@@ -963,28 +1911,211 @@ static short convert_from_epoll_events(uint32_t epoll_events) {
   return triggered_events;
 }
 
+// вычитать все накопленные siginfo, повторные сигналы сливаются в одно срабатывание
+static bool signalfd_drain(int fd) {
+  struct signalfd_siginfo si[8];
+  bool got = false;
+  for (;;) {
+    ssize_t n = read(fd, si, sizeof(si));
+    if (n > 0) {
+      got = true;
+      continue;
+    }
+    if (n < 0 && errno == EINTR) continue;
+    return got;
+  }
+}
+
+// разобрать одну готовность fd: epoll_events — как их вернуло ядро или io_uring
+static void handle_ready_fd(uevent_base_t *base, uev_t *uev, uint32_t epoll_events) {
+  short triggered_events = convert_from_epoll_events(epoll_events);
+  uevent_t *ev = ATOM_LOAD_ACQ(uev->ev);
+  // завершение io_uring могло прийти уже после освобождения события
+  if (ev == NULL) return;
+  syslog2(LOG_DEBUG, "[EPOLL DBG] name='%s'", ev->name);
+  if (!uev_st_test(ev, UEV_ST_ACTIVE_FD)) {
+    return;
+  }
+  // ядро завершило multishot poll (например, переполнение CQ) — ставим заново
+  if ((epoll_events & UEV_URING_F_REARM) != 0) {
+    (void)uev_uring_poll_add(base->uring, ev->fd, convert_to_epoll_events(ev->events), (uint64_t)(uintptr_t)uev, false);
+    // uevent_del из другого потока мог успеть снять poll раньше нас
+    if (!uev_st_test(ev, UEV_ST_ACTIVE_FD)) {
+      (void)uev_uring_poll_remove(base->uring, (uint64_t)(uintptr_t)uev, false);
+    }
+  }
+  // wakeup_fd вычитываем только в потоке цикла: воркер мог бы съесть пробуждение
+  // от очереди команд уже после ее разбора и цикл уснул бы с непустой очередью
+  if (ev == &base->wakeup_event) {
+    wakeup_fd_read_cb(ev, ev->fd, triggered_events, NULL);
+    return;
+  }
+  if (ev->events & UEV_SIGNAL) {
+    // вычитываем в потоке цикла: при EPOLLET следующий сигнал даст новый фронт
+    if (!signalfd_drain(ev->fd)) return;
+    triggered_events = UEV_READ | UEV_SIGNAL;
+  } else if (ev->events & UEV_CHILD) {
+    triggered_events = UEV_READ | UEV_CHILD;
+  }
+  uevent_handle_ev_cb(ev, triggered_events, 0);
+  if (internal_should_auto_del_fd(ev, triggered_events)) {
+    event_del(uev, true);
+  }
+}
+
 static void uevent_handle_epoll(uevent_base_t *base, int nfds) {
   if (!atomic_load_explicit(&base->running, memory_order_acquire)) return;
 
+  for (int i = 0; i < nfds; i++) {
+    handle_ready_fd(base, (uev_t *)base->events[i].data.ptr, base->events[i].events);
+  }
+}
+
+// --- приоритеты: готовые fd итерации упорядочиваются по уровню, младшие уровни ограничены бюджетом ---
+
+static unsigned int ready_prio(const uev_ready_t *r) {
+  uevent_t *ev = ATOM_LOAD_ACQ(r->uev->ev);
+  return ev != NULL ? ev->priority : 0U;
+}
+
+static int ready_reserve(uevent_base_t *base, unsigned int need) {
+  if (need <= base->ready_cap) return 0;
+  unsigned int cap = base->ready_cap ? base->ready_cap : 64U;
+  while (cap < need) cap *= 2;
+  uev_ready_t *ready = realloc(base->ready, cap * sizeof(uev_ready_t));
+  if (ready == NULL) return -1;
+  base->ready = ready;
+  uev_ready_t *sorted = realloc(base->ready_sorted, cap * sizeof(uev_ready_t));
+  if (sorted == NULL) return -1;
+  base->ready_sorted = sorted;
+  uev_ready_t *deferred = realloc(base->deferred, cap * sizeof(uev_ready_t));
+  if (deferred == NULL) return -1;
+  base->deferred = deferred;
+  base->ready_cap = base->deferred_cap = cap;
+  return 0;
+}
+
+// собрать перенесенные и новые готовности, отсортировать по уровню (устойчиво), их число в *out.
+// Возвращает -1 без памяти под список, перенесенные готовности при этом остаются в deferred
+static int ready_collect(uevent_base_t *base, int nfds, unsigned int *out) {
+  unsigned int old = base->deferred_cnt;
+  if (ready_reserve(base, old + (unsigned int)nfds) != 0) return -1;
+  unsigned int n = 0;
+  for (unsigned int i = 0; i < old; i++) base->ready[n++] = base->deferred[i];
+  base->deferred_cnt = 0;
   for (int i = 0; i < nfds; i++) {
     uev_t *uev = (uev_t *)base->events[i].data.ptr;
-    short triggered_events = convert_from_epoll_events(base->events[i].events);
     uevent_t *ev = ATOM_LOAD_ACQ(uev->ev);
-    syslog2(LOG_DEBUG, "[EPOLL DBG] name='%s'", ev->name);
-    if (!atomic_load_explicit(&ev->active_fd, memory_order_acquire)) {
+    if (ev != NULL && uev_st_test(ev, UEV_ST_DEFERRED)) {
+      // новый фронт для уже перенесенного fd: объединяем маски
+      for (unsigned int j = 0; j < old; j++) {
+        if (base->ready[j].uev == uev) {
+          base->ready[j].epoll_events |= base->events[i].events;
+          break;
+        }
+      }
+      continue;
+    }
+    base->ready[n++] = (uev_ready_t){.uev = uev, .epoll_events = base->events[i].events, .held = false};
+  }
+
+  // сортировка подсчетом по уровню, порядок ядра внутри уровня сохраняется
+  unsigned int count[UINT8_MAX + 2] = {0};
+  for (unsigned int i = 0; i < n; i++) count[ready_prio(&base->ready[i]) + 1]++;
+  for (unsigned int p = 1; p <= base->num_prios; p++) count[p] += count[p - 1];
+  for (unsigned int i = 0; i < n; i++) base->ready_sorted[count[ready_prio(&base->ready[i])]++] = base->ready[i];
+  *out = n;
+  return 0;
+}
+
+// без памяти под список: перенесенные и новые готовности в порядке ядра, без уровней и бюджета.
+// При EPOLLET пропущенный фронт ядро не повторит, поэтому не теряем ни одной
+static void ready_dispatch_unsorted(uevent_base_t *base, int nfds) {
+  unsigned int old = base->deferred_cnt;
+  base->deferred_cnt = 0;
+  for (unsigned int i = 0; i < old; i++) {
+    uev_ready_t *r = &base->deferred[i];
+    uevent_t *ev = ATOM_LOAD_ACQ(r->uev->ev);
+    if (ev != NULL) uev_st_clear(ev, UEV_ST_DEFERRED);
+    handle_ready_fd(base, r->uev, r->epoll_events);
+    uevent_put(r->uev);
+  }
+  for (int i = 0; i < nfds; i++) {
+    handle_ready_fd(base, (uev_t *)base->events[i].data.ptr, base->events[i].events);
+  }
+}
+
+// выполнить готовности [*pos, n) до уровня max_prio включительно, младшие уровни — в пределах бюджета
+static void ready_dispatch(uevent_base_t *base, unsigned int *pos, unsigned int n, unsigned int max_prio, unsigned int *used) {
+  for (; *pos < n; (*pos)++) {
+    uev_ready_t *r = &base->ready_sorted[*pos];
+    unsigned int prio = ready_prio(r);
+    if (prio > max_prio) return;
+    if (prio > 0 && base->prio_budget != 0 && *used >= base->prio_budget) {
+      // бюджет исчерпан: при EPOLLET ядро не повторит готовность, переносим ее сами
+      if (!r->held && uevent_try_ref(r->uev) == NULL) continue;
+      uevent_t *ev = ATOM_LOAD_ACQ(r->uev->ev);
+      if (ev != NULL) uev_st_set(ev, UEV_ST_DEFERRED);
+      base->deferred[base->deferred_cnt++] = (uev_ready_t){.uev = r->uev, .epoll_events = r->epoll_events, .held = true};
       continue;
     }
-    uevent_handle_ev_cb(ev, triggered_events, 0);
-    if (internal_should_auto_del_fd(ev, triggered_events)) {
-      uevent_del(uev);
+    if (prio > 0) (*used)++;
+    if (r->held) {
+      uevent_t *ev = ATOM_LOAD_ACQ(r->uev->ev);
+      if (ev != NULL) uev_st_clear(ev, UEV_ST_DEFERRED);
+      handle_ready_fd(base, r->uev, r->epoll_events);
+      uevent_put(r->uev);
+    } else {
+      handle_ready_fd(base, r->uev, r->epoll_events);
     }
   }
 }
 
+// итерация с приоритетами: fd уровня 0, затем таймеры, затем остальные fd
+static void uevent_handle_prio(uevent_base_t *base, int nfds) {
+  if (!atomic_load_explicit(&base->running, memory_order_acquire)) return;
+  unsigned int n = 0;
+  if ((nfds > 0 || base->deferred_cnt > 0) && ready_collect(base, nfds, &n) != 0) {
+    syslog2(LOG_ERR, "error: no memory for ready list, fd priorities ignored this iteration");
+    ready_dispatch_unsorted(base, nfds);
+    uevent_handle_timers(base);
+    return;
+  }
+  unsigned int pos = 0, used = 0;
+  ready_dispatch(base, &pos, n, 0, &used);
+  uevent_handle_timers(base);
+  ready_dispatch(base, &pos, n, UINT8_MAX, &used);
+}
+
+// снять ссылки перенесенных готовностей, вызывается после остановки цикла
+static void ready_release(uevent_base_t *base) {
+  for (unsigned int i = 0; i < base->deferred_cnt; i++) {
+    uevent_t *ev = ATOM_LOAD_ACQ(base->deferred[i].uev->ev);
+    if (ev != NULL) uev_st_clear(ev, UEV_ST_DEFERRED);
+    uevent_put(base->deferred[i].uev);
+  }
+  base->deferred_cnt = 0;
+  free(base->ready);
+  free(base->ready_sorted);
+  free(base->deferred);
+  base->ready = base->ready_sorted = base->deferred = NULL;
+  base->ready_cap = base->deferred_cap = 0;
+}
+
+int uevent_set_priority(uev_t *uev, int priority) {
+  if (uev == NULL || priority < 0) return UEV_ERR_INVAL;
+  uevent_t *ev = ATOM_LOAD_ACQ(uev->ev);
+  if (ev == NULL) return UEV_ERR_INVAL;
+  uevent_base_t *base = ATOM_LOAD_ACQ(ev->base);
+  if (base == NULL || (unsigned int)priority >= base->num_prios) return UEV_ERR_INVAL;
+  ev->priority = (uint8_t)priority;
+  return UEV_ERR_OK;
+}
+
 static void dump_timer_heap(uevent_base_t *base) {
   return;
   if (!(syslog2_get_pri() & LOG_MASK(LOG_NOTICE))) return;
-  if (!base || !base->timer_heap) return;
+  if (!base || !base->timer_heap || base->timer_backend != UEV_TIMER_HEAP) return;
   if (pthread_mutex_lock(&base->base_mut) != 0) return;
 
   int size = mh_get_size(base->timer_heap);
@@ -998,13 +2129,85 @@ static void dump_timer_heap(uevent_base_t *base) {
   pthread_mutex_unlock(&base->base_mut);
 }
 
-static int epoll_wait_and_dispatch(uevent_base_t *base, int epoll_timeout) {
-  uint64_t mark = tu_clock_gettime_monotonic_ms();
-  int nfds = epoll_wait(base->epoll_fd, base->events, base->max_events,
-                        epoll_timeout);
-  uint64_t now = tu_clock_gettime_monotonic_ms();
-  int64_t slept_ms = (int64_t)now - (int64_t)mark;
-  syslog2(LOG_DEBUG, "[EPOLL_DBG] epoll_timeout=%d slept_ms=%" PRId64 "",
+// ожидание событий, timeout в тиках очереди таймеров
+static int uevent_epoll_wait(uevent_base_t *base, uint64_t timeout) {
+  if (base->uring != NULL) {
+    uint64_t ns = base->hires_timers ? timeout : timeout * NSEC_PER_MSEC;
+    struct timespec ts = {.tv_sec = (time_t)(ns / NSEC_PER_SEC), .tv_nsec = (long)(ns % NSEC_PER_SEC)};
+    return uev_uring_wait(base->uring, base->events, base->max_events, &ts);
+  }
+  if (!base->hires_timers) {
+    return epoll_wait(base->epoll_fd, base->events, base->max_events, (int)timeout);
+  }
+#ifdef SYS_epoll_pwait2
+  struct timespec ts = {.tv_sec = (time_t)(timeout / NSEC_PER_SEC), .tv_nsec = (long)(timeout % NSEC_PER_SEC)};
+  int nfds = (int)syscall(SYS_epoll_pwait2, base->epoll_fd, base->events, base->max_events, &ts, NULL, 0);
+  if ((nfds != -1) || (errno != ENOSYS)) return nfds;
+#endif
+  // ядро без epoll_pwait2: таймаут округляется вверх до миллисекунды
+  return epoll_wait(base->epoll_fd, base->events, base->max_events, (int)((timeout + NSEC_PER_MSEC - 1) / NSEC_PER_MSEC));
+}
+
+static uint64_t busy_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * NSEC_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+// true, если вместо сна нужно опросить готовность с нулевым таймаутом
+static bool busy_poll_spinning(const uevent_base_t *base, uint64_t now_ns) {
+  return base->busy_deadline_ns != 0 && now_ns < base->busy_deadline_ns;
+}
+
+// подстроить окно опроса по итогу ожидания: пустое окно вдвое короче, найденные события возвращают полное
+static void busy_poll_update(uevent_base_t *base, bool spun, bool got_events, uint64_t wait_start_ns, uint64_t now_ns) {
+  if (spun) {
+    if (got_events) {
+      base->busy_window_ns = base->busy_poll_ns;
+    } else if (now_ns >= base->busy_deadline_ns) {
+      // окно прошло впустую: поток так и не дождался работы, следующее окно короче
+      base->busy_window_ns /= 2;
+      if (base->busy_window_ns < UEV_BUSY_POLL_MIN_NS) base->busy_window_ns = 0;
+      base->busy_deadline_ns = 0;
+      return;
+    }
+  } else if (got_events && now_ns - wait_start_ns < base->busy_poll_ns) {
+    // события пришли быстрее полного окна: опрос бы их дождался, окно растет обратно
+    uint64_t window = base->busy_window_ns * 2;
+    if (window < UEV_BUSY_POLL_MIN_NS) window = UEV_BUSY_POLL_MIN_NS;
+    base->busy_window_ns = window < base->busy_poll_ns ? window : base->busy_poll_ns;
+  }
+}
+
+// после итерации с событиями: окно отсчитывается от конца разбора, время колбэков его не съедает
+static void busy_poll_arm(uevent_base_t *base) {
+  base->busy_deadline_ns = base->busy_window_ns != 0 ? busy_now_ns() + base->busy_window_ns : 0;
+}
+
+static int epoll_wait_and_dispatch(uevent_base_t *base, uint64_t epoll_timeout) {
+  uint64_t mark = timer_now_cached(base);
+  // виртуальное время: fd только опрашиваются, а сон до ближайшего таймера заменяется переводом часов
+  uint64_t skip = 0;
+  if (base->virtual_clock && atomic_load_explicit(&base->num_active_timers, memory_order_acquire) > 0) {
+    skip = epoll_timeout;
+    epoll_timeout = 0;
+  }
+  uint64_t wait_start_ns = 0;
+  bool spun = false;
+  if (base->busy_poll_ns != 0) {
+    wait_start_ns = busy_now_ns();
+    spun = epoll_timeout > 0 && busy_poll_spinning(base, wait_start_ns);
+    if (spun) epoll_timeout = 0;
+  }
+  int nfds = uevent_epoll_wait(base, epoll_timeout);
+  if (base->busy_poll_ns != 0 && (nfds >= 0 || errno == EINTR)) {
+    busy_poll_update(base, spun, nfds > 0, wait_start_ns, busy_now_ns());
+  }
+  if (skip != 0 && nfds == 0) atomic_fetch_add_explicit(&base->vclock, skip, memory_order_relaxed);
+  // единственное чтение часов за итерацию после сна, дальше таймеры и колбэки берут кеш
+  uint64_t now = timer_now_update(base);
+  int64_t slept_ms = ((int64_t)now - (int64_t)mark) / (int64_t)timer_ticks_per_ms(base);
+  syslog2(LOG_DEBUG, "[EPOLL_DBG] epoll_timeout=%" PRIu64 " slept_ms=%" PRId64 "",
           epoll_timeout, slept_ms);
 
   if (nfds == -1) {
@@ -1013,16 +2216,25 @@ static int epoll_wait_and_dispatch(uevent_base_t *base, int epoll_timeout) {
     return -1;
   }
 
-  uevent_handle_timers(base);
-  if (nfds > 0) {
-    uevent_handle_epoll(base, nfds);
+  (void)uev_post_ring_run(base->post_ring);
+  if (base->num_prios > 1) {
+    uevent_handle_prio(base, nfds);
+  } else {
+    uevent_handle_timers(base);
+    if (nfds > 0) {
+      uevent_handle_epoll(base, nfds);
+    }
   }
+  if (base->busy_poll_ns != 0 && nfds > 0) busy_poll_arm(base);
   return 0;
 }
 
 static void mark_base_stopped(uevent_base_t *base) {
+  changelist_flush(base);
   pthread_mutex_lock(&base->base_mut);
   atomic_store_explicit(&base->stopped, true, memory_order_release);
+  // после отметки новые события уничтожаются сразу, разбираем накопленные
+  retire_drain(base);
   pthread_cond_signal(&base->base_cond);
   pthread_mutex_unlock(&base->base_mut);
 }
@@ -1034,10 +2246,16 @@ int uevent_base_dispatch(uevent_base_t *base) {
   }
   TINIT;
   TMARK(0, "START");
+  if (base->loop_placed) uev_placement_apply(&base->loop_place, "loop", 0);
+  base->loop_thread = pthread_self();
   atomic_store_explicit(&base->running, true, memory_order_release);
   atomic_store_explicit(&base->stopped, false, memory_order_release);
 
   while (atomic_load_explicit(&base->running, memory_order_acquire)) {
+    // граница итерации: изменения регистраций fd уходят в ядро одним итогом, затем
+    // колбэки прошлой итерации завершились и освобожденные события можно уничтожить
+    changelist_flush(base);
+    retire_drain(base);
     dump_timer_heap(base);
     if (!uevent_base_has_events(base)) {
       syslog2(LOG_DEBUG, "no active events left, breaking event loop.");
@@ -1046,7 +2264,7 @@ int uevent_base_dispatch(uevent_base_t *base) {
     }
 
     TMARK(10, "uevent_base_has_events");
-    int epoll_timeout = calculate_epoll_timeout(base);
+    uint64_t epoll_timeout = calculate_epoll_timeout(base);
     TMARK(10, "calculate_epoll_timeout");
     if (epoll_wait_and_dispatch(base, epoll_timeout) != 0) {
       mark_base_stopped(base);
@@ -1061,6 +2279,43 @@ int uevent_base_dispatch(uevent_base_t *base) {
   return UEV_ERR_OK;
 }
 
+uint64_t uevent_base_now(uevent_base_t *base) {
+  if (base == NULL) return 0;
+  return timer_now_cached(base) / timer_ticks_per_ms(base);
+}
+
+void uevent_base_update_time(uevent_base_t *base) {
+  if (base == NULL) return;
+  (void)timer_now_update(base);
+}
+
+int uevent_post(uevent_base_t *base, uevent_post_fn_t fn, void *arg) {
+  if (base == NULL || fn == NULL) return UEV_ERR_INVAL;
+  if (uev_post_ring_push(base->post_ring, fn, arg) != 0) return UEV_ERR_BUSY;
+  // из потока работающего цикла будить некого: непустое кольцо обнуляет таймаут ожидания
+  if (!timer_cmd_should_defer(base) && atomic_load_explicit(&base->running, memory_order_acquire)) {
+    return UEV_ERR_OK;
+  }
+  // uevent_base_wakeup пишет в eventfd только первым вызовом пачки
+  uevent_base_wakeup(base);
+  return UEV_ERR_OK;
+}
+
+int uevent_base_stats_snapshot(uevent_base_t *base, uevent_stat_t *out, int max) {
+  if (base == NULL) return 0;
+  return uev_stats_snapshot(base->stats, out, max);
+}
+
+uev_io_backend_t uevent_base_io_backend(const uevent_base_t *base) {
+  return base ? base->io_backend : UEV_IO_EPOLL;
+}
+
+int uevent_base_load(uevent_base_t *base) {
+  if (base == NULL) return 0;
+  return atomic_load_explicit(&base->num_active_fd, memory_order_relaxed) +
+         atomic_load_explicit(&base->num_active_timers, memory_order_relaxed);
+}
+
 void uevent_base_loopbreak(uevent_base_t *base) {
   FUNC_START_DEBUG;
   if (base == NULL) {
@@ -1070,16 +2325,15 @@ void uevent_base_loopbreak(uevent_base_t *base) {
 
   // Очищаем кучу таймеров
   pthread_mutex_lock(&base->base_mut);
-  while (mh_get_min(base->timer_heap) != NULL) {
-    minheap_node_t *expired = mh_extract_min(base->timer_heap);
-    if (expired == NULL) break;
-    uevent_t *ev = container_of(expired, uevent_t, timer_node);
+  uevent_t *ev;
+  while ((ev = timer_q_pop_any(base)) != NULL) {
     uev_t *uev = ATOM_LOAD_ACQ(ev->uev);
-    atomic_store_explicit(&ev->active_timer, false, memory_order_release);
+    uev_st_clear(ev, UEV_ST_ACTIVE_TIMER);
     atomic_fetch_sub_explicit(&base->num_active_timers, 1, memory_order_acq_rel);
     if (uev) uevent_put(uev);
     syslog2(LOG_DEBUG, "[LOOPBREAK] Removed timer: name='%s'", ev->name);
   }
+  timer_cmd_apply_locked(base, true);
   pthread_mutex_unlock(&base->base_mut);
 
   uevent_base_wakeup(base);
@@ -1091,15 +2345,17 @@ void uevent_free(uev_t *uev) {
   if (ATOM_LOAD_RELAX(uev->refcount) < 1) return;
 
   uevent_t *ev = ATOM_LOAD_ACQ(uev->ev);
-  if (ev == NULL || atomic_load_explicit(&ev->pending_free, memory_order_acquire)) {
+  if (ev == NULL || uev_st_test(ev, UEV_ST_PENDING_FREE)) {
     return;
   }
 
   uevent_del(uev);
 
-  if (atomic_exchange_explicit(&ev->pending_free, true, memory_order_acq_rel)) {
+  if (uev_st_set(ev, UEV_ST_PENDING_FREE)) {
     return;
   }
+  // дескрипторы события устаревают сразу, слот освободится позже
+  atomic_fetch_add_explicit(&uev->gen, 1, memory_order_release);
 
   uevent_put(uev);
 }
@@ -1136,9 +2392,14 @@ void uevent_deinit(uevent_base_t *base) {
     base->worker_pool = NULL;
   }
 
+  // команды, поставленные после остановки цикла, уже не нужны
+  timer_cmd_apply(base, true);
+  // перенесенные бюджетом готовности держат ссылки на события
+  ready_release(base);
+
   pthread_mutex_lock(&base->base_mut);
-  for (unsigned int i = 0; i < base->uev_arr_sz; i++) {
-    uev_t *uev = &base->uev_arr[i];
+  for (unsigned int i = 0; i < uev_slots_capacity(base); i++) {
+    uev_t *uev = uev_seg_slot(base, &base->uev_segs[i / UEV_SLOT_SEG_SIZE], i % UEV_SLOT_SEG_SIZE);
     int old = atomic_load_explicit(&uev->refcount, memory_order_relaxed);
     if (old == 0) continue; // skip zombie event
     uevent_free(uev);
@@ -1153,9 +2414,19 @@ void uevent_deinit(uevent_base_t *base) {
   }
 
   mh_free(base->timer_heap);
+  uev_wheel_free(base->timer_wheel);
+  free(base->timer_batch);
+  free(base->worker_batch);
   free(base->events);
   uev_slots_deinit(base);
-  close(base->epoll_fd);
+  if (base->epoll_fd != -1) close(base->epoll_fd);
+  uev_uring_free(base->uring);
+  uev_stats_free(base->stats);
+  // невыполненные вызовы uevent_post() после остановки цикла отбрасываются
+  uev_post_ring_free(base->post_ring);
+  // все динамические события базы уже освобождены
+  uev_slab_free(base->ev_slab);
+  free(base->changes);
 
   pthread_mutex_destroy(&base->base_mut);
   pthread_cond_destroy(&base->base_cond);
@@ -1186,6 +2457,67 @@ static inline bool refcount_inc_not_zero(atomic_int *r) {
   }
 }
 
+// --- отложенное освобождение: пока цикл работает, события без ссылок уничтожаются между итерациями ---
+
+static void retire_drain(uevent_base_t *base) {
+  uevent_t *ev = atomic_exchange_explicit(&base->retire_head, NULL, memory_order_acq_rel);
+  while (ev != NULL) {
+    uevent_t *next = ev->cmd_next;
+    ev->cmd_next = NULL;
+    uevent_destroy_uev_internal_unsafe(ev->uev);
+    ev = next;
+  }
+}
+
+// поставить событие, на которое не осталось ссылок, в очередь базы; false — уничтожить сразу.
+// Очередь ссылки не держит и cmd_next свободен: в очереди команд событие держит ссылку.
+// Статическое событие сбрасывается сразу: его память принадлежит вызывающему
+static bool retire_push(uev_t *uev) {
+  uevent_t *ev = ATOM_LOAD_ACQ(uev->ev);
+  if (ev == NULL || ev->is_static) return false;
+  uevent_base_t *base = ATOM_LOAD_ACQ(ev->base);
+  if (base == NULL || atomic_load_explicit(&base->stopped, memory_order_acquire)) return false;
+
+  uevent_t *head = atomic_load_explicit(&base->retire_head, memory_order_relaxed);
+  do {
+    ev->cmd_next = head;
+  } while (!atomic_compare_exchange_weak(&base->retire_head, &head, ev));
+
+  if (atomic_load_explicit(&base->stopped, memory_order_acquire)) {
+    // цикл успел завершиться и очередь уже не разберет
+    retire_drain(base);
+  } else if (head == NULL && timer_cmd_should_defer(base)) {
+    uevent_base_wakeup(base);
+  }
+  return true;
+}
+
+uev_handle_t uevent_handle(uev_t *uev) {
+  if (uev == NULL) return 0;
+  uint32_t gen = atomic_load_explicit(&uev->gen, memory_order_acquire);
+  uevent_t *ev = ATOM_LOAD_ACQ(uev->ev);
+  if (ev == NULL || uev_st_test(ev, UEV_ST_PENDING_FREE)) return 0;
+  return ((uev_handle_t)gen << 32) | uev->slot_idx;
+}
+
+uev_t *uevent_handle_get(uevent_base_t *base, uev_handle_t handle) {
+  uint32_t gen = (uint32_t)(handle >> 32);
+  uint32_t idx = (uint32_t)handle;
+  if (base == NULL || gen == 0) return NULL;
+  uev_seg_dir_t *dir = atomic_load_explicit(&base->seg_dir, memory_order_acquire);
+  if (dir == NULL || idx / UEV_SLOT_SEG_SIZE >= atomic_load_explicit(&dir->cnt, memory_order_acquire)) return NULL;
+  uev_t *uev = (uev_t *)((char *)dir->slots[idx / UEV_SLOT_SEG_SIZE] + (size_t)(idx % UEV_SLOT_SEG_SIZE) * base->slot_stride);
+  // память слотов не возвращается до uevent_deinit: чтение устаревшего слота безопасно
+  if (atomic_load_explicit(&uev->gen, memory_order_acquire) != gen) return NULL;
+  if (uevent_try_ref(uev) == NULL) return NULL;
+  // между проверкой и ссылкой слот мог освободиться и уйти другому событию
+  if (atomic_load_explicit(&uev->gen, memory_order_acquire) != gen) {
+    uevent_put(uev);
+    return NULL;
+  }
+  return uev;
+}
+
 uev_t *uevent_try_ref(uev_t *uev) {
   if (!uev) {
     syslog2(LOG_ERR, "error: EINVAL uev=NULL");
@@ -1203,7 +2535,7 @@ uev_t *uevent_try_ref(uev_t *uev) {
     return NULL;
   }
 
-  if (atomic_load_explicit(&ev->pending_free, memory_order_acquire)) {
+  if (uev_st_test(ev, UEV_ST_PENDING_FREE)) {
     syslog2(LOG_DEBUG, "error: event pending free for name='%s'", ev->name);
     atomic_fetch_sub_explicit(&uev->refcount, 1, memory_order_relaxed);
     return NULL;
@@ -1240,7 +2572,7 @@ bool uevent_put(uev_t *uev) {
   if (old == 0) return false;
 
   if (uevent_refcount_dec_and_test(uev)) {
-    uevent_destroy_uev_internal_unsafe(uev);
+    if (!retire_push(uev)) uevent_destroy_uev_internal_unsafe(uev);
     return true;
   }
   return false;
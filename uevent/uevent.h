@@ -5,11 +5,13 @@
 #include "../minheap/minheap.h"
 #include "../syslog2/syslog2.h"
 #include "../timeutil/timeutil.h"
+#include "uevent_wheel.h"
 
 #include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <sys/epoll.h>
+#include <sys/types.h>
 #include <time.h>
 
 #ifndef EXPORT_API
@@ -41,7 +43,10 @@ extern uevent_time_ms_fn_t uevent_time_ms_hook;
 #define UEV_ERROR (1 << 2)
 #define UEV_HUP (1 << 3)
 #define UEV_TIMEOUT (1 << 4)
-#define UEV_PERSIST (1 << 5)
+#define UEV_PERSIST (1 << 5) /* без него fd-событие одноразовое: на epoll регистрируется с EPOLLONESHOT и повторный uevent_add делает один EPOLL_CTL_MOD */
+#define UEV_SIGNAL (1 << 6) /* событие signalfd, см. uevent_signal_new() */
+#define UEV_CHILD (1 << 7)  /* событие pidfd, см. uevent_child_new() */
+#define UEV_EXCLUSIVE (1 << 8) /* EPOLLEXCLUSIVE: из баз, ждущих один fd, будится одна (бэкенд epoll) */
 
 // флаг включающий все fd события
 #define UEV_FD_EVENTS (UEV_READ | UEV_WRITE | UEV_ERROR | UEV_HUP)
@@ -60,11 +65,74 @@ typedef enum {
 /* колбек для событий */
 typedef struct uevent_t uevent_t; // форвард декларация для типа uevent
 typedef void (*uevent_cb_t)(uevent_t *ev, int fd, short events, void *arg);
+typedef void (*uevent_post_fn_t)(void *arg); /* вызов, переданный в цикл через uevent_post() */
 typedef void (*uevent_cb_wrapper_t)(uevent_t *ev, int fd, short events, uint64_t cron_time_ms, uevent_cb_t cb, void *arg);
 
+/* источник времени базы: текущее время в тиках очереди таймеров (мс, с hires_timers — нс) */
+typedef uint64_t (*uevent_clock_fn_t)(void *arg);
+
 /* Структура для базы событий */
 typedef struct uevent_base_t uevent_base_t;
 
+/* бэкенд очереди таймеров базы */
+typedef enum {
+  UEV_TIMER_HEAP = 0,  /* min-куча, вставка/удаление O(log n) */
+  UEV_TIMER_WHEEL = 1, /* иерархическое колесо таймеров, вставка/удаление O(1) */
+} uev_timer_backend_t;
+
+/* бэкенд ожидания готовности fd */
+typedef enum {
+  UEV_IO_EPOLL = 0, /* epoll, по системному вызову на каждый uevent_add/uevent_del (без args.changelist) */
+  UEV_IO_URING = 1, /* io_uring с multishot poll, регистрации уходят пачкой вместе с ожиданием */
+} uev_io_backend_t;
+
+/* размещение потока цикла или воркера, нулевые поля оставляют поток как есть */
+typedef struct uevent_thread_placement_t {
+  const int *cpus;    /* номера CPU, на которых разрешено выполняться потоку */
+  int ncpus;          /* число элементов cpus, 0 — без привязки к CPU */
+  int sched_policy;   /* SCHED_OTHER (0), SCHED_FIFO или SCHED_RR */
+  int sched_priority; /* приоритет для SCHED_FIFO/SCHED_RR, 1..99 */
+  int nice;           /* nice потока для SCHED_OTHER, -20..19 */
+} uevent_thread_placement_t;
+
+/* параметры создания базы событий, нулевые поля означают значения по умолчанию */
+typedef struct {
+  int max_events;                    /* размер массива epoll событий и начальное число слотов (таблица растет) */
+  int num_workers;                   /* число воркеров, 0 — колбеки выполняются в потоке цикла */
+  uev_timer_backend_t timer_backend; /* бэкенд таймеров */
+  bool hires_timers;                 /* наносекундные ключи таймеров и epoll_pwait2 вместо миллисекунд */
+  int timer_batch_max;               /* максимум истекших таймеров за одну итерацию цикла, 0 — 500 */
+  uev_io_backend_t io_backend;       /* бэкенд fd, без io_uring в ядре база создается на epoll */
+  bool stats;                        /* гистограммы задержки и длительности колбэков по именам событий */
+  int post_queue_size;               /* ячеек кольца uevent_post(), 0 — 1024, округляется до степени двойки */
+  int busy_poll_us;                  /* после итерации с событиями опрашивать без сна до N мкс, 0 — выключено */
+  bool pad_slots;                    /* слот uev_t на отдельной кеш-линии: счетчики ссылок соседних событий не делят линию между воркерами, память слотов x4 */
+  uevent_clock_fn_t clock_fn;        /* источник времени вместо монотонных часов ядра, NULL — часы ядра */
+  void *clock_arg;                   /* аргумент clock_fn */
+  bool virtual_clock;                /* виртуальное время от показаний источника: без fd-событий цикл не спит, а переводит часы к ближайшему таймеру */
+  int priorities;                    /* число уровней приоритета (до 256), 0 и 1 — без приоритетов */
+  int prio_budget;                   /* колбэков fd ниже высшего приоритета за итерацию, остальные ждут следующей; 0 — без ограничения */
+  bool changelist;                   /* только epoll: uevent_add/uevent_del fd из потока цикла копятся и применяются итогом перед epoll_wait, см. uevent_base_ctl_saved() */
+  bool worker_affinity;              /* с воркерами: у каждого своя очередь, колбэки одного fd идут одному воркеру по порядку и без пропусков, свободные воруют при перекосе */
+  const uevent_thread_placement_t *loop_placement;   /* применяется к потоку, вызвавшему uevent_base_dispatch(), при входе в цикл */
+  const uevent_thread_placement_t *worker_placement; /* i-й воркер, включая дополнительных, берет worker_placement[i % worker_placement_cnt] */
+  int worker_placement_cnt;
+  bool numa_local;                   /* слоты событий, events[] и куча таймеров на узле NUMA первого CPU loop_placement (без него — CPU, создающего базу) */
+} uevent_base_args_t;
+
+/* статистика колбэков одного имени события, см. uevent_base_stats_snapshot() */
+typedef struct uevent_stat_t {
+  const char *name;         /* ev->name, "(other)" — имена сверх лимита таблицы */
+  uint64_t count;           /* число вызовов колбэка */
+  uint64_t lag_count;       /* из них срабатываний таймера, только для них считается задержка */
+  uint64_t lag_p50_us;      /* задержка от планового времени таймера до начала колбэка, мкс */
+  uint64_t lag_p99_us;
+  uint64_t lag_max_us;
+  uint64_t duration_p50_us; /* длительность колбэка, мкс */
+  uint64_t duration_p99_us;
+  uint64_t duration_max_us;
+} uevent_stat_t;
+
 /**
  * @brief Специальное значение таймаута для uevent_add().
  * Указывает, что событие должно сработать немедленно (таймаут 0).
@@ -104,44 +172,111 @@ typedef struct uevent_base_t uevent_base_t;
 /* Структура для события */
 typedef struct uevent_item_t uev_t; // форвард декларация
 
+/* биты uevent_t.state */
+#define UEV_ST_LOCKED (1U << 0)      /* modification_lock: событие меняется или выполняется его колбэк */
+#define UEV_ST_ACTIVE_FD (1U << 1)   /* fd добавлен в epoll/io_uring */
+#define UEV_ST_ACTIVE_TIMER (1U << 2) /* таймер стоит в очереди таймеров */
+#define UEV_ST_PENDING_FREE (1U << 3) /* событие отмечено для освобождения */
+#define UEV_ST_IN_WORKER (1U << 4)   /* событие стоит в пуле воркеров, повторно не ставится */
+#define UEV_ST_CMD_QUEUED (1U << 5)  /* событие стоит в очереди команд базы */
+#define UEV_ST_DEFERRED (1U << 6)    /* готовность fd перенесена на следующую итерацию бюджетом приоритетов */
+#define UEV_ST_CHANGED (1U << 7)     /* регистрация fd стоит в списке изменений epoll базы */
+#define UEV_ST_ONESHOT (1U << 8)     /* fd в epoll с EPOLLONESHOT: после срабатывания регистрация выключена, но не снята */
+
 typedef struct uevent_t {
-  _Atomic bool modification_lock; /* этот флаг используется для синхронизации доступа для изменений event из разных потоков */
-  _Atomic bool active_fd;         /* флаг активности события fd (если добавлен в epoll) */
-  _Atomic bool active_timer;      /* флаг активности события таймера (если добавлен в кучу) */
-  _Atomic bool pending_free;      /* флаг, что событие нужно освободить */
-  _Atomic bool is_in_worker_pool; /* этот флаг используется чтобы исключить возможность добавления этого события в пул вокеров дважды */
-  const bool is_static;           /* является ли событие статическим */
-  short events;                   /* типы событий (UEV_READ, UEV_WRITE и т.д.) */
-
-  _Atomic int timeout_ms;         /* таймаут срабатывания для таймера, используется только, если установлен флаг UEVENT_PERSIST */
-  int fd;                         /* дескриптор файла */
-  uevent_cb_t cb;                 /* колбек для обработки события */
+  // горячие поля: проверяются и меняются на каждом срабатывании, первая кеш-линия
+  _Atomic uint32_t state;        /* слово состояния UEV_ST_*, переходы fetch_or/fetch_and/CAS */
+  short events;                  /* типы событий (UEV_READ, UEV_WRITE и т.д.) */
+  const bool is_static;          /* является ли событие статическим */
+  uint8_t priority;              /* уровень приоритета, 0 — высший, см. uevent_set_priority() */
+  int fd;                        /* дескриптор файла */
+  _Atomic int timeout_ms;        /* таймаут срабатывания для таймера, используется только, если установлен флаг UEVENT_PERSIST */
+  _Atomic unsigned int del_seq;  /* счетчик вызовов uevent_del, отменяет уже извлеченное срабатывание таймера */
+  _Atomic short worker_pending;  /* срабатывания, пришедшие пока событие в пуле воркеров с args.worker_affinity */
+  uevent_cb_t cb;                /* колбек для обработки события */
+  void *arg;                     /* аргумент для callback */
   uevent_cb_wrapper_t cb_wrapper; /* обертка для колбека, она вызывает внутри себя сам колбек юзера  */
-  void *arg;                      /* аргумент для callback */
-  _Atomic(uevent_base_t *) base;  /* атомарный указатель на базу событий */
-
-  // struct list_head list_node; /* узел для списка, который хранится в uevent base */
+  _Atomic(uevent_base_t *) base; /* атомарный указатель на базу событий */
+  uev_t *uev;                    // указатель на обертку для события
+
+  // база использует один бэкенд таймеров, поэтому узлы кучи и колеса делят память
+  union {
+    minheap_node_t timer_node;   /* узел таймера для minheap, key — время срабатывания */
+    uev_wheel_node_t wheel_node; /* узел таймера для колеса таймеров */
+  };
+
+  // холодные поля: очередь команд из других потоков, имя и статистика
+  struct uevent_t *cmd_next; /* следующее событие в очереди команд базы */
+  _Atomic uint64_t cmd_key;  /* отложенная команда таймера: время срабатывания или удаление */
   const char *name;
-  uev_t *uev; // указатель на обертку для события
-
-  minheap_node_t timer_node; /* узел таймера для minheap */
-
+  struct uev_stat_entry *stat_entry; /* запись статистики базы для ev->name, находится при первом вызове */
 } uevent_t;
 
 // обертка для указателя на событие и счетчика ссылок
 typedef struct uevent_item_t {
   _Atomic(uevent_t *) ev;
   _Atomic int refcount; /* счетчик ссылок на событие, используется для синхронизации потоков и отложенного освобождения для борьбы с use-after-free */
+  unsigned int slot_idx; /* номер слота в таблице базы */
+  _Atomic uint32_t gen;  /* поколение слота: меняется при освобождении и повторной выдаче, см. uev_handle_t */
 } uev_t;
 
+/*
+ * Дескриптор события: поколение слота в старших 32 битах, номер слота в младших, 0 — пустой.
+ * Проверка дескриптора — одно чтение поколения без атомарных RMW над счетчиком ссылок;
+ * после uevent_free() дескриптор перестает разбираться, даже если слот занят другим событием.
+ */
+typedef uint64_t uev_handle_t;
+
 // THREAD-SAFE ФУНКЦИИ БИБЛИОТЕКИ
 
 /* Добавляет событие в базу с опциональным таймаутом (в миллисекундах). Возвращает 0 при успехе, -1 при ошибке. */
 EXPORT_API int uevent_add(uev_t *uev, int timeout_ms);
 
+/* То же, что uevent_add, но таймаут в микросекундах. Без hires_timers округляется вверх до миллисекунды. */
+EXPORT_API int uevent_add_us(uev_t *uev, int timeout_us);
+
 /* Удаляет событие из базы. Возвращает 0 при успехе, -1 при ошибке. */
 EXPORT_API int uevent_del(uev_t *uev);
 
+/*
+ * Меняет маску fd-событий (UEV_READ/UEV_WRITE/...) и сразу применяет ее: пустая маска снимает fd
+ * с опроса, непустая ставит или обновляет регистрацию. В отличие от uevent_add не берет
+ * UEV_ST_LOCKED, поэтому вызывается из колбэка самого события или потоком-владельцем события.
+ */
+EXPORT_API int uevent_set_fd_events(uev_t *uev, short events);
+
+/*
+ * Создаёт событие сигнала signum на signalfd. Сигнал блокируется в вызывающем потоке, остальные
+ * потоки процесса тоже должны держать его заблокированным (проще всего — создать событие до запуска
+ * потоков). Повторные сигналы до вызова колбэка сливаются в одно срабатывание с events
+ * UEV_READ | UEV_SIGNAL. Событие не запущено: uevent_add(uev, 0). signalfd закрывается при освобождении.
+ */
+EXPORT_API uev_t *uevent_signal_new(uevent_base_t *base, int signum, uevent_cb_t cb, void *arg, const char *name);
+
+/*
+ * Создаёт одноразовое событие завершения процесса pid на pidfd (ядро 5.3+), колбэк получает
+ * UEV_READ | UEV_CHILD. Процесс не подбирается: статус забирает колбэк через waitpid().
+ * Событие не запущено: uevent_add(uev, 0). pidfd закрывается при освобождении.
+ */
+EXPORT_API uev_t *uevent_child_new(uevent_base_t *base, pid_t pid, uevent_cb_t cb, void *arg, const char *name);
+
+/*
+ * Ставит вызов fn(arg) в кольцо базы, вызывается из любого потока. Цикл выполняет накопленные
+ * вызовы в своем потоке один раз за итерацию, в порядке постановки для каждого писателя; пачка
+ * вызовов будит цикл одной записью в wakeup_event. Слоты событий и base_mut не используются.
+ * Возвращает UEV_ERR_OK, UEV_ERR_BUSY если кольцо заполнено или UEV_ERR_INVAL.
+ * Вызовы, не выполненные до uevent_deinit(), отбрасываются.
+ */
+EXPORT_API int uevent_post(uevent_base_t *base, uevent_post_fn_t fn, void *arg);
+
+/*
+ * Задает уровень приоритета события: 0 — высший, до args.priorities - 1. Вызывается после
+ * создания, до uevent_add(). За итерацию готовые fd выполняются по убыванию приоритета:
+ * сначала fd уровня 0, затем истекшие таймеры (тоже по приоритету), затем остальные fd.
+ * Возвращает UEV_ERR_OK или UEV_ERR_INVAL, если уровень вне диапазона базы.
+ */
+EXPORT_API int uevent_set_priority(uev_t *uev, int priority);
+
 /* Освобождает память события (отмечает событие для освобождения). Для статических событий очищает содержимое. Для динамических — освобождает память. */
 EXPORT_API void uevent_free(uev_t *uev);
 
@@ -157,6 +292,16 @@ EXPORT_API bool uevent_pending(uev_t *uev, int mask);
 /* проверяет, является ли указатель на событие валидным и живым */
 EXPORT_API bool uevent_is_alive(uev_t *uev);
 
+/* Дескриптор живого события, 0 для освобожденного. */
+EXPORT_API uev_handle_t uevent_handle(uev_t *uev);
+
+/*
+ * Событие по дескриптору со взятой ссылкой или NULL, если дескриптор устарел. Вызывается из
+ * любого потока, вызывающий отпускает ссылку через uevent_put(). Пока ссылка держится, слот
+ * не выдается другому событию.
+ */
+EXPORT_API uev_t *uevent_handle_get(uevent_base_t *base, uev_handle_t handle);
+
 // было ли событие инициализировано (динамические создаются, а статические привязываются assign)
 EXPORT_API bool uevent_initialized(uev_t *uev);
 
@@ -172,6 +317,53 @@ EXPORT_API int uevent_base_dispatch(uevent_base_t *base);
 /* Прерывает цикл обработки событий. */
 EXPORT_API void uevent_base_loopbreak(uevent_base_t *base);
 
+/*
+ * Время итерации цикла в мс по часам очереди таймеров. Обновляется один раз после
+ * epoll_wait и перед расчетом таймаута, внутри колбэков не меняется. Таймеры, добавленные
+ * из потока цикла, отсчитываются от этого времени, а не от текущих часов.
+ */
+EXPORT_API uint64_t uevent_base_now(uevent_base_t *base);
+
+/* Перечитывает часы для uevent_base_now(), например после долгого колбэка в потоке цикла. */
+EXPORT_API void uevent_base_update_time(uevent_base_t *base);
+
+/* бэкенд fd, выбранный при создании базы (с учетом отката на epoll) */
+EXPORT_API uev_io_backend_t uevent_base_io_backend(const uevent_base_t *base);
+
+/*
+ * Снимок статистики колбэков базы, созданной с args.stats: по записи на имя события.
+ * Заполняет не больше max записей out, возвращает общее число имен (0, если статистика выключена).
+ */
+EXPORT_API int uevent_base_stats_snapshot(uevent_base_t *base, uevent_stat_t *out, int max);
+
+/* Число активных fd и таймеров базы, используется для балансировки между циклами. */
+EXPORT_API int uevent_base_load(uevent_base_t *base);
+
+/*
+ * Сколько вызовов epoll_ctl сэкономил список изменений базы с args.changelist: например,
+ * uevent_del и uevent_add одного fd в колбэке дают один EPOLL_CTL_MOD вместо двух вызовов.
+ * Ошибки отложенной регистрации пишутся в лог, событие при этом снимается с fd.
+ * Снятый в колбэке fd можно сразу закрыть, но его копии (dup) — только после следующей итерации.
+ */
+EXPORT_API unsigned long uevent_base_ctl_saved(const uevent_base_t *base);
+
+/* сколько задач воркеры базы с args.worker_affinity забрали из чужих очередей */
+EXPORT_API unsigned long uevent_base_worker_stolen(const uevent_base_t *base);
+
+/* счетчики аллокатора динамических uevent_t базы, см. uevent_base_slab_stats() */
+typedef struct {
+  unsigned long live;         /* выданных и еще не освобожденных событий */
+  unsigned long slabs;        /* блоков памяти по 64 КиБ */
+  unsigned long remote_frees; /* событий, освобожденных не тем потоком, который их создал */
+} uevent_slab_stats_t;
+
+/*
+ * Динамические uevent_t берутся из слаб-аллокатора базы: у каждого потока свой кеш свободных
+ * объектов, обмен с общим складом базы идет пачками. Блоки возвращаются системе в uevent_deinit().
+ * Возвращает UEV_ERR_OK или UEV_ERR_INVAL.
+ */
+EXPORT_API int uevent_base_slab_stats(const uevent_base_t *base, uevent_slab_stats_t *out);
+
 /* Создаёт новое событие или назначает существующее. Если ev == NULL, создаётся динамическое событие. Возвращает указатель на событие или NULL при ошибке. */
 EXPORT_API uev_t *uevent_create_or_assign_event(uevent_t *ev, uevent_base_t *base, int fd, short events, uevent_cb_t cb, void *arg, const char *name);
 
@@ -183,6 +375,9 @@ EXPORT_API uevent_base_t *uevent_base_new(int max_events);
 /* Создаёт новую базу событий вместе с пулом воркеров для обработки колбеков */
 EXPORT_API uevent_base_t *uevent_base_new_with_workers(int max_events, int num_workers);
 
+/* Создаёт новую базу событий по набору параметров (бэкенд таймеров и т.д.) */
+EXPORT_API uevent_base_t *uevent_base_new_with_args(const uevent_base_args_t *args);
+
 /* получает текущее монотонное время в мс */
 EXPORT_API uint64_t tu_clock_gettime_monotonic_ms();
 
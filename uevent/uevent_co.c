@@ -0,0 +1,443 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "uevent.h"
+#include "uevent_co.h"
+#include "uevent_internal.h"
+
+#if !defined(__x86_64__)
+#include <ucontext.h>
+#endif
+
+#define UEV_CO_STACK_DEFAULT (64 * 1024)
+#define UEV_CO_POOL_DEFAULT 64
+
+// контекст приостановленной корутины или цикла
+typedef struct {
+#if defined(__x86_64__)
+  void *sp; // остальное лежит на самом стеке
+#else
+  ucontext_t uc;
+#endif
+} co_ctx_t;
+
+struct uev_co_t {
+  co_ctx_t ctx;
+  uev_co_sched_t *sched;
+  uev_co_fn_t fn;
+  void *arg;
+  const char *name;
+  void *map;         // отображение стека, заголовок корутины лежит в его верхушке
+  uev_co_t *run_next; // очередь готовых
+  uev_co_t *prev, *next; // все незавершенные корутины планировщика
+  bool done;
+
+  uev_t *io_uev;   // fd-событие последнего fd, который ждала корутина
+  int io_fd;
+  short io_wait;   // чего ждет корутина на io_fd, 0 — не ждет
+  uev_t *timers[2]; // сон: чередуются, чтобы не перевзводить таймер из его же колбэка
+  int timer_idx;
+  bool sleeping;
+
+  uevent_t *wait_ev; // событие uev_co_wait() и его подмененный колбэк
+  uevent_cb_t wait_cb;
+  void *wait_arg;
+  int wait_result;
+};
+
+struct uev_co_sched_t {
+  uevent_base_t *base;
+  size_t page;
+  size_t map_len; // стек с заголовком и сторожевой страницей
+  bool guard;
+  int pool_max;
+  int pool_cnt;
+  void **pool; // отображения стеков завершившихся корутин
+  uev_co_t *run_head, *run_tail;
+  bool run_posted;
+  uev_co_t *all;
+  int live;
+  co_ctx_t loop_ctx; // стек цикла, на который возвращаются корутины
+};
+
+static __thread uev_co_t *co_current;
+
+#if defined(__x86_64__)
+// Переключение: callee-saved регистры кладутся на текущий стек, указатель стека
+// сохраняется в *save, загружается *load, регистры снимаются уже с нового стека.
+// Вход новой корутины: ret на co_boot, rbx — корутина, r12 — co_main.
+void co_switch(void **save, void **load) __asm__("uev_co_switch");
+void co_boot(void) __asm__("uev_co_boot");
+__asm__(".pushsection .text\n"
+        ".p2align 4\n"
+        ".type uev_co_switch, @function\n"
+        "uev_co_switch:\n"
+        "  pushq %rbp\n"
+        "  pushq %rbx\n"
+        "  pushq %r12\n"
+        "  pushq %r13\n"
+        "  pushq %r14\n"
+        "  pushq %r15\n"
+        "  movq %rsp, (%rdi)\n"
+        "  movq (%rsi), %rsp\n"
+        "  popq %r15\n"
+        "  popq %r14\n"
+        "  popq %r13\n"
+        "  popq %r12\n"
+        "  popq %rbx\n"
+        "  popq %rbp\n"
+        "  ret\n"
+        ".size uev_co_switch, .-uev_co_switch\n"
+        ".type uev_co_boot, @function\n"
+        "uev_co_boot:\n"
+        "  movq %rbx, %rdi\n"
+        "  call *%r12\n"
+        "  ud2\n"
+        ".size uev_co_boot, .-uev_co_boot\n"
+        ".popsection\n");
+#endif
+
+static void co_main(uev_co_t *co) {
+  co->fn(co->arg);
+  co->done = true;
+  co_current = NULL;
+#if defined(__x86_64__)
+  co_switch(&co->ctx.sp, &co->sched->loop_ctx.sp);
+#else
+  setcontext(&co->sched->loop_ctx.uc);
+#endif
+}
+
+#if !defined(__x86_64__)
+// makecontext передает только int-аргументы: указатель идет двумя половинами
+static void co_main_uc(unsigned int hi, unsigned int lo) {
+  co_main((uev_co_t *)(((uintptr_t)hi << 32) | (uintptr_t)lo));
+}
+#endif
+
+static int co_ctx_init(uev_co_t *co, char *stack, size_t size) {
+#if defined(__x86_64__)
+  // после шести pop и ret указатель стека выровнен на 16, как перед call
+  uintptr_t top = ((uintptr_t)stack + size) & ~(uintptr_t)15;
+  void **sp = (void **)(top - 72);
+  memset(sp, 0, 72);
+  sp[3] = (void *)co_main; // r12
+  sp[4] = co;              // rbx
+  sp[6] = (void *)co_boot; // адрес возврата
+  co->ctx.sp = sp;
+  return 0;
+#else
+  if (getcontext(&co->ctx.uc) != 0) return -1;
+  co->ctx.uc.uc_stack.ss_sp = stack;
+  co->ctx.uc.uc_stack.ss_size = size;
+  co->ctx.uc.uc_link = NULL;
+  uintptr_t p = (uintptr_t)co;
+  makecontext(&co->ctx.uc, (void (*)(void))co_main_uc, 2, (unsigned int)(p >> 32), (unsigned int)p);
+  return 0;
+#endif
+}
+
+static void *stack_map(uev_co_sched_t *s) {
+  if (s->pool_cnt > 0) return s->pool[--s->pool_cnt];
+  // MAP_NORESERVE: в память попадают только тронутые страницы стека, без учета в overcommit
+  void *map = mmap(NULL, s->map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK,
+                   -1, 0);
+  if (map == MAP_FAILED) return NULL;
+  if (s->guard && mprotect(map, s->page, PROT_NONE) != 0) {
+    syslog2(LOG_ERR, "coroutine stack guard failed: %s", strerror(errno));
+    munmap(map, s->map_len);
+    return NULL;
+  }
+  return map;
+}
+
+static void stack_unmap(uev_co_sched_t *s, void *map) {
+  if (s->pool_cnt < s->pool_max) {
+    s->pool[s->pool_cnt++] = map;
+    return;
+  }
+  munmap(map, s->map_len);
+}
+
+static void co_destroy(uev_co_t *co) {
+  uev_co_sched_t *s = co->sched;
+  if (co->wait_ev != NULL) {
+    co->wait_ev->cb = co->wait_cb;
+    co->wait_ev->arg = co->wait_arg;
+  }
+  uevent_free(co->io_uev);
+  uevent_free(co->timers[0]);
+  uevent_free(co->timers[1]);
+  if (co->prev) co->prev->next = co->next;
+  else s->all = co->next;
+  if (co->next) co->next->prev = co->prev;
+  s->live--;
+  // заголовок лежит в самом отображении: после этого co недоступна
+  stack_unmap(s, co->map);
+}
+
+// продолжает корутину со стека цикла до ее следующей приостановки
+static void co_resume(uev_co_t *co) {
+  uev_co_sched_t *s = co->sched;
+  co_current = co;
+#if defined(__x86_64__)
+  co_switch(&s->loop_ctx.sp, &co->ctx.sp);
+#else
+  swapcontext(&s->loop_ctx.uc, &co->ctx.uc);
+#endif
+  co_current = NULL;
+  if (co->done) co_destroy(co);
+}
+
+static void co_suspend(uev_co_t *co) {
+  co_current = NULL;
+#if defined(__x86_64__)
+  co_switch(&co->ctx.sp, &co->sched->loop_ctx.sp);
+#else
+  swapcontext(&co->ctx.uc, &co->sched->loop_ctx.uc);
+#endif
+  co_current = co;
+}
+
+static void sched_run(void *arg);
+
+static void co_ready(uev_co_t *co) {
+  uev_co_sched_t *s = co->sched;
+  co->run_next = NULL;
+  if (s->run_tail) s->run_tail->run_next = co;
+  else s->run_head = co;
+  s->run_tail = co;
+  if (s->run_posted) return;
+  if (uevent_post(s->base, sched_run, s) != UEV_ERR_OK) {
+    syslog2(LOG_ERR, "coroutine run queue post failed");
+    return;
+  }
+  s->run_posted = true;
+}
+
+// проход очереди готовых: только те, кто был в ней к началу прохода, уступившие ждут следующего
+static void sched_run(void *arg) {
+  uev_co_sched_t *s = arg;
+  s->run_posted = false;
+  uev_co_t *co = s->run_head;
+  uev_co_t *last = s->run_tail;
+  while (co != NULL) {
+    uev_co_t *next = co->run_next;
+    s->run_head = next;
+    if (next == NULL) s->run_tail = NULL;
+    bool is_last = co == last;
+    co_resume(co);
+    if (is_last) break;
+    co = next;
+  }
+}
+
+uev_co_sched_t *uev_co_sched_new(uevent_base_t *base, const uev_co_sched_args_t *args) {
+  // колбэки из воркеров возобновляли бы корутины вне потока цикла
+  if (base == NULL || uev_base_has_workers(base)) return NULL;
+  uev_co_sched_args_t a = {0};
+  if (args != NULL) a = *args;
+  uev_co_sched_t *s = calloc(1, sizeof(uev_co_sched_t));
+  if (s == NULL) return NULL;
+  s->base = base;
+  s->page = (size_t)sysconf(_SC_PAGESIZE);
+  size_t size = a.stack_size ? a.stack_size : UEV_CO_STACK_DEFAULT;
+  if (size < 4 * s->page) size = 4 * s->page;
+  size = (size + s->page - 1) & ~(s->page - 1);
+  s->guard = !a.no_guard;
+  s->map_len = size + (s->guard ? s->page : 0);
+  s->pool_max = a.pool_max < 0 ? 0 : (a.pool_max ? a.pool_max : UEV_CO_POOL_DEFAULT);
+  if (s->pool_max > 0) {
+    s->pool = calloc((size_t)s->pool_max, sizeof(void *));
+    if (s->pool == NULL) {
+      free(s);
+      return NULL;
+    }
+  }
+  return s;
+}
+
+void uev_co_sched_free(uev_co_sched_t *sched) {
+  if (sched == NULL) return;
+  while (sched->all != NULL) co_destroy(sched->all);
+  for (int i = 0; i < sched->pool_cnt; i++) munmap(sched->pool[i], sched->map_len);
+  free(sched->pool);
+  free(sched);
+}
+
+int uev_co_sched_live(const uev_co_sched_t *sched) {
+  return sched ? sched->live : 0;
+}
+
+int uev_co_spawn(uev_co_sched_t *sched, uev_co_fn_t fn, void *arg, const char *name) {
+  if (sched == NULL || fn == NULL) return UEV_ERR_INVAL;
+  char *map = stack_map(sched);
+  if (map == NULL) return UEV_ERR_ALLOC;
+  // заголовок в верхушке стека: первая же страница стека держит и его, отдельной аллокации нет
+  size_t hdr = (sizeof(uev_co_t) + 63) & ~(size_t)63;
+  uev_co_t *co = (uev_co_t *)(map + sched->map_len - hdr);
+  memset(co, 0, sizeof(uev_co_t));
+  co->sched = sched;
+  co->fn = fn;
+  co->arg = arg;
+  co->name = name;
+  co->map = map;
+  co->io_fd = -1;
+  char *stack = map + (sched->guard ? sched->page : 0);
+  if (co_ctx_init(co, stack, (size_t)((char *)co - stack)) != 0) {
+    stack_unmap(sched, map);
+    return UEV_ERR_ALLOC;
+  }
+  co->next = sched->all;
+  if (sched->all) sched->all->prev = co;
+  sched->all = co;
+  sched->live++;
+  co_ready(co);
+  return UEV_ERR_OK;
+}
+
+uev_co_t *uev_co_self(void) {
+  return co_current;
+}
+
+void uev_co_yield(void) {
+  uev_co_t *co = co_current;
+  if (co == NULL) return;
+  co_ready(co);
+  co_suspend(co);
+}
+
+// fd-событие корутины постоянное и edge-triggered на чтение и запись сразу: ожидание не
+// делает системных вызовов, лишние фронты отсеивает io_wait, а пропуска фронта нет, потому
+// что корутина ждет только после EAGAIN. Продолжается прямо из колбэка: uevent_add не нужен.
+static void co_io_cb(uevent_t *ev, int fd, short events, void *arg) {
+  (void)ev;
+  (void)fd;
+  uev_co_t *co = arg;
+  if (co->io_wait == 0 || !(events & (co->io_wait | UEV_ERROR | UEV_HUP))) return;
+  co->io_wait = 0;
+  co_resume(co);
+}
+
+static int co_wait_fd(uev_co_t *co, int fd, short what) {
+  if (co->io_uev == NULL || co->io_fd != fd) {
+    uevent_free(co->io_uev);
+    co->io_fd = -1;
+    co->io_uev = uevent_create_or_assign_event(NULL, co->sched->base, fd, UEV_READ | UEV_WRITE | UEV_PERSIST,
+                                               co_io_cb, co, co->name);
+    if (co->io_uev == NULL) {
+      errno = ENOMEM;
+      return -1;
+    }
+    if (uevent_add(co->io_uev, 0) != UEV_ERR_OK) {
+      uevent_free(co->io_uev);
+      co->io_uev = NULL;
+      errno = EINVAL;
+      return -1;
+    }
+    co->io_fd = fd;
+  }
+  co->io_wait = what;
+  co_suspend(co);
+  return 0;
+}
+
+ssize_t uev_co_read(int fd, void *buf, size_t n) {
+  for (;;) {
+    ssize_t r = read(fd, buf, n);
+    if (r >= 0) return r;
+    if (errno == EINTR) continue;
+    uev_co_t *co = co_current;
+    if ((errno != EAGAIN && errno != EWOULDBLOCK) || co == NULL) return -1;
+    if (co_wait_fd(co, fd, UEV_READ) != 0) return -1;
+  }
+}
+
+ssize_t uev_co_write(int fd, const void *buf, size_t n) {
+  size_t done = 0;
+  while (done < n) {
+    ssize_t r = write(fd, (const char *)buf + done, n - done);
+    if (r >= 0) {
+      done += (size_t)r;
+      continue;
+    }
+    if (errno == EINTR) continue;
+    uev_co_t *co = co_current;
+    if ((errno != EAGAIN && errno != EWOULDBLOCK) || co == NULL) return -1;
+    if (co_wait_fd(co, fd, UEV_WRITE) != 0) return -1;
+  }
+  return (ssize_t)n;
+}
+
+int uev_co_close(int fd) {
+  uev_co_t *co = co_current;
+  if (co != NULL && co->io_fd == fd) {
+    uevent_free(co->io_uev);
+    co->io_uev = NULL;
+    co->io_fd = -1;
+  }
+  return close(fd);
+}
+
+static void co_timer_cb(uevent_t *ev, int fd, short events, void *arg) {
+  (void)ev;
+  (void)fd;
+  (void)events;
+  uev_co_t *co = arg;
+  if (!co->sleeping) return;
+  co->sleeping = false;
+  co_resume(co);
+}
+
+int uev_co_sleep(int ms) {
+  uev_co_t *co = co_current;
+  if (co == NULL) return UEV_ERR_INVAL;
+  if (ms <= 0) {
+    uev_co_yield();
+    return UEV_ERR_OK;
+  }
+  // корутину мог продолжить колбэк прошлого таймера, он заблокирован до выхода из колбэка
+  co->timer_idx ^= 1;
+  uev_t **t = &co->timers[co->timer_idx];
+  if (*t == NULL) {
+    *t = uevent_create_or_assign_event(NULL, co->sched->base, -1, UEV_TIMEOUT, co_timer_cb, co, co->name);
+    if (*t == NULL) return UEV_ERR_ALLOC;
+  }
+  int ret = uevent_add(*t, ms);
+  if (ret != UEV_ERR_OK) return ret;
+  co->sleeping = true;
+  co_suspend(co);
+  return UEV_ERR_OK;
+}
+
+static void co_wait_cb(uevent_t *ev, int fd, short events, void *arg) {
+  (void)fd;
+  uev_co_t *co = arg;
+  ev->cb = co->wait_cb;
+  ev->arg = co->wait_arg;
+  co->wait_ev = NULL;
+  co->wait_result = events;
+  co_ready(co);
+}
+
+int uev_co_wait(uev_t *uev) {
+  uev_co_t *co = co_current;
+  if (co == NULL || uev == NULL) return UEV_ERR_INVAL;
+  uevent_t *ev = ATOM_LOAD_ACQ(uev->ev);
+  if (ev == NULL || uev_st_test(ev, UEV_ST_PENDING_FREE)) return UEV_ERR_PENDING_FREE;
+  co->wait_cb = ev->cb;
+  co->wait_arg = ev->arg;
+  co->wait_ev = ev;
+  ev->cb = co_wait_cb;
+  ev->arg = co;
+  co_suspend(co);
+  return co->wait_result;
+}
@@ -0,0 +1,93 @@
+#ifndef LIBUEVENT_UEVENT_CO_H
+#define LIBUEVENT_UEVENT_CO_H
+
+#include "uevent.h"
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/**
+ * @brief Непрозрачный тип планировщика корутин базы.
+ *
+ * Корутины стековые: у каждой свой стек из пула, переключение — сохранение
+ * callee-saved регистров и указателя стека без системных вызовов (на x86_64,
+ * на других архитектурах через swapcontext). Корутина приостанавливается в
+ * uev_co_read()/uev_co_write()/uev_co_sleep()/uev_co_wait() и продолжается
+ * из обычной обработки событий цикла. Стек защищен сторожевой страницей снизу:
+ * переполнение дает SIGSEGV, а не порчу соседней памяти. Каждая сторожевая
+ * страница — отдельная область в ядре, при vm.max_map_count = 65530 защищенных
+ * стеков не больше ~32 тысяч, для большего числа корутин args.no_guard.
+ * Детали скрыты в uevent_co.c.
+ *
+ * Планировщик не потокобезопасен: корутины выполняются в потоке цикла базы без
+ * воркеров (num_workers = 0), функции вызываются из этого потока.
+ */
+typedef struct uev_co_sched_t uev_co_sched_t;
+
+/* Непрозрачный тип корутины, действителен до возврата из ее функции */
+typedef struct uev_co_t uev_co_t;
+
+/* функция корутины */
+typedef void (*uev_co_fn_t)(void *arg);
+
+/* параметры планировщика, нулевые поля означают значения по умолчанию */
+typedef struct {
+  size_t stack_size; /* стек корутины вместе с ее заголовком, 0 — 64 КиБ, округляется до страницы */
+  int pool_max;      /* стеков завершившихся корутин в пуле для повторной выдачи, 0 — 64, -1 — без пула */
+  bool no_guard;     /* без сторожевой страницы: одно отображение на стек вместо двух */
+} uev_co_sched_args_t;
+
+/* Создаёт планировщик корутин базы. args может быть NULL. Возвращает NULL при ошибке и для базы с воркерами. */
+EXPORT_API uev_co_sched_t *uev_co_sched_new(uevent_base_t *base, const uev_co_sched_args_t *args);
+
+/*
+ * Освобождает планировщик, пул стеков и незавершенные корутины (их функции не
+ * возвращаются). Вызывается вне корутин, когда цикл не выполняет его вызовы из uevent_post().
+ */
+EXPORT_API void uev_co_sched_free(uev_co_sched_t *sched);
+
+/* число незавершенных корутин */
+EXPORT_API int uev_co_sched_live(const uev_co_sched_t *sched);
+
+/*
+ * Создаёт корутину fn(arg) и ставит ее в очередь готовых: первый раз она выполняется
+ * в ближайшей итерации цикла. Возвращает UEV_ERR_OK или код ошибки.
+ */
+EXPORT_API int uev_co_spawn(uev_co_sched_t *sched, uev_co_fn_t fn, void *arg, const char *name);
+
+/* текущая корутина потока или NULL вне корутин */
+EXPORT_API uev_co_t *uev_co_self(void);
+
+/* Отдает управление циклу, корутина продолжается в следующем проходе очереди готовых. */
+EXPORT_API void uev_co_yield(void);
+
+/*
+ * read() неблокирующего fd, которое на EAGAIN приостанавливает корутину до готовности fd.
+ * Вне корутины — обычный read(). Возвращает число байт, 0 в конце данных или -1 (errno выставлен).
+ */
+EXPORT_API ssize_t uev_co_read(int fd, void *buf, size_t n);
+
+/*
+ * Пишет все n байт в неблокирующий fd, приостанавливая корутину на EAGAIN.
+ * Возвращает n или -1 (errno выставлен, часть данных могла уйти).
+ */
+EXPORT_API ssize_t uev_co_write(int fd, const void *buf, size_t n);
+
+/*
+ * Снимает fd корутины с опроса и закрывает его. fd, которые ждали uev_co_read()/uev_co_write(),
+ * закрываются только так: регистрация корутины живет до ее завершения или смены fd.
+ */
+EXPORT_API int uev_co_close(int fd);
+
+/* Приостанавливает корутину на ms миллисекунд, ms <= 0 — uev_co_yield(). Возвращает UEV_ERR_OK или код ошибки. */
+EXPORT_API int uev_co_sleep(int ms);
+
+/*
+ * Ждет одного срабатывания события uev: на это время колбэк события подменяется, корутина
+ * продолжается из очереди готовых уже вне колбэка и может снова вызвать uevent_add(uev).
+ * Событие запускает вызывающий. Возвращает маску сработавших событий (UEV_READ, UEV_TIMEOUT...)
+ * или отрицательный код ошибки.
+ */
+EXPORT_API int uev_co_wait(uev_t *uev);
+
+#endif /* LIBUEVENT_UEVENT_CO_H */
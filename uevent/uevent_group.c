@@ -0,0 +1,248 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../syslog2/syslog2.h"
+#include "uevent.h"
+#include "uevent_group.h"
+
+#define UEV_GROUP_DEFAULT_MAX_EVENTS 256
+#define UEV_GROUP_KEEPALIVE_MS 60000
+
+// один цикл группы: база и ее поток
+typedef struct {
+  uevent_base_group_t *group;
+  uevent_base_t *base;
+  int idx;
+  pthread_t thread;
+  bool started;
+  uev_t *keepalive; // периодический таймер без колбэка: цикл без событий не выходит из dispatch
+} uev_group_loop_t;
+
+struct uevent_base_group_t {
+  uev_group_loop_t *loops;
+  int num_loops;
+  uev_place_policy_t policy;
+  _Atomic unsigned int rr_next; // следующий цикл для UEV_PLACE_ROUND_ROBIN
+  _Atomic bool stopping;
+  bool running;
+};
+
+// ставится остановкой группы: loopbreak до входа в dispatch теряется, вызов из кольца — нет
+static void group_loop_stop_fn(void *arg) {
+  uev_group_loop_t *loop = arg;
+  if (atomic_load_explicit(&loop->group->stopping, memory_order_acquire)) {
+    uevent_base_loopbreak(loop->base);
+  }
+}
+
+// номер idx-го CPU из доступных процессу, с заворотом, или -1
+static int group_pick_cpu(const cpu_set_t *allowed, int idx) {
+  int count = CPU_COUNT(allowed);
+  if (count <= 0) return -1;
+  int want = idx % count;
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (!CPU_ISSET(cpu, allowed)) continue;
+    if (want-- == 0) return cpu;
+  }
+  return -1;
+}
+
+static void *group_loop_thread(void *arg) {
+  uev_group_loop_t *loop = arg;
+
+  // привязку к CPU (pin_cpus, loop_placement) применяет uevent_base_dispatch() при входе
+  char name[16];
+  snprintf(name, sizeof(name), "uev_loop%d", loop->idx);
+  pthread_setname_np(pthread_self(), name);
+
+  // uevent_base_loopbreak() снимает таймеры, поэтому таймер удержания ставится перед каждым входом
+  while (!atomic_load_explicit(&loop->group->stopping, memory_order_acquire)) {
+    (void)uevent_add(loop->keepalive, UEV_GROUP_KEEPALIVE_MS);
+    if (uevent_base_dispatch(loop->base) != UEV_ERR_OK) break;
+  }
+  return NULL;
+}
+
+static void group_loop_deinit(uev_group_loop_t *loop) {
+  if (loop->keepalive != NULL) {
+    uevent_free(loop->keepalive);
+    loop->keepalive = NULL;
+  }
+  if (loop->base != NULL) {
+    uevent_deinit(loop->base);
+    loop->base = NULL;
+  }
+}
+
+static int group_loop_init(uevent_base_group_t *group, uev_group_loop_t *loop, int idx, const uevent_base_args_t *base_args) {
+  loop->group = group;
+  loop->idx = idx;
+
+  loop->base = uevent_base_new_with_args(base_args);
+  if (loop->base == NULL) return UEV_ERR_ALLOC;
+
+  loop->keepalive = uevent_create_or_assign_event(NULL, loop->base, -1, UEV_TIMEOUT | UEV_PERSIST, NULL, NULL,
+                                                  "group_keepalive");
+  return loop->keepalive != NULL ? UEV_ERR_OK : UEV_ERR_ALLOC;
+}
+
+uevent_base_group_t *uevent_base_group_new(const uevent_base_group_args_t *args) {
+  uevent_base_group_args_t defaults = {0};
+  if (args == NULL) args = &defaults;
+  if (args->num_loops < 0) return NULL;
+
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    syslog2(LOG_WARNING, "sched_getaffinity failed: %s", strerror(errno));
+    CPU_ZERO(&allowed);
+  }
+
+  int num_loops = args->num_loops;
+  if (num_loops == 0) {
+    num_loops = CPU_COUNT(&allowed) > 0 ? CPU_COUNT(&allowed) : 1;
+  }
+
+  uevent_base_group_t *group = calloc(1, sizeof(uevent_base_group_t));
+  if (group == NULL) return NULL;
+  group->loops = calloc((size_t)num_loops, sizeof(uev_group_loop_t));
+  if (group->loops == NULL) {
+    free(group);
+    return NULL;
+  }
+  group->policy = args->policy;
+
+  // pin_cpus задает CPU через loop_placement базы: две привязки одного потока спорили бы
+  if (args->pin_cpus && args->base_args.loop_placement != NULL && args->base_args.loop_placement->ncpus > 0) {
+    syslog2(LOG_ERR, "pin_cpus conflicts with base_args.loop_placement cpus");
+    free(group->loops);
+    free(group);
+    return NULL;
+  }
+
+  uevent_base_args_t base_args = args->base_args;
+  if (base_args.max_events == 0) base_args.max_events = UEV_GROUP_DEFAULT_MAX_EVENTS;
+  uevent_thread_placement_t pin = {0};
+  if (args->base_args.loop_placement != NULL) pin = *args->base_args.loop_placement;
+  int pin_cpu = -1;
+  atomic_init(&group->rr_next, 0);
+  atomic_init(&group->stopping, false);
+
+  for (int i = 0; i < num_loops; i++) {
+    group->num_loops = i + 1;
+    // размещение копируется базой при создании, pin и pin_cpu нужны только до возврата
+    if (args->pin_cpus && (pin_cpu = group_pick_cpu(&allowed, i)) >= 0) {
+      pin.cpus = &pin_cpu;
+      pin.ncpus = 1;
+      base_args.loop_placement = &pin;
+    }
+    if (group_loop_init(group, &group->loops[i], i, &base_args) != UEV_ERR_OK) {
+      syslog2(LOG_ERR, "failed to create loop=%d of %d", i, num_loops);
+      uevent_base_group_free(group);
+      return NULL;
+    }
+  }
+  return group;
+}
+
+int uevent_base_group_start(uevent_base_group_t *group) {
+  if (group == NULL) return UEV_ERR_INVAL;
+  if (group->running) return UEV_ERR_BUSY;
+
+  atomic_store_explicit(&group->stopping, false, memory_order_release);
+  group->running = true;
+  for (int i = 0; i < group->num_loops; i++) {
+    uev_group_loop_t *loop = &group->loops[i];
+    if (pthread_create(&loop->thread, NULL, group_loop_thread, loop) != 0) {
+      syslog2(LOG_ERR, "failed to start loop=%d", i);
+      uevent_base_group_stop(group);
+      return UEV_ERR_ALLOC;
+    }
+    loop->started = true;
+  }
+  return UEV_ERR_OK;
+}
+
+void uevent_base_group_stop(uevent_base_group_t *group) {
+  if (group == NULL || !group->running) return;
+
+  atomic_store_explicit(&group->stopping, true, memory_order_release);
+  for (int i = 0; i < group->num_loops; i++) {
+    uev_group_loop_t *loop = &group->loops[i];
+    if (!loop->started) continue;
+    // цикл, еще не вошедший в dispatch, выполнит вызов из кольца и остановится сам
+    uevent_base_loopbreak(loop->base);
+    while (uevent_post(loop->base, group_loop_stop_fn, loop) == UEV_ERR_BUSY) sched_yield();
+  }
+  for (int i = 0; i < group->num_loops; i++) {
+    uev_group_loop_t *loop = &group->loops[i];
+    if (!loop->started) continue;
+    pthread_join(loop->thread, NULL);
+    loop->started = false;
+  }
+  group->running = false;
+}
+
+void uevent_base_group_free(uevent_base_group_t *group) {
+  if (group == NULL) return;
+  uevent_base_group_stop(group);
+  for (int i = 0; i < group->num_loops; i++) {
+    group_loop_deinit(&group->loops[i]);
+  }
+  free(group->loops);
+  free(group);
+}
+
+int uevent_base_group_size(const uevent_base_group_t *group) {
+  return group ? group->num_loops : 0;
+}
+
+uevent_base_t *uevent_base_group_get(uevent_base_group_t *group, int idx) {
+  if (group == NULL || idx < 0 || idx >= group->num_loops) return NULL;
+  return group->loops[idx].base;
+}
+
+uevent_base_t *uevent_base_group_pick(uevent_base_group_t *group, int fd) {
+  if (group == NULL || group->num_loops == 0) return NULL;
+
+  int idx = 0;
+  switch (group->policy) {
+  case UEV_PLACE_FD_HASH:
+    if (fd < 0) return NULL;
+    // мультипликативный хеш Кнута, соседние fd расходятся по разным циклам
+    idx = (int)(((uint32_t)fd * 2654435761U) % (uint32_t)group->num_loops);
+    break;
+  case UEV_PLACE_LEAST_LOADED: {
+    int best = -1;
+    for (int i = 0; i < group->num_loops; i++) {
+      int load = uevent_base_load(group->loops[i].base);
+      if (best < 0 || load < best) {
+        best = load;
+        idx = i;
+      }
+    }
+    break;
+  }
+  case UEV_PLACE_ROUND_ROBIN:
+  default:
+    idx = (int)(atomic_fetch_add_explicit(&group->rr_next, 1, memory_order_relaxed) % (unsigned int)group->num_loops);
+    break;
+  }
+  return group->loops[idx].base;
+}
+
+int uevent_base_group_post(uevent_base_group_t *group, int idx, uevent_post_fn_t fn, void *arg) {
+  if (group == NULL || idx < 0 || idx >= group->num_loops) return UEV_ERR_INVAL;
+  return uevent_post(uevent_base_group_get(group, idx), fn, arg);
+}
@@ -0,0 +1,58 @@
+#ifndef LIBUEVENT_UEVENT_GROUP_H
+#define LIBUEVENT_UEVENT_GROUP_H
+
+#include "uevent.h"
+
+#include <stdbool.h>
+
+/**
+ * @brief Непрозрачный тип группы баз событий (по циклу на ядро).
+ *
+ * Каждая база группы имеет свой epoll fd, свою очередь таймеров, свой base_mut
+ * и, при необходимости, свой пул воркеров. Детали реализации скрыты в uevent_group.c.
+ */
+typedef struct uevent_base_group_t uevent_base_group_t;
+
+/* политика выбора цикла для нового fd */
+typedef enum {
+  UEV_PLACE_ROUND_ROBIN = 0,  /* по кругу */
+  UEV_PLACE_LEAST_LOADED = 1, /* цикл с наименьшим числом активных fd и таймеров */
+  UEV_PLACE_FD_HASH = 2,      /* по хешу fd, один и тот же fd всегда попадает в один цикл */
+} uev_place_policy_t;
+
+/* параметры создания группы, нулевые поля означают значения по умолчанию */
+typedef struct {
+  int num_loops;                /* число циклов, 0 — по числу доступных процессу CPU */
+  bool pin_cpus;                /* привязать поток i-го цикла к i-му доступному CPU через base_args.loop_placement; вместе с cpus в loop_placement — ошибка */
+  uev_place_policy_t policy;    /* политика uevent_base_group_pick() */
+  uevent_base_args_t base_args; /* параметры каждой базы группы, max_events 0 — 256 */
+} uevent_base_group_args_t;
+
+/* Создаёт группу баз. Циклы не запущены. Возвращает NULL при ошибке. */
+EXPORT_API uevent_base_group_t *uevent_base_group_new(const uevent_base_group_args_t *args);
+
+/* Запускает по потоку uevent_base_dispatch() на каждую базу. Возвращает UEV_ERR_OK или код ошибки. */
+EXPORT_API int uevent_base_group_start(uevent_base_group_t *group);
+
+/* Останавливает циклы и дожидается их потоков. Базы остаются живыми до uevent_base_group_free(). */
+EXPORT_API void uevent_base_group_stop(uevent_base_group_t *group);
+
+/* Останавливает группу (если запущена) и освобождает все базы. */
+EXPORT_API void uevent_base_group_free(uevent_base_group_t *group);
+
+/* число циклов в группе */
+EXPORT_API int uevent_base_group_size(const uevent_base_group_t *group);
+
+/* база цикла с номером idx или NULL */
+EXPORT_API uevent_base_t *uevent_base_group_get(uevent_base_group_t *group, int idx);
+
+/* выбирает базу для fd по политике группы (fd < 0 допустим для таймеров, кроме UEV_PLACE_FD_HASH) */
+EXPORT_API uevent_base_t *uevent_base_group_pick(uevent_base_group_t *group, int fd);
+
+/*
+ * uevent_post() в базу цикла idx: fn(arg) выполняется в потоке цикла, даже если у базы
+ * есть воркеры. Возвращает UEV_ERR_OK, UEV_ERR_INVAL или UEV_ERR_BUSY при заполненном кольце.
+ */
+EXPORT_API int uevent_base_group_post(uevent_base_group_t *group, int idx, uevent_post_fn_t fn, void *arg);
+
+#endif /* LIBUEVENT_UEVENT_GROUP_H */
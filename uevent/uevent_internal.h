@@ -20,13 +20,30 @@ static inline bool internal_is_fd_event(const uevent_t *ev) {
 }
 
 // --- Атомарные действия (atomic, не требуют синхронизации) ---
+static inline bool uev_st_test(const uevent_t *ev, uint32_t bits) {
+  return (atomic_load_explicit(&((uevent_t *)ev)->state, memory_order_acquire) & bits) != 0;
+}
+// ставит биты, возвращает true, если хотя бы один уже стоял
+static inline bool uev_st_set(uevent_t *ev, uint32_t bits) {
+  return (atomic_fetch_or_explicit(&ev->state, bits, memory_order_acq_rel) & bits) != 0;
+}
+// снимает биты, возвращает true, если хотя бы один стоял
+static inline bool uev_st_clear(uevent_t *ev, uint32_t bits) {
+  return (atomic_fetch_and_explicit(&ev->state, ~bits, memory_order_acq_rel) & bits) != 0;
+}
 static inline bool atomic_deactivate_fd(uevent_t *ev) {
-  return atomic_exchange_explicit(&ev->active_fd, false, memory_order_acq_rel);
+  return uev_st_clear(ev, UEV_ST_ACTIVE_FD);
 }
 static inline bool atomic_deactivate_timer(uevent_t *ev) {
-  return atomic_exchange_explicit(&ev->active_timer, false, memory_order_acq_rel);
+  return uev_st_clear(ev, UEV_ST_ACTIVE_TIMER);
 }
 
+// задержка в мс от cron_time (мс по часам базы) до текущих показаний тех же часов
+int64_t uev_base_timer_lag_ms(const uevent_base_t *base, uint64_t cron_time);
+
+// колбэки базы уходят в пул воркеров
+bool uev_base_has_workers(const uevent_base_t *base);
+
 // --- Требуют внешней синхронизации (unsafe) ---
 
 // проверяет нужно ли удалить fd событие из epoll
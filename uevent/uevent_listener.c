@@ -0,0 +1,197 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "uevent.h"
+#include "uevent_listener.h"
+
+struct uevent_listener_t {
+  uev_t *uev;
+  uevent_base_t *base;
+  int fd;
+  int reserve_fd; // запасной дескриптор: освобождается, чтобы принять и сбросить соединение при EMFILE/ENFILE
+  uevent_accept_cb_t cb;
+  void *arg;
+  _Atomic unsigned long accepted;
+  bool owns_fd; // сокет создан для слушателя (SO_REUSEPORT) и закрывается вместе с ним
+  int in_cb;
+  bool free_pending;
+};
+
+static void listener_destroy(uevent_listener_t *l) {
+  uevent_free(l->uev);
+  if (l->owns_fd) close(l->fd);
+  if (l->reserve_fd >= 0) close(l->reserve_fd);
+  free(l);
+}
+
+static int listener_reserve_open(void) {
+  return open("/dev/null", O_RDONLY | O_CLOEXEC);
+}
+
+// дескрипторы кончились: соединение остается в очереди, а нового фронта EPOLLET
+// не будет — принимаем его на место запасного дескриптора и сразу закрываем
+static bool listener_shed(uevent_listener_t *l, int fd) {
+  if (l->reserve_fd < 0) l->reserve_fd = listener_reserve_open();
+  if (l->reserve_fd < 0) return false;
+  close(l->reserve_fd);
+  int cfd = accept4(fd, NULL, NULL, SOCK_CLOEXEC);
+  if (cfd >= 0) close(cfd);
+  l->reserve_fd = listener_reserve_open();
+  return cfd >= 0;
+}
+
+// принимаем до EAGAIN: при EPOLLET следующего фронта по уже ждущим соединениям не будет
+static void listener_ev_cb(uevent_t *ev, int fd, short events, void *arg) {
+  (void)ev;
+  (void)events;
+  uevent_listener_t *l = arg;
+  l->in_cb++;
+
+  while (!l->free_pending) {
+    struct sockaddr_storage ss;
+    socklen_t len = sizeof(ss);
+    int cfd = accept4(fd, (struct sockaddr *)&ss, &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (cfd < 0) {
+      // соединение сбросили до accept: в очереди могут быть следующие
+      if (errno == EINTR || errno == ECONNABORTED || errno == EPROTO) continue;
+      if (errno == EMFILE || errno == ENFILE) {
+        int err = errno;
+        if (listener_shed(l, fd)) continue;
+        errno = err;
+      }
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        syslog2(LOG_WARNING, "accept4 failed fd=%d: %s", fd, strerror(errno));
+      }
+      break;
+    }
+    atomic_fetch_add_explicit(&l->accepted, 1, memory_order_relaxed);
+    l->cb(l, cfd, (struct sockaddr *)&ss, len, l->arg);
+  }
+
+  l->in_cb--;
+  if (l->free_pending && l->in_cb == 0) listener_destroy(l);
+}
+
+uevent_listener_t *uevent_listener_new(uevent_base_t *base, int fd, uevent_accept_cb_t cb, void *arg,
+                                       const char *name) {
+  if (base == NULL || fd < 0 || cb == NULL) return NULL;
+  uevent_listener_t *l = calloc(1, sizeof(uevent_listener_t));
+  if (l == NULL) return NULL;
+  l->base = base;
+  l->fd = fd;
+  l->cb = cb;
+  l->arg = arg;
+  l->reserve_fd = listener_reserve_open();
+  l->uev = uevent_create_or_assign_event(NULL, base, fd, UEV_READ | UEV_PERSIST | UEV_EXCLUSIVE, listener_ev_cb, l, name);
+  if (l->uev == NULL) {
+    if (l->reserve_fd >= 0) close(l->reserve_fd);
+    free(l);
+    return NULL;
+  }
+  return l;
+}
+
+void uevent_listener_free(uevent_listener_t *listener) {
+  if (listener == NULL) return;
+  if (listener->in_cb > 0) {
+    listener->free_pending = true;
+    return;
+  }
+  listener_destroy(listener);
+}
+
+int uevent_listener_enable(uevent_listener_t *listener) {
+  if (listener == NULL) return UEV_ERR_INVAL;
+  return uevent_add(listener->uev, 0);
+}
+
+int uevent_listener_fd(const uevent_listener_t *listener) {
+  return listener ? listener->fd : -1;
+}
+
+uevent_base_t *uevent_listener_base(const uevent_listener_t *listener) {
+  return listener ? listener->base : NULL;
+}
+
+unsigned long uevent_listener_accepted(const uevent_listener_t *listener) {
+  return listener ? atomic_load_explicit(&listener->accepted, memory_order_relaxed) : 0;
+}
+
+int uevent_listen_reuseport(const struct sockaddr *addr, socklen_t addrlen, int backlog) {
+  if (addr == NULL) {
+    errno = EINVAL;
+    return -1;
+  }
+  int fd = socket(addr->sa_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) return -1;
+  int one = 1;
+  if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+      setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0 ||
+      bind(fd, addr, addrlen) != 0 || listen(fd, backlog > 0 ? backlog : SOMAXCONN) != 0) {
+    int err = errno;
+    close(fd);
+    errno = err;
+    return -1;
+  }
+  return fd;
+}
+
+static void group_listeners_free(uevent_listener_t **out, int n) {
+  for (int i = 0; i < n; i++) {
+    uevent_listener_free(out[i]);
+    out[i] = NULL;
+  }
+}
+
+int uevent_base_group_listen(uevent_base_group_t *group, int fd, uevent_accept_cb_t cb, void *arg,
+                             const char *name, uevent_listener_t **out) {
+  if (group == NULL || fd < 0 || cb == NULL || out == NULL) return UEV_ERR_INVAL;
+  int n = uevent_base_group_size(group);
+  for (int i = 0; i < n; i++) {
+    out[i] = uevent_listener_new(uevent_base_group_get(group, i), fd, cb, arg, name);
+    int ret = out[i] ? uevent_listener_enable(out[i]) : UEV_ERR_ALLOC;
+    if (ret != UEV_ERR_OK) {
+      group_listeners_free(out, out[i] ? i + 1 : i);
+      return ret;
+    }
+  }
+  return UEV_ERR_OK;
+}
+
+int uevent_base_group_listen_reuseport(uevent_base_group_t *group, const struct sockaddr *addr,
+                                       socklen_t addrlen, int backlog, uevent_accept_cb_t cb, void *arg,
+                                       const char *name, uevent_listener_t **out) {
+  if (group == NULL || addr == NULL || cb == NULL || out == NULL) return UEV_ERR_INVAL;
+  int n = uevent_base_group_size(group);
+  for (int i = 0; i < n; i++) {
+    int fd = uevent_listen_reuseport(addr, addrlen, backlog);
+    if (fd < 0) {
+      syslog2(LOG_ERR, "SO_REUSEPORT listen failed: %s", strerror(errno));
+      group_listeners_free(out, i);
+      return UEV_ERR_INVAL;
+    }
+    out[i] = uevent_listener_new(uevent_base_group_get(group, i), fd, cb, arg, name);
+    if (out[i] == NULL) {
+      close(fd);
+      group_listeners_free(out, i);
+      return UEV_ERR_ALLOC;
+    }
+    out[i]->owns_fd = true;
+    int ret = uevent_listener_enable(out[i]);
+    if (ret != UEV_ERR_OK) {
+      group_listeners_free(out, i + 1);
+      return ret;
+    }
+  }
+  return UEV_ERR_OK;
+}
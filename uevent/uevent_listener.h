@@ -0,0 +1,78 @@
+#ifndef LIBUEVENT_UEVENT_LISTENER_H
+#define LIBUEVENT_UEVENT_LISTENER_H
+
+#include "uevent.h"
+#include "uevent_group.h"
+
+#include <sys/socket.h>
+
+/**
+ * @brief Непрозрачный тип слушателя: прием соединений на listen-сокете.
+ *
+ * По готовности сокета accept4() вызывается пачкой до EAGAIN, каждое соединение
+ * отдается колбэку уже неблокирующим. Один listen-сокет можно слушать из нескольких
+ * баз: событие регистрируется с UEV_EXCLUSIVE, и на новое соединение ядро будит
+ * одну базу, а не все. Когда у процесса кончились дескрипторы (EMFILE/ENFILE),
+ * ждущие соединения принимаются на запасной дескриптор слушателя и сразу
+ * закрываются, иначе они висели бы в очереди без нового фронта готовности.
+ * Детали скрыты в uevent_listener.c.
+ *
+ * Слушатель не потокобезопасен: функции вызываются из его колбэка или потоком,
+ * который владеет слушателем и не пересекается с колбэком.
+ */
+typedef struct uevent_listener_t uevent_listener_t;
+
+/* колбэк нового соединения: fd неблокирующий с FD_CLOEXEC, закрывает его получатель */
+typedef void (*uevent_accept_cb_t)(uevent_listener_t *listener, int fd, const struct sockaddr *addr,
+                                   socklen_t addrlen, void *arg);
+
+/*
+ * Создаёт слушатель неблокирующего listen-сокета fd. Прием не запущен до uevent_listener_enable().
+ * fd не закрывается при освобождении. Возвращает NULL при ошибке.
+ */
+EXPORT_API uevent_listener_t *uevent_listener_new(uevent_base_t *base, int fd, uevent_accept_cb_t cb, void *arg,
+                                                  const char *name);
+
+/* Освобождает слушатель. Из колбэка самого слушателя освобождение откладывается до выхода из него. */
+EXPORT_API void uevent_listener_free(uevent_listener_t *listener);
+
+/* Запускает прием соединений. Возвращает UEV_ERR_OK или код ошибки. */
+EXPORT_API int uevent_listener_enable(uevent_listener_t *listener);
+
+/* fd слушателя */
+EXPORT_API int uevent_listener_fd(const uevent_listener_t *listener);
+
+/* база, в цикле которой принимаются соединения */
+EXPORT_API uevent_base_t *uevent_listener_base(const uevent_listener_t *listener);
+
+/* сколько соединений принял слушатель */
+EXPORT_API unsigned long uevent_listener_accepted(const uevent_listener_t *listener);
+
+/*
+ * Создаёт неблокирующий listen-сокет с SO_REUSEADDR и SO_REUSEPORT на addr.
+ * Ядро распределяет соединения между сокетами одного порта по хешу.
+ * Возвращает fd или -1 (errno выставлен).
+ */
+EXPORT_API int uevent_listen_reuseport(const struct sockaddr *addr, socklen_t addrlen, int backlog);
+
+/*
+ * Запускает по слушателю общего fd в каждой базе группы. EPOLLEXCLUSIVE избавляет от
+ * пробуждения всех баз на каждое соединение, но нагрузку не делит: проснувшаяся база
+ * принимает очередь до EAGAIN, и соединения может забирать один цикл. Для распределения
+ * между циклами — uevent_base_group_listen_reuseport().
+ * out — массив на uevent_base_group_size() слушателей.
+ * Возвращает UEV_ERR_OK или код ошибки (созданные слушатели освобождаются).
+ */
+EXPORT_API int uevent_base_group_listen(uevent_base_group_t *group, int fd, uevent_accept_cb_t cb, void *arg,
+                                        const char *name, uevent_listener_t **out);
+
+/*
+ * То же через SO_REUSEPORT: каждая база группы получает свой сокет на addr, ядро делит
+ * соединения между ними по хешу адресов. Слушатели закрывают свои сокеты при освобождении.
+ * Возвращает UEV_ERR_OK или код ошибки.
+ */
+EXPORT_API int uevent_base_group_listen_reuseport(uevent_base_group_t *group, const struct sockaddr *addr,
+                                                  socklen_t addrlen, int backlog, uevent_accept_cb_t cb, void *arg,
+                                                  const char *name, uevent_listener_t **out);
+
+#endif /* LIBUEVENT_UEVENT_LISTENER_H */
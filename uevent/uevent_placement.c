@@ -0,0 +1,111 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "uevent_placement.h"
+
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "uevent.h"
+
+#define UEV_NUMA_MAX_NODES 1024 // бит в маске узлов для mbind
+
+int uev_placement_init(uev_placement_t *dst, const uevent_thread_placement_t *src) {
+  memset(dst, 0, sizeof(*dst));
+  if (src->ncpus < 0 || (src->ncpus > 0 && src->cpus == NULL)) return -1;
+  for (int i = 0; i < src->ncpus; i++) {
+    if (src->cpus[i] < 0 || src->cpus[i] >= CPU_SETSIZE) return -1;
+    CPU_SET(src->cpus[i], &dst->cpus);
+  }
+  dst->pin = src->ncpus > 0;
+
+  if (src->sched_policy == SCHED_FIFO || src->sched_policy == SCHED_RR) {
+    if (src->sched_priority < sched_get_priority_min(src->sched_policy) ||
+        src->sched_priority > sched_get_priority_max(src->sched_policy)) {
+      return -1;
+    }
+  } else if (src->sched_policy != SCHED_OTHER || src->sched_priority != 0) {
+    return -1;
+  }
+  if (src->nice < -20 || src->nice > 19) return -1;
+  dst->sched_policy = src->sched_policy;
+  dst->sched_priority = src->sched_priority;
+  dst->nice = src->nice;
+  return 0;
+}
+
+void uev_placement_apply(const uev_placement_t *p, const char *who, int idx) {
+  if (p->pin) {
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(p->cpus), &p->cpus);
+    if (rc != 0) syslog2(LOG_WARNING, "failed to pin %s=%d to %d cpus: %s", who, idx, CPU_COUNT(&p->cpus), strerror(rc));
+  }
+  if (p->sched_policy != SCHED_OTHER) {
+    struct sched_param sp = {.sched_priority = p->sched_priority};
+    int rc = pthread_setschedparam(pthread_self(), p->sched_policy, &sp);
+    if (rc != 0) {
+      syslog2(LOG_WARNING, "failed to set %s=%d policy=%d priority=%d: %s", who, idx, p->sched_policy,
+              p->sched_priority, strerror(rc));
+    }
+  }
+  // nice в Linux у каждого потока свой, задается по tid
+  if (p->nice != 0 && setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), p->nice) != 0) {
+    syslog2(LOG_WARNING, "failed to set %s=%d nice=%d: %s", who, idx, p->nice, strerror(errno));
+  }
+}
+
+// узел CPU по каталогу nodeN в sysfs, без NUMA в ядре каталога нет
+static int cpu_numa_node(int cpu) {
+  char path[64];
+  snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+  DIR *dir = opendir(path);
+  if (dir == NULL) return -1;
+  int node = -1;
+  struct dirent *de;
+  while ((de = readdir(dir)) != NULL) {
+    if (strncmp(de->d_name, "node", 4) == 0 && isdigit((unsigned char)de->d_name[4])) {
+      node = atoi(de->d_name + 4);
+      break;
+    }
+  }
+  closedir(dir);
+  return node;
+}
+
+int uev_numa_node_of(const cpu_set_t *cpus) {
+  if (cpus == NULL) {
+    unsigned int cpu, node;
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0) return -1;
+    return (int)node;
+  }
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (CPU_ISSET(cpu, cpus)) return cpu_numa_node(cpu);
+  }
+  return -1;
+}
+
+void uev_numa_bind(void *addr, size_t len, int node) {
+  if (node < 0 || node >= UEV_NUMA_MAX_NODES || addr == NULL) return;
+  uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+  uintptr_t start = ((uintptr_t)addr + page - 1) & ~(page - 1);
+  uintptr_t end = ((uintptr_t)addr + len) & ~(page - 1);
+  // страницы на краях делят с соседними выделениями malloc, их не трогаем
+  if (end <= start) return;
+
+  unsigned long mask[UEV_NUMA_MAX_NODES / (8 * sizeof(unsigned long))] = {0};
+  mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+  // maxnode у mbind на единицу больше числа бит маски
+  if (syscall(SYS_mbind, start, end - start, MPOL_PREFERRED, mask, UEV_NUMA_MAX_NODES + 1, MPOL_MF_MOVE) != 0) {
+    syslog2(LOG_NOTICE, "mbind to node=%d failed: %s", node, strerror(errno));
+  }
+}
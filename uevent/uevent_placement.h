@@ -0,0 +1,41 @@
+#ifndef LIBUEVENT_UEVENT_PLACEMENT_H
+#define LIBUEVENT_UEVENT_PLACEMENT_H
+
+#include <sched.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct uevent_thread_placement_t uevent_thread_placement_t;
+
+/* проверенная копия uevent_thread_placement_t, не ссылается на память вызывающего */
+typedef struct {
+  cpu_set_t cpus;
+  bool pin; // маска задана
+  int sched_policy;
+  int sched_priority;
+  int nice;
+} uev_placement_t;
+
+/**
+ * @brief Проверяет параметры размещения и копирует их в dst.
+ *
+ * @return 0 или -1, если номер CPU, политика, приоритет или nice вне допустимых значений.
+ */
+int uev_placement_init(uev_placement_t *dst, const uevent_thread_placement_t *src);
+
+/*
+ * Применяет размещение к вызывающему потоку. Ошибки (CPU вне cpuset процесса, нет прав
+ * на SCHED_FIFO) пишутся в лог, поток продолжает работать с прежними настройками.
+ */
+void uev_placement_apply(const uev_placement_t *p, const char *who, int idx);
+
+/* Узел NUMA первого CPU маски, при cpus == NULL — CPU вызывающего потока; -1, если узел неизвестен. */
+int uev_numa_node_of(const cpu_set_t *cpus);
+
+/*
+ * Предпочитает узел node для страниц, целиком лежащих в [addr, addr + len): новые страницы
+ * выделяются там, уже занятые переносятся. node < 0 — ничего не делает.
+ */
+void uev_numa_bind(void *addr, size_t len, int node);
+
+#endif /* LIBUEVENT_UEVENT_PLACEMENT_H */
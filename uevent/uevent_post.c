@@ -0,0 +1,91 @@
+#include "uevent_post.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define UEV_POST_CACHELINE 64
+
+// ячейка кольца: seq == pos — свободна для записи, seq == pos + 1 — опубликована
+typedef struct {
+  _Atomic size_t seq;
+  void (*fn)(void *);
+  void *arg;
+} uev_post_cell_t;
+
+// кольцо Вьюкова: писатели занимают позицию CAS по tail, читатель один и двигает head без CAS
+struct uev_post_ring {
+  uev_post_cell_t *cells;
+  size_t mask;
+  _Alignas(UEV_POST_CACHELINE) _Atomic size_t tail;
+  _Alignas(UEV_POST_CACHELINE) _Atomic size_t head;
+};
+
+uev_post_ring_t *uev_post_ring_create(size_t size) {
+  size_t cap = 2;
+  while (cap < size) cap <<= 1;
+
+  uev_post_ring_t *ring = aligned_alloc(UEV_POST_CACHELINE, sizeof(uev_post_ring_t));
+  if (ring == NULL) return NULL;
+  ring->cells = calloc(cap, sizeof(uev_post_cell_t));
+  if (ring->cells == NULL) {
+    free(ring);
+    return NULL;
+  }
+  ring->mask = cap - 1;
+  for (size_t i = 0; i < cap; i++) atomic_init(&ring->cells[i].seq, i);
+  atomic_init(&ring->tail, 0);
+  atomic_init(&ring->head, 0);
+  return ring;
+}
+
+void uev_post_ring_free(uev_post_ring_t *ring) {
+  if (ring == NULL) return;
+  free(ring->cells);
+  free(ring);
+}
+
+int uev_post_ring_push(uev_post_ring_t *ring, void (*fn)(void *), void *arg) {
+  size_t pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  for (;;) {
+    uev_post_cell_t *cell = &ring->cells[pos & ring->mask];
+    size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(&ring->tail, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+        cell->fn = fn;
+        cell->arg = arg;
+        atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+        return 0;
+      }
+    } else if (diff < 0) {
+      return -1; // читатель еще не освободил ячейку круга назад
+    } else {
+      pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    }
+  }
+}
+
+unsigned int uev_post_ring_run(uev_post_ring_t *ring) {
+  size_t pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  unsigned int done = 0;
+  // не больше круга за раз: быстрый писатель не должен держать цикл вечно
+  while (done <= ring->mask) {
+    uev_post_cell_t *cell = &ring->cells[pos & ring->mask];
+    if (atomic_load_explicit(&cell->seq, memory_order_acquire) != pos + 1) break;
+    void (*fn)(void *) = cell->fn;
+    void *arg = cell->arg;
+    atomic_store_explicit(&cell->seq, pos + ring->mask + 1, memory_order_release);
+    pos++;
+    atomic_store_explicit(&ring->head, pos, memory_order_relaxed);
+    fn(arg);
+    done++;
+  }
+  return done;
+}
+
+bool uev_post_ring_empty(const uev_post_ring_t *ring) {
+  size_t pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  const uev_post_cell_t *cell = &ring->cells[pos & ring->mask];
+  return atomic_load_explicit(&cell->seq, memory_order_acquire) != pos + 1;
+}
@@ -0,0 +1,46 @@
+#ifndef LIBUEVENT_UEVENT_POST_H
+#define LIBUEVENT_UEVENT_POST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Непрозрачный тип ограниченного кольца вызовов для uevent_post().
+ *
+ * Много писателей, один читатель (поток цикла). Ячейки выделены заранее,
+ * постановка в очередь без блокировок и без выделения памяти. Детали
+ * реализации скрыты в uevent_post.c.
+ */
+typedef struct uev_post_ring uev_post_ring_t;
+
+/**
+ * @brief Создает кольцо.
+ *
+ * @param size Число ячеек, округляется вверх до степени двойки.
+ * @return Указатель на кольцо или NULL при ошибке выделения памяти.
+ */
+uev_post_ring_t *uev_post_ring_create(size_t size);
+
+/** Освобождает кольцо, невыполненные вызовы отбрасываются. */
+void uev_post_ring_free(uev_post_ring_t *ring);
+
+/**
+ * @brief Ставит вызов fn(arg) в кольцо, вызывается из любого потока.
+ *
+ * @return 0 при успехе, -1 если кольцо заполнено.
+ */
+int uev_post_ring_push(uev_post_ring_t *ring, void (*fn)(void *), void *arg);
+
+/**
+ * @brief Выполняет готовые вызовы, не больше числа ячеек кольца за раз.
+ *
+ * Вызывается только одним потоком (потоком цикла).
+ *
+ * @return Число выполненных вызовов.
+ */
+unsigned int uev_post_ring_run(uev_post_ring_t *ring);
+
+/** true, если в кольце нет опубликованных вызовов. */
+bool uev_post_ring_empty(const uev_post_ring_t *ring);
+
+#endif /* LIBUEVENT_UEVENT_POST_H */
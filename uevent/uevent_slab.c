@@ -0,0 +1,224 @@
+#include "uevent_slab.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define UEV_SLAB_CHUNK (64 * 1024) // блок памяти под объекты
+#define UEV_SLAB_BATCH 32          // объектов за один обмен кеша потока со складом
+#define UEV_SLAB_TCACHE_MAX (2 * UEV_SLAB_BATCH)
+#define UEV_SLAB_TCACHE_SLOTS 4    // аллокаторов (баз), с которыми поток работает без вытеснения кеша
+
+// свободный объект: первое слово — следующий в списке
+typedef struct uev_slab_obj {
+  struct uev_slab_obj *next;
+} uev_slab_obj_t;
+
+struct uev_slab {
+  size_t obj_size; // шаг объектов в блоке: данные и метка потока-владельца в конце
+  size_t payload;  // размер, запрошенный при создании
+  size_t align;
+  uint64_t id;                 // уникален за время жизни процесса, отличает аллокатор на том же адресе
+  struct uev_slab *reg_next;   // реестр живых аллокаторов
+  pthread_mutex_t mut;         // склад и список блоков
+  uev_slab_obj_t *depot;
+  void **chunks;
+  unsigned int chunks_cnt;
+  unsigned int chunks_cap;
+  _Atomic unsigned long live;
+  _Atomic unsigned long nchunks;
+  _Atomic unsigned long remote_frees;
+};
+
+// кеш потока для одного аллокатора
+typedef struct {
+  uev_slab_t *slab;
+  uint64_t id;
+  uev_slab_obj_t *head;
+  unsigned int cnt;
+} uev_slab_tcache_t;
+
+static __thread uev_slab_tcache_t slab_tcache[UEV_SLAB_TCACHE_SLOTS];
+static __thread bool slab_tcache_registered;
+
+// метка потока, выдавшего объект: адрес его кешей уникален среди живых потоков
+static inline void **obj_owner(const uev_slab_t *slab, void *obj) {
+  return (void **)((char *)obj + slab->obj_size - sizeof(void *));
+}
+
+// реестр: кеш может сдать объекты в склад, только если аллокатор еще жив
+static pthread_mutex_t slab_reg_mut = PTHREAD_MUTEX_INITIALIZER;
+static uev_slab_t *slab_reg_head;
+static uint64_t slab_reg_next_id = 1;
+static pthread_once_t slab_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t slab_key;
+
+static void depot_push(uev_slab_t *slab, uev_slab_obj_t *head, uev_slab_obj_t *tail) {
+  pthread_mutex_lock(&slab->mut);
+  tail->next = slab->depot;
+  slab->depot = head;
+  pthread_mutex_unlock(&slab->mut);
+}
+
+// сдать весь кеш в склад; объекты мертвого аллокатора ушли вместе с его блоками
+static void tcache_drop(uev_slab_tcache_t *c) {
+  if (c->cnt > 0) {
+    pthread_mutex_lock(&slab_reg_mut);
+    for (uev_slab_t *s = slab_reg_head; s != NULL; s = s->reg_next) {
+      if (s != c->slab || s->id != c->id) continue;
+      uev_slab_obj_t *tail = c->head;
+      while (tail->next != NULL) tail = tail->next;
+      depot_push(s, c->head, tail);
+      break;
+    }
+    pthread_mutex_unlock(&slab_reg_mut);
+  }
+  memset(c, 0, sizeof(*c));
+}
+
+static void slab_thread_exit(void *arg) {
+  (void)arg;
+  for (int i = 0; i < UEV_SLAB_TCACHE_SLOTS; i++) tcache_drop(&slab_tcache[i]);
+}
+
+static void slab_key_init(void) {
+  (void)pthread_key_create(&slab_key, slab_thread_exit);
+}
+
+static uev_slab_tcache_t *tcache_get(uev_slab_t *slab) {
+  uev_slab_tcache_t *victim = &slab_tcache[0];
+  for (int i = 0; i < UEV_SLAB_TCACHE_SLOTS; i++) {
+    uev_slab_tcache_t *c = &slab_tcache[i];
+    if (c->slab == slab && c->id == slab->id) return c;
+    if (victim->slab != NULL && (c->slab == NULL || c->cnt < victim->cnt)) victim = c;
+  }
+  tcache_drop(victim);
+  victim->slab = slab;
+  victim->id = slab->id;
+  if (!slab_tcache_registered) {
+    // ненулевое значение ключа нужно, чтобы деструктор вызвался при выходе потока
+    pthread_once(&slab_key_once, slab_key_init);
+    (void)pthread_setspecific(slab_key, slab_tcache);
+    slab_tcache_registered = true;
+  }
+  return victim;
+}
+
+// новый блок нарезается целиком в склад, вызывается под slab->mut
+static int slab_grow(uev_slab_t *slab) {
+  if (slab->chunks_cnt == slab->chunks_cap) {
+    unsigned int cap = slab->chunks_cap ? slab->chunks_cap * 2 : 8U;
+    void **chunks = realloc(slab->chunks, cap * sizeof(void *));
+    if (chunks == NULL) return -1;
+    slab->chunks = chunks;
+    slab->chunks_cap = cap;
+  }
+  char *chunk = aligned_alloc(slab->align, UEV_SLAB_CHUNK);
+  if (chunk == NULL) return -1;
+  slab->chunks[slab->chunks_cnt++] = chunk;
+  size_t n = UEV_SLAB_CHUNK / slab->obj_size;
+  for (size_t i = n; i-- > 0;) {
+    uev_slab_obj_t *obj = (uev_slab_obj_t *)(chunk + i * slab->obj_size);
+    obj->next = slab->depot;
+    slab->depot = obj;
+  }
+  atomic_fetch_add_explicit(&slab->nchunks, 1, memory_order_relaxed);
+  return 0;
+}
+
+// пополнить пустой кеш пачкой из склада
+static int tcache_refill(uev_slab_t *slab, uev_slab_tcache_t *c) {
+  pthread_mutex_lock(&slab->mut);
+  if (slab->depot == NULL && slab_grow(slab) != 0) {
+    pthread_mutex_unlock(&slab->mut);
+    return -1;
+  }
+  uev_slab_obj_t *head = slab->depot, *tail = head;
+  unsigned int n = 1;
+  while (n < UEV_SLAB_BATCH && tail->next != NULL) {
+    tail = tail->next;
+    n++;
+  }
+  slab->depot = tail->next;
+  pthread_mutex_unlock(&slab->mut);
+  tail->next = NULL;
+  c->head = head;
+  c->cnt = n;
+  return 0;
+}
+
+uev_slab_t *uev_slab_create(size_t obj_size, size_t align) {
+  if (align < sizeof(void *)) align = sizeof(void *);
+  uev_slab_t *slab = calloc(1, sizeof(uev_slab_t));
+  if (slab == NULL) return NULL;
+  slab->align = align;
+  slab->payload = obj_size;
+  slab->obj_size = (obj_size + sizeof(void *) + align - 1) & ~(align - 1);
+  pthread_mutex_init(&slab->mut, NULL);
+  pthread_mutex_lock(&slab_reg_mut);
+  slab->id = slab_reg_next_id++;
+  slab->reg_next = slab_reg_head;
+  slab_reg_head = slab;
+  pthread_mutex_unlock(&slab_reg_mut);
+  return slab;
+}
+
+void uev_slab_free(uev_slab_t *slab) {
+  if (slab == NULL) return;
+  pthread_mutex_lock(&slab_reg_mut);
+  for (uev_slab_t **pp = &slab_reg_head; *pp != NULL; pp = &(*pp)->reg_next) {
+    if (*pp == slab) {
+      *pp = slab->reg_next;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&slab_reg_mut);
+  // кеш своего потока сбрасываем сразу, кеши чужих узнают о смерти по id
+  for (int i = 0; i < UEV_SLAB_TCACHE_SLOTS; i++) {
+    if (slab_tcache[i].slab == slab && slab_tcache[i].id == slab->id) memset(&slab_tcache[i], 0, sizeof(uev_slab_tcache_t));
+  }
+  for (unsigned int i = 0; i < slab->chunks_cnt; i++) free(slab->chunks[i]);
+  free(slab->chunks);
+  pthread_mutex_destroy(&slab->mut);
+  free(slab);
+}
+
+void *uev_slab_alloc(uev_slab_t *slab) {
+  uev_slab_tcache_t *c = tcache_get(slab);
+  if (c->head == NULL && tcache_refill(slab, c) != 0) return NULL;
+  uev_slab_obj_t *obj = c->head;
+  c->head = obj->next;
+  c->cnt--;
+  atomic_fetch_add_explicit(&slab->live, 1, memory_order_relaxed);
+  memset(obj, 0, slab->payload);
+  *obj_owner(slab, obj) = slab_tcache;
+  return obj;
+}
+
+void uev_slab_release(uev_slab_t *slab, void *ptr) {
+  if (ptr == NULL) return;
+  atomic_fetch_sub_explicit(&slab->live, 1, memory_order_relaxed);
+  if (*obj_owner(slab, ptr) != (void *)slab_tcache) atomic_fetch_add_explicit(&slab->remote_frees, 1, memory_order_relaxed);
+  uev_slab_tcache_t *c = tcache_get(slab);
+  uev_slab_obj_t *obj = ptr;
+  obj->next = c->head;
+  c->head = obj;
+  if (++c->cnt <= UEV_SLAB_TCACHE_MAX) return;
+
+  // переполнение: пачка из головы кеша уходит в склад одним захватом мьютекса
+  uev_slab_obj_t *head = c->head, *tail = head;
+  for (int i = 1; i < UEV_SLAB_BATCH; i++) tail = tail->next;
+  c->head = tail->next;
+  c->cnt -= UEV_SLAB_BATCH;
+  depot_push(slab, head, tail);
+}
+
+void uev_slab_counters(const uev_slab_t *slab, unsigned long *live, unsigned long *slabs,
+                       unsigned long *remote_frees) {
+  if (live) *live = atomic_load_explicit(&slab->live, memory_order_relaxed);
+  if (slabs) *slabs = atomic_load_explicit(&slab->nchunks, memory_order_relaxed);
+  if (remote_frees) *remote_frees = atomic_load_explicit(&slab->remote_frees, memory_order_relaxed);
+}
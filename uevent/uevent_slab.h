@@ -0,0 +1,43 @@
+#ifndef LIBUEVENT_UEVENT_SLAB_H
+#define LIBUEVENT_UEVENT_SLAB_H
+
+#include <stddef.h>
+
+/**
+ * @brief Непрозрачный тип слаб-аллокатора объектов одного размера (uevent_t базы).
+ *
+ * Память берется блоками по много объектов. У каждого потока свой кеш свободных
+ * объектов: выделение и освобождение в кеше идут без блокировок, общими остаются
+ * только счетчики статистики. Переполненный кеш возвращает в склад аллокатора
+ * пачку объектов под мьютексом, пустой кеш забирает пачку оттуда же. Кеши
+ * завершившихся потоков возвращаются в склад. Детали скрыты в uevent_slab.c.
+ */
+typedef struct uev_slab uev_slab_t;
+
+/**
+ * @brief Создает аллокатор.
+ *
+ * @param obj_size Размер объекта.
+ * @param align Выравнивание объектов, степень двойки не меньше sizeof(void *).
+ * @return Указатель на аллокатор или NULL при ошибке выделения памяти.
+ */
+uev_slab_t *uev_slab_create(size_t obj_size, size_t align);
+
+/** Освобождает аллокатор со всеми блоками, выданные объекты становятся недействительными. */
+void uev_slab_free(uev_slab_t *slab);
+
+/** Выдает обнуленный объект или NULL, вызывается из любого потока. */
+void *uev_slab_alloc(uev_slab_t *slab);
+
+/**
+ * @brief Возвращает объект в кеш вызывающего потока.
+ *
+ * Освобождение не тем потоком, который выдал объект, учитывается в счетчике remote_frees.
+ */
+void uev_slab_release(uev_slab_t *slab, void *obj);
+
+/** Счетчики аллокатора, читаются из любого потока без блокировок. */
+void uev_slab_counters(const uev_slab_t *slab, unsigned long *live, unsigned long *slabs,
+                       unsigned long *remote_frees);
+
+#endif /* LIBUEVENT_UEVENT_SLAB_H */
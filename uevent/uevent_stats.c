@@ -0,0 +1,148 @@
+#include "uevent_stats.h"
+#include "uevent.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define UEV_STATS_MAX_NAMES 128 // последняя запись — "(other)" для имен сверх лимита
+#define UEV_HIST_SUB_BITS 3     // 8 подкорзин на октаву, погрешность квантиля до 12.5%
+#define UEV_HIST_SUB (1U << UEV_HIST_SUB_BITS)
+#define UEV_HIST_MAX_EXP 40 // 2^40 мкс ~ 12 суток, дальше все в последней корзине
+#define UEV_HIST_BUCKETS ((UEV_HIST_MAX_EXP - UEV_HIST_SUB_BITS + 2) * UEV_HIST_SUB)
+
+// лог-линейная гистограмма в мкс: точные значения до 8, дальше по 8 корзин на степень двойки
+typedef struct {
+  _Atomic uint32_t buckets[UEV_HIST_BUCKETS];
+  _Atomic uint64_t max;
+} uev_hist_t;
+
+struct uev_stat_entry {
+  _Atomic(const char *) name;
+  _Atomic uint64_t count;
+  _Atomic uint64_t lag_count;
+  uev_hist_t lag;
+  uev_hist_t duration;
+};
+
+struct uev_stats {
+  uev_stat_entry_t entries[UEV_STATS_MAX_NAMES];
+};
+
+static unsigned int hist_index(uint64_t v) {
+  if (v < UEV_HIST_SUB) return (unsigned int)v;
+  unsigned int exp = 63U - (unsigned int)__builtin_clzll(v);
+  if (exp > UEV_HIST_MAX_EXP) return UEV_HIST_BUCKETS - 1;
+  unsigned int sub = (unsigned int)(v >> (exp - UEV_HIST_SUB_BITS)) & (UEV_HIST_SUB - 1);
+  return (exp - UEV_HIST_SUB_BITS + 1) * UEV_HIST_SUB + sub;
+}
+
+// верхняя граница значений корзины
+static uint64_t hist_bucket_high(unsigned int idx) {
+  if (idx < UEV_HIST_SUB) return idx;
+  unsigned int exp = idx / UEV_HIST_SUB + UEV_HIST_SUB_BITS - 1;
+  uint64_t sub = idx % UEV_HIST_SUB;
+  uint64_t width = 1ULL << (exp - UEV_HIST_SUB_BITS);
+  return ((UEV_HIST_SUB + sub) << (exp - UEV_HIST_SUB_BITS)) + width - 1;
+}
+
+static void hist_record(uev_hist_t *hist, uint64_t v) {
+  atomic_fetch_add_explicit(&hist->buckets[hist_index(v)], 1, memory_order_relaxed);
+  uint64_t max = atomic_load_explicit(&hist->max, memory_order_relaxed);
+  while (v > max && !atomic_compare_exchange_weak_explicit(&hist->max, &max, v, memory_order_relaxed, memory_order_relaxed)) {
+  }
+}
+
+// квантиль q (0..1) по снимку корзин, не больше наблюдавшегося максимума
+static uint64_t hist_quantile(const uint32_t *buckets, uint64_t total, uint64_t max, double q) {
+  if (total == 0) return 0;
+  uint64_t rank = (uint64_t)(q * (double)total);
+  if (rank == 0) rank = 1;
+  uint64_t seen = 0;
+  for (unsigned int i = 0; i < UEV_HIST_BUCKETS; i++) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      uint64_t high = hist_bucket_high(i);
+      return high < max ? high : max;
+    }
+  }
+  return max;
+}
+
+static void hist_summary(uev_hist_t *hist, uint64_t *p50, uint64_t *p99, uint64_t *max) {
+  uint32_t buckets[UEV_HIST_BUCKETS];
+  uint64_t total = 0;
+  for (unsigned int i = 0; i < UEV_HIST_BUCKETS; i++) {
+    buckets[i] = atomic_load_explicit(&hist->buckets[i], memory_order_relaxed);
+    total += buckets[i];
+  }
+  *max = atomic_load_explicit(&hist->max, memory_order_relaxed);
+  *p50 = hist_quantile(buckets, total, *max, 0.50);
+  *p99 = hist_quantile(buckets, total, *max, 0.99);
+}
+
+uev_stats_t *uev_stats_create(void) {
+  uev_stats_t *stats = calloc(1, sizeof(uev_stats_t));
+  if (stats == NULL) return NULL;
+  atomic_store_explicit(&stats->entries[UEV_STATS_MAX_NAMES - 1].name, "(other)", memory_order_release);
+  return stats;
+}
+
+void uev_stats_free(uev_stats_t *stats) {
+  free(stats);
+}
+
+static uint32_t name_hash(const char *name) {
+  uint32_t h = 2166136261U; // FNV-1a
+  for (; *name; name++) {
+    h ^= (unsigned char)*name;
+    h *= 16777619U;
+  }
+  return h;
+}
+
+uev_stat_entry_t *uev_stats_lookup(uev_stats_t *stats, const char *name) {
+  if (stats == NULL) return NULL;
+  if (name == NULL) name = "(null)";
+
+  const unsigned int slots = UEV_STATS_MAX_NAMES - 1;
+  unsigned int idx = name_hash(name) % slots;
+  for (unsigned int probe = 0; probe < slots; probe++, idx = (idx + 1) % slots) {
+    uev_stat_entry_t *entry = &stats->entries[idx];
+    const char *cur = atomic_load_explicit(&entry->name, memory_order_acquire);
+    // свободную запись занимаем CAS, проигравший сравнивает имя победителя
+    if (cur == NULL && atomic_compare_exchange_strong(&entry->name, &cur, name)) return entry;
+    if (cur == name || strcmp(cur, name) == 0) return entry;
+  }
+  return &stats->entries[UEV_STATS_MAX_NAMES - 1];
+}
+
+void uev_stat_record(uev_stat_entry_t *entry, bool has_lag, uint64_t lag_us, uint64_t duration_us) {
+  if (entry == NULL) return;
+  atomic_fetch_add_explicit(&entry->count, 1, memory_order_relaxed);
+  hist_record(&entry->duration, duration_us);
+  if (has_lag) {
+    atomic_fetch_add_explicit(&entry->lag_count, 1, memory_order_relaxed);
+    hist_record(&entry->lag, lag_us);
+  }
+}
+
+int uev_stats_snapshot(uev_stats_t *stats, uevent_stat_t *out, int max) {
+  if (stats == NULL) return 0;
+  int n = 0;
+  for (unsigned int i = 0; i < UEV_STATS_MAX_NAMES; i++) {
+    uev_stat_entry_t *entry = &stats->entries[i];
+    uint64_t count = atomic_load_explicit(&entry->count, memory_order_relaxed);
+    if (count == 0) continue;
+    if (out != NULL && n < max) {
+      uevent_stat_t *st = &out[n];
+      st->name = atomic_load_explicit(&entry->name, memory_order_acquire);
+      st->count = count;
+      st->lag_count = atomic_load_explicit(&entry->lag_count, memory_order_relaxed);
+      hist_summary(&entry->lag, &st->lag_p50_us, &st->lag_p99_us, &st->lag_max_us);
+      hist_summary(&entry->duration, &st->duration_p50_us, &st->duration_p99_us, &st->duration_max_us);
+    }
+    n++;
+  }
+  return n;
+}
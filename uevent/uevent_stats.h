@@ -0,0 +1,57 @@
+#ifndef LIBUEVENT_UEVENT_STATS_H
+#define LIBUEVENT_UEVENT_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct uevent_stat_t;
+
+/**
+ * @brief Статистика одного имени события (ev->name).
+ *
+ * Детали реализации скрыты в uevent_stats.c. Запись идет без блокировок,
+ * одна запись на вызов колбэка.
+ */
+typedef struct uev_stat_entry uev_stat_entry_t;
+
+/**
+ * @brief Таблица статистики базы: имя события -> гистограммы задержки и длительности.
+ *
+ * Число различных имен ограничено, события сверх лимита попадают в общую
+ * запись "(other)".
+ */
+typedef struct uev_stats uev_stats_t;
+
+/** Создает таблицу статистики или возвращает NULL при ошибке выделения памяти. */
+uev_stats_t *uev_stats_create(void);
+
+/** Освобождает таблицу статистики. */
+void uev_stats_free(uev_stats_t *stats);
+
+/**
+ * @brief Находит или заводит запись для имени события, без блокировок.
+ *
+ * Результат стоит кешировать в событии: поиск хеширует строку имени.
+ *
+ * @param name Имя события, NULL учитывается как "(null)". Строка должна жить
+ *        не меньше таблицы (как и ev->name).
+ */
+uev_stat_entry_t *uev_stats_lookup(uev_stats_t *stats, const char *name);
+
+/**
+ * @brief Учитывает один вызов колбэка.
+ *
+ * @param has_lag true для срабатываний таймера, у которых есть плановое время.
+ * @param lag_us Задержка от планового времени до начала колбэка, мкс.
+ * @param duration_us Длительность колбэка, мкс.
+ */
+void uev_stat_record(uev_stat_entry_t *entry, bool has_lag, uint64_t lag_us, uint64_t duration_us);
+
+/**
+ * @brief Снимок всех записей таблицы в out (не больше max).
+ *
+ * @return Общее число записей в таблице (может быть больше max).
+ */
+int uev_stats_snapshot(uev_stats_t *stats, struct uevent_stat_t *out, int max);
+
+#endif /* LIBUEVENT_UEVENT_STATS_H */
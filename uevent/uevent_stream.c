@@ -0,0 +1,420 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "uevent.h"
+#include "uevent_stream.h"
+
+#define UEV_STREAM_SEG_SIZE 16384 // сегмент цепочки, крупные записи получают сегмент под размер
+#define UEV_STREAM_MAX_IOV 16     // сегментов на один writev
+
+// сегмент цепочки: данные лежат в data[off, end)
+typedef struct uev_seg_t {
+  struct uev_seg_t *next;
+  size_t off;
+  size_t end;
+  size_t cap;
+  char data[];
+} uev_seg_t;
+
+// цепочка сегментов, один опустевший сегмент держим про запас, чтобы не звать malloc на каждое сообщение
+typedef struct {
+  uev_seg_t *head;
+  uev_seg_t *tail;
+  uev_seg_t *spare;
+  size_t len;
+} uev_chain_t;
+
+struct uevent_stream_t {
+  uev_t *uev;
+  int fd;
+  uevent_stream_cb_t read_cb;
+  uevent_stream_cb_t write_cb;
+  uevent_stream_event_cb_t event_cb;
+  void *arg;
+
+  uev_chain_t input;
+  uev_chain_t output;
+
+  size_t read_low;
+  size_t read_high;
+  size_t write_low;
+  size_t write_high;
+
+  short cur_events; // маска, зарегистрированная в базе
+  bool reading;     // чтение включено uevent_stream_enable()
+  bool read_paused; // входной буфер дошел до read_high
+  bool eof;
+  bool failed;
+  bool not_socket; // fd не сокет: sendmsg недоступен, пишем writev
+  int in_cb;
+  bool free_pending;
+};
+
+static uev_seg_t *chain_get_seg(uev_chain_t *chain, size_t min) {
+  if (chain->spare != NULL && chain->spare->cap >= min) {
+    uev_seg_t *seg = chain->spare;
+    chain->spare = NULL;
+    seg->off = seg->end = 0;
+    seg->next = NULL;
+    return seg;
+  }
+  size_t cap = min > UEV_STREAM_SEG_SIZE ? min : UEV_STREAM_SEG_SIZE;
+  uev_seg_t *seg = malloc(sizeof(uev_seg_t) + cap);
+  if (seg == NULL) return NULL;
+  seg->next = NULL;
+  seg->off = seg->end = 0;
+  seg->cap = cap;
+  return seg;
+}
+
+static void chain_put_seg(uev_chain_t *chain, uev_seg_t *seg) {
+  if (chain->spare == NULL && seg->cap == UEV_STREAM_SEG_SIZE) {
+    chain->spare = seg;
+  } else {
+    free(seg);
+  }
+}
+
+static void chain_link(uev_chain_t *chain, uev_seg_t *seg) {
+  if (chain->tail != NULL) {
+    chain->tail->next = seg;
+  } else {
+    chain->head = seg;
+  }
+  chain->tail = seg;
+}
+
+static int chain_append(uev_chain_t *chain, const char *data, size_t len) {
+  uev_seg_t *tail = chain->tail;
+  if (tail != NULL && tail->end < tail->cap) {
+    size_t n = tail->cap - tail->end;
+    if (n > len) n = len;
+    memcpy(tail->data + tail->end, data, n);
+    tail->end += n;
+    chain->len += n;
+    data += n;
+    len -= n;
+  }
+  if (len == 0) return 0;
+
+  uev_seg_t *seg = chain_get_seg(chain, len);
+  if (seg == NULL) return -1;
+  memcpy(seg->data, data, len);
+  seg->end = len;
+  chain_link(chain, seg);
+  chain->len += len;
+  return 0;
+}
+
+static size_t chain_drain(uev_chain_t *chain, size_t len) {
+  size_t done = 0;
+  while (done < len && chain->head != NULL) {
+    uev_seg_t *seg = chain->head;
+    size_t n = seg->end - seg->off;
+    if (n > len - done) n = len - done;
+    seg->off += n;
+    done += n;
+    if (seg->off < seg->end) break;
+    chain->head = seg->next;
+    if (chain->head == NULL) chain->tail = NULL;
+    chain_put_seg(chain, seg);
+  }
+  chain->len -= done;
+  return done;
+}
+
+static int chain_iov(const uev_chain_t *chain, struct iovec *iov, int max_iov) {
+  int n = 0;
+  for (uev_seg_t *seg = chain->head; seg != NULL && n < max_iov; seg = seg->next) {
+    if (seg->end == seg->off) continue;
+    iov[n].iov_base = seg->data + seg->off;
+    iov[n].iov_len = seg->end - seg->off;
+    n++;
+  }
+  return n;
+}
+
+static void chain_free(uev_chain_t *chain) {
+  uev_seg_t *seg = chain->head;
+  while (seg != NULL) {
+    uev_seg_t *next = seg->next;
+    free(seg);
+    seg = next;
+  }
+  free(chain->spare);
+  memset(chain, 0, sizeof(*chain));
+}
+
+// привести регистрацию fd к состоянию буферов: UEV_WRITE только при данных на запись
+static void stream_update_interest(uevent_stream_t *s) {
+  short want = 0;
+  if (s->failed) {
+    want = 0;
+  } else {
+    if (s->reading && !s->read_paused && !s->eof) want |= UEV_READ;
+    if (s->output.len > 0) want |= UEV_WRITE;
+  }
+  if (want == s->cur_events) return;
+  if (uevent_set_fd_events(s->uev, want) == UEV_ERR_OK) s->cur_events = want;
+}
+
+// дочитать fd до EAGAIN в хвост входной цепочки; -1 при ошибке чтения
+static int stream_do_read(uevent_stream_t *s) {
+  uev_chain_t *in = &s->input;
+  for (;;) {
+    if (s->read_high > 0 && in->len >= s->read_high) {
+      s->read_paused = true;
+      return 0;
+    }
+
+    // свободное место хвоста плюс новый сегмент: один readv забирает до двух сегментов
+    struct iovec iov[2];
+    int cnt = 0;
+    uev_seg_t *tail = in->tail;
+    if (tail != NULL && tail->end < tail->cap) {
+      iov[cnt].iov_base = tail->data + tail->end;
+      iov[cnt].iov_len = tail->cap - tail->end;
+      cnt++;
+    }
+    uev_seg_t *seg = chain_get_seg(in, UEV_STREAM_SEG_SIZE);
+    if (seg == NULL) {
+      errno = ENOMEM;
+      return -1;
+    }
+    iov[cnt].iov_base = seg->data;
+    iov[cnt].iov_len = seg->cap;
+    cnt++;
+
+    ssize_t n = readv(s->fd, iov, cnt);
+    if (n <= 0) {
+      chain_put_seg(in, seg);
+      if (n == 0) {
+        s->eof = true;
+        return 0;
+      }
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+      return -1;
+    }
+
+    size_t left = (size_t)n;
+    in->len += left;
+    if (cnt == 2) {
+      size_t k = tail->cap - tail->end;
+      if (k > left) k = left;
+      tail->end += k;
+      left -= k;
+    }
+    if (left > 0) {
+      seg->end = left;
+      chain_link(in, seg);
+    } else {
+      chain_put_seg(in, seg);
+    }
+  }
+}
+
+static ssize_t stream_writev(uevent_stream_t *s, struct iovec *iov, int cnt) {
+  if (!s->not_socket) {
+    // sendmsg с MSG_NOSIGNAL: закрытый собеседник дает EPIPE, а не SIGPIPE
+    struct msghdr msg = {.msg_iov = iov, .msg_iovlen = (size_t)cnt};
+    ssize_t n = sendmsg(s->fd, &msg, MSG_NOSIGNAL);
+    if (n >= 0 || errno != ENOTSOCK) return n;
+    s->not_socket = true;
+  }
+  return writev(s->fd, iov, cnt);
+}
+
+// записать выходную цепочку до EAGAIN; -1 при ошибке записи
+static int stream_do_write(uevent_stream_t *s) {
+  struct iovec iov[UEV_STREAM_MAX_IOV];
+  while (s->output.len > 0) {
+    int cnt = chain_iov(&s->output, iov, UEV_STREAM_MAX_IOV);
+    ssize_t n = stream_writev(s, iov, cnt);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+      return -1;
+    }
+    chain_drain(&s->output, (size_t)n);
+  }
+  return 0;
+}
+
+static void stream_destroy(uevent_stream_t *s) {
+  uevent_free(s->uev);
+  chain_free(&s->input);
+  chain_free(&s->output);
+  free(s);
+}
+
+static void stream_fail(uevent_stream_t *s) {
+  int err = errno;
+  s->failed = true;
+  chain_drain(&s->output, s->output.len);
+  if (s->event_cb != NULL) {
+    errno = err;
+    s->event_cb(s, UEV_ERROR, s->arg);
+  }
+}
+
+static void stream_ev_cb(uevent_t *ev, int fd, short events, void *arg) {
+  uevent_stream_t *s = arg;
+  s->in_cb++;
+
+  if ((events & UEV_WRITE) && s->output.len > 0 && !s->failed) {
+    size_t before = s->output.len;
+    if (stream_do_write(s) != 0) {
+      stream_fail(s);
+    } else if (before > s->write_low && s->output.len <= s->write_low && s->write_cb != NULL) {
+      s->write_cb(s, s->arg);
+    }
+  }
+
+  // HUP и ERROR приходят без READ, остаток данных и причину забираем чтением
+  if ((events & (UEV_READ | UEV_HUP | UEV_ERROR)) && s->reading && !s->eof && !s->failed && !s->free_pending) {
+    int ret, err;
+    for (;;) {
+      ret = stream_do_read(s);
+      err = errno;
+      bool paused = s->read_paused;
+      if (s->input.len > 0 && s->input.len >= s->read_low && s->read_cb != NULL) s->read_cb(s, s->arg);
+      // колбэк освободил место ниже read_high, а при EPOLLET нового фронта по оставшимся данным не будет
+      if (ret != 0 || !paused || s->read_paused || s->eof || s->failed || s->free_pending) break;
+    }
+    if (ret != 0 && !s->failed && !s->free_pending) {
+      errno = err;
+      stream_fail(s);
+    } else if (s->eof && !s->failed && !s->free_pending && s->event_cb != NULL) {
+      s->event_cb(s, UEV_HUP, s->arg);
+    }
+  }
+
+  s->in_cb--;
+  if (s->free_pending && s->in_cb == 0) {
+    stream_destroy(s);
+    return;
+  }
+  stream_update_interest(s);
+}
+
+uevent_stream_t *uevent_stream_new(uevent_base_t *base, int fd, uevent_stream_cb_t read_cb,
+                                   uevent_stream_cb_t write_cb, uevent_stream_event_cb_t event_cb,
+                                   void *arg, const char *name) {
+  if (base == NULL || fd < 0) return NULL;
+  uevent_stream_t *s = calloc(1, sizeof(uevent_stream_t));
+  if (s == NULL) return NULL;
+  s->fd = fd;
+  s->read_cb = read_cb;
+  s->write_cb = write_cb;
+  s->event_cb = event_cb;
+  s->arg = arg;
+  s->uev = uevent_create_or_assign_event(NULL, base, fd, UEV_READ | UEV_PERSIST, stream_ev_cb, s, name);
+  if (s->uev == NULL) {
+    free(s);
+    return NULL;
+  }
+  return s;
+}
+
+void uevent_stream_free(uevent_stream_t *stream) {
+  if (stream == NULL) return;
+  if (stream->in_cb > 0) {
+    stream->free_pending = true;
+    return;
+  }
+  stream_destroy(stream);
+}
+
+int uevent_stream_enable(uevent_stream_t *stream) {
+  if (stream == NULL) return UEV_ERR_INVAL;
+  stream->reading = true;
+  if (stream->in_cb > 0) return UEV_ERR_OK;
+  short want = stream->cur_events | UEV_READ;
+  int ret = uevent_set_fd_events(stream->uev, want);
+  if (ret == UEV_ERR_OK) stream->cur_events = want;
+  return ret;
+}
+
+void uevent_stream_set_watermarks(uevent_stream_t *stream, size_t read_low, size_t read_high,
+                                  size_t write_low, size_t write_high) {
+  if (stream == NULL) return;
+  stream->read_low = read_low;
+  stream->read_high = read_high;
+  stream->write_low = write_low;
+  stream->write_high = write_high;
+  if (stream->read_paused && (read_high == 0 || stream->input.len < read_high)) {
+    stream->read_paused = false;
+    if (stream->in_cb == 0) stream_update_interest(stream);
+  }
+}
+
+int uevent_stream_write(uevent_stream_t *stream, const void *data, size_t len) {
+  if (stream == NULL || (data == NULL && len > 0)) return UEV_ERR_INVAL;
+  if (stream->failed) return UEV_ERR_INVAL;
+  if (stream->write_high > 0 && stream->output.len >= stream->write_high) return UEV_ERR_BUSY;
+  if (len == 0) return UEV_ERR_OK;
+
+  bool was_empty = stream->output.len == 0;
+  if (chain_append(&stream->output, data, len) != 0) return UEV_ERR_ALLOC;
+  // пустой буфер пишем сразу, без лишнего пробуждения на готовность к записи
+  if (was_empty && stream_do_write(stream) != 0) {
+    stream->failed = true;
+    chain_drain(&stream->output, stream->output.len);
+    int err = errno;
+    if (stream->in_cb == 0) stream_update_interest(stream);
+    errno = err;
+    return UEV_ERR_INVAL;
+  }
+  if (stream->in_cb == 0) stream_update_interest(stream);
+  return UEV_ERR_OK;
+}
+
+int uevent_stream_peek(uevent_stream_t *stream, struct iovec *iov, int max_iov) {
+  if (stream == NULL || iov == NULL || max_iov <= 0) return 0;
+  return chain_iov(&stream->input, iov, max_iov);
+}
+
+size_t uevent_stream_consume(uevent_stream_t *stream, size_t len) {
+  if (stream == NULL) return 0;
+  size_t done = chain_drain(&stream->input, len);
+  if (stream->read_paused && stream->input.len < stream->read_high) {
+    stream->read_paused = false;
+    if (stream->in_cb == 0) stream_update_interest(stream);
+  }
+  return done;
+}
+
+size_t uevent_stream_read(uevent_stream_t *stream, void *buf, size_t len) {
+  if (stream == NULL || buf == NULL) return 0;
+  size_t done = 0;
+  for (uev_seg_t *seg = stream->input.head; seg != NULL && done < len; seg = seg->next) {
+    size_t n = seg->end - seg->off;
+    if (n > len - done) n = len - done;
+    memcpy((char *)buf + done, seg->data + seg->off, n);
+    done += n;
+  }
+  return uevent_stream_consume(stream, done);
+}
+
+size_t uevent_stream_input_len(const uevent_stream_t *stream) {
+  return stream != NULL ? stream->input.len : 0;
+}
+
+size_t uevent_stream_output_len(const uevent_stream_t *stream) {
+  return stream != NULL ? stream->output.len : 0;
+}
+
+int uevent_stream_fd(const uevent_stream_t *stream) {
+  return stream != NULL ? stream->fd : -1;
+}
@@ -0,0 +1,83 @@
+#ifndef LIBUEVENT_UEVENT_STREAM_H
+#define LIBUEVENT_UEVENT_STREAM_H
+
+#include "uevent.h"
+
+#include <stddef.h>
+#include <sys/uio.h>
+
+/**
+ * @brief Непрозрачный тип буферизованного потока поверх fd-события.
+ *
+ * Входные и выходные данные лежат в цепочках сегментов, чтение и запись идут
+ * readv/writev сразу по нескольким сегментам до EAGAIN. Интерес к UEV_WRITE
+ * включается, только пока в выходном буфере есть данные, UEV_READ снимается
+ * при достижении верхней отметки входного буфера. Детали скрыты в uevent_stream.c.
+ *
+ * Поток не потокобезопасен: функции вызываются из его колбэков или потоком,
+ * который владеет потоком и не пересекается с его колбэками.
+ */
+typedef struct uevent_stream_t uevent_stream_t;
+
+/* колбэк чтения/записи потока */
+typedef void (*uevent_stream_cb_t)(uevent_stream_t *stream, void *arg);
+
+/* колбэк состояния: what — UEV_HUP (конец данных) или UEV_ERROR (errno выставлен) */
+typedef void (*uevent_stream_event_cb_t)(uevent_stream_t *stream, short what, void *arg);
+
+/*
+ * Создаёт поток для неблокирующего fd. Чтение не запущено до uevent_stream_enable().
+ * fd не закрывается при освобождении потока. Возвращает NULL при ошибке.
+ */
+EXPORT_API uevent_stream_t *uevent_stream_new(uevent_base_t *base, int fd, uevent_stream_cb_t read_cb,
+                                              uevent_stream_cb_t write_cb, uevent_stream_event_cb_t event_cb,
+                                              void *arg, const char *name);
+
+/* Освобождает поток с буферами. Из колбэка самого потока освобождение откладывается до выхода из него. */
+EXPORT_API void uevent_stream_free(uevent_stream_t *stream);
+
+/* Запускает чтение. Возвращает UEV_ERR_OK или код ошибки. */
+EXPORT_API int uevent_stream_enable(uevent_stream_t *stream);
+
+/*
+ * Отметки буферов, 0 — без ограничения (по умолчанию все нули):
+ *   read_low   — read_cb вызывается, когда во входном буфере не меньше read_low байт;
+ *   read_high  — при read_high байт во входном буфере чтение из fd приостанавливается
+ *                до uevent_stream_consume();
+ *   write_low  — write_cb вызывается, когда выходной буфер опустел до write_low байт;
+ *   write_high — uevent_stream_write() отказывает с UEV_ERR_BUSY, пока в выходном
+ *                буфере write_high байт или больше.
+ */
+EXPORT_API void uevent_stream_set_watermarks(uevent_stream_t *stream, size_t read_low, size_t read_high,
+                                             size_t write_low, size_t write_high);
+
+/*
+ * Ставит данные в выходной буфер. Если буфер был пуст, сразу пробует writev,
+ * остаток уходит по готовности fd к записи. Возвращает UEV_ERR_OK, UEV_ERR_BUSY
+ * (выше write_high) или UEV_ERR_ALLOC.
+ */
+EXPORT_API int uevent_stream_write(uevent_stream_t *stream, const void *data, size_t len);
+
+/*
+ * Доступ к входному буферу без копирования: заполняет до max_iov указателей
+ * на сегменты по порядку. Возвращает число заполненных iovec. Данные остаются
+ * в буфере до uevent_stream_consume().
+ */
+EXPORT_API int uevent_stream_peek(uevent_stream_t *stream, struct iovec *iov, int max_iov);
+
+/* Отбрасывает len байт из начала входного буфера. Возвращает число отброшенных байт. */
+EXPORT_API size_t uevent_stream_consume(uevent_stream_t *stream, size_t len);
+
+/* Копирует до len байт из входного буфера в buf и отбрасывает их. Возвращает число байт. */
+EXPORT_API size_t uevent_stream_read(uevent_stream_t *stream, void *buf, size_t len);
+
+/* байт во входном буфере */
+EXPORT_API size_t uevent_stream_input_len(const uevent_stream_t *stream);
+
+/* байт в выходном буфере, еще не записанных в fd */
+EXPORT_API size_t uevent_stream_output_len(const uevent_stream_t *stream);
+
+/* fd потока */
+EXPORT_API int uevent_stream_fd(const uevent_stream_t *stream);
+
+#endif /* LIBUEVENT_UEVENT_STREAM_H */
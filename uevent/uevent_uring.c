@@ -0,0 +1,250 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "uevent_uring.h"
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// без liburing: три системных вызова и разметка колец из io_uring_params
+
+struct uev_uring {
+  int fd;
+
+  // очередь отправки, хвост двигаем мы, голову — ядро
+  void *sq_ring;
+  size_t sq_ring_sz;
+  _Atomic unsigned *sq_khead;
+  _Atomic unsigned *sq_ktail;
+  unsigned sq_mask;
+  unsigned sq_entries;
+  unsigned *sq_array;
+  struct io_uring_sqe *sqes;
+  size_t sqes_sz;
+  unsigned sq_tail; // локальный хвост, публикуется в sq_ktail
+  pthread_mutex_t sq_mut;
+
+  // очередь завершений, хвост двигает ядро, голову — поток цикла
+  void *cq_ring;
+  size_t cq_ring_sz;
+  _Atomic unsigned *cq_khead;
+  _Atomic unsigned *cq_ktail;
+  unsigned cq_mask;
+  struct io_uring_cqe *cqes;
+};
+
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params *p) {
+  return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags, void *arg, size_t argsz) {
+  return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+static void uring_unmap(uev_uring_t *ring) {
+  if (ring->sqes != NULL && ring->sqes != MAP_FAILED) munmap(ring->sqes, ring->sqes_sz);
+  if (ring->cq_ring != NULL && ring->cq_ring != MAP_FAILED && ring->cq_ring != ring->sq_ring) {
+    munmap(ring->cq_ring, ring->cq_ring_sz);
+  }
+  if (ring->sq_ring != NULL && ring->sq_ring != MAP_FAILED) munmap(ring->sq_ring, ring->sq_ring_sz);
+}
+
+uev_uring_t *uev_uring_create(unsigned int entries) {
+  struct io_uring_params p;
+  memset(&p, 0, sizeof(p));
+  // multishot poll шлет по CQE на каждое пробуждение, очередь завершений делаем с запасом
+  p.flags = IORING_SETUP_CQSIZE;
+  p.cq_entries = entries * 4;
+
+  int fd = sys_io_uring_setup(entries, &p);
+  if (fd < 0) return NULL;
+
+  // EXT_ARG (5.11) нужен для таймаута ожидания, RSRC_TAGS появился вместе с multishot poll (5.13)
+  uint32_t need = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG | IORING_FEAT_RSRC_TAGS;
+  if ((p.features & need) != need) {
+    close(fd);
+    errno = ENOSYS;
+    return NULL;
+  }
+
+  uev_uring_t *ring = calloc(1, sizeof(uev_uring_t));
+  if (ring == NULL) {
+    close(fd);
+    return NULL;
+  }
+  ring->fd = fd;
+
+  // при SINGLE_MMAP кольца отправки и завершений лежат в одном отображении
+  ring->sq_ring_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  ring->cq_ring_sz = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if (ring->cq_ring_sz > ring->sq_ring_sz) ring->sq_ring_sz = ring->cq_ring_sz;
+  ring->cq_ring_sz = ring->sq_ring_sz;
+
+  ring->sq_ring = mmap(NULL, ring->sq_ring_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (ring->sq_ring == MAP_FAILED) goto fail;
+  ring->cq_ring = ring->sq_ring;
+
+  ring->sqes_sz = p.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = mmap(NULL, ring->sqes_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (ring->sqes == MAP_FAILED) goto fail;
+
+  char *sq = ring->sq_ring;
+  ring->sq_khead = (_Atomic unsigned *)(sq + p.sq_off.head);
+  ring->sq_ktail = (_Atomic unsigned *)(sq + p.sq_off.tail);
+  ring->sq_mask = *(unsigned *)(sq + p.sq_off.ring_mask);
+  ring->sq_entries = *(unsigned *)(sq + p.sq_off.ring_entries);
+  ring->sq_array = (unsigned *)(sq + p.sq_off.array);
+  ring->sq_tail = atomic_load_explicit(ring->sq_ktail, memory_order_relaxed);
+
+  char *cq = ring->cq_ring;
+  ring->cq_khead = (_Atomic unsigned *)(cq + p.cq_off.head);
+  ring->cq_ktail = (_Atomic unsigned *)(cq + p.cq_off.tail);
+  ring->cq_mask = *(unsigned *)(cq + p.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+  if (pthread_mutex_init(&ring->sq_mut, NULL) != 0) goto fail;
+  return ring;
+
+fail:
+  uring_unmap(ring);
+  close(fd);
+  free(ring);
+  return NULL;
+}
+
+void uev_uring_free(uev_uring_t *ring) {
+  if (ring == NULL) return;
+  uring_unmap(ring);
+  close(ring->fd);
+  pthread_mutex_destroy(&ring->sq_mut);
+  free(ring);
+}
+
+// число SQE, опубликованных, но еще не забранных ядром; под sq_mut
+static unsigned uring_unsubmitted_locked(uev_uring_t *ring) {
+  return ring->sq_tail - atomic_load_explicit(ring->sq_khead, memory_order_acquire);
+}
+
+static int uring_flush_locked(uev_uring_t *ring) {
+  unsigned to_submit = uring_unsubmitted_locked(ring);
+  if (to_submit == 0) return 0;
+  int ret = sys_io_uring_enter(ring->fd, to_submit, 0, 0, NULL, 0);
+  return ret < 0 ? -1 : 0;
+}
+
+// взять свободный SQE, при заполненной очереди сначала сбросить ее в ядро; под sq_mut
+static struct io_uring_sqe *uring_get_sqe_locked(uev_uring_t *ring) {
+  if (uring_unsubmitted_locked(ring) >= ring->sq_entries) {
+    (void)uring_flush_locked(ring);
+    if (uring_unsubmitted_locked(ring) >= ring->sq_entries) return NULL;
+  }
+  unsigned idx = ring->sq_tail & ring->sq_mask;
+  struct io_uring_sqe *sqe = &ring->sqes[idx];
+  memset(sqe, 0, sizeof(*sqe));
+  ring->sq_array[idx] = idx;
+  return sqe;
+}
+
+// опубликовать заполненный SQE; под sq_mut
+static int uring_commit_locked(uev_uring_t *ring, bool flush) {
+  ring->sq_tail++;
+  atomic_store_explicit(ring->sq_ktail, ring->sq_tail, memory_order_release);
+  return flush ? uring_flush_locked(ring) : 0;
+}
+
+int uev_uring_poll_add(uev_uring_t *ring, int fd, uint32_t poll_mask, uint64_t user_data, bool flush) {
+  pthread_mutex_lock(&ring->sq_mut);
+  struct io_uring_sqe *sqe = uring_get_sqe_locked(ring);
+  if (sqe == NULL) {
+    pthread_mutex_unlock(&ring->sq_mut);
+    return -1;
+  }
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+  sqe->poll32_events = poll_mask;
+  sqe->len = IORING_POLL_ADD_MULTI;
+  sqe->user_data = user_data;
+  int ret = uring_commit_locked(ring, flush);
+  pthread_mutex_unlock(&ring->sq_mut);
+  return ret;
+}
+
+int uev_uring_poll_remove(uev_uring_t *ring, uint64_t user_data, bool flush) {
+  pthread_mutex_lock(&ring->sq_mut);
+  struct io_uring_sqe *sqe = uring_get_sqe_locked(ring);
+  if (sqe == NULL) {
+    pthread_mutex_unlock(&ring->sq_mut);
+    return -1;
+  }
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = user_data;
+  sqe->user_data = 0; // завершение снятия служебное, в результаты не попадает
+  int ret = uring_commit_locked(ring, flush);
+  pthread_mutex_unlock(&ring->sq_mut);
+  return ret;
+}
+
+// разложить готовые CQE в массив событий
+static int uring_reap(uev_uring_t *ring, struct epoll_event *events, int max_events) {
+  unsigned head = atomic_load_explicit(ring->cq_khead, memory_order_relaxed);
+  unsigned tail = atomic_load_explicit(ring->cq_ktail, memory_order_acquire);
+  int n = 0;
+
+  while (head != tail && n < max_events) {
+    const struct io_uring_cqe *cqe = &ring->cqes[head & ring->cq_mask];
+    head++;
+    // завершение снятия (user_data 0) и poll, отмененный этим снятием, пропускаем
+    if (cqe->user_data == 0 || cqe->res == -ECANCELED) continue;
+    if (cqe->res < 0) {
+      // poll живого события завершился ошибкой: сообщаем как EPOLLERR и ставим заново,
+      // кроме закрытого fd — там повторная постановка сразу вернет ту же ошибку
+      events[n].events = EPOLLERR;
+      if (cqe->res != -EBADF) events[n].events |= UEV_URING_F_REARM;
+    } else {
+      events[n].events = (uint32_t)cqe->res;
+      if (!(cqe->flags & IORING_CQE_F_MORE)) events[n].events |= UEV_URING_F_REARM;
+    }
+    events[n].data.u64 = cqe->user_data;
+    n++;
+  }
+  atomic_store_explicit(ring->cq_khead, head, memory_order_release);
+  return n;
+}
+
+int uev_uring_wait(uev_uring_t *ring, struct epoll_event *events, int max_events, const struct timespec *ts) {
+  pthread_mutex_lock(&ring->sq_mut);
+  unsigned to_submit = uring_unsubmitted_locked(ring);
+  pthread_mutex_unlock(&ring->sq_mut);
+
+  // завершения, оставшиеся с прошлого раза, забираем без ожидания
+  bool have_cqes = atomic_load_explicit(ring->cq_ktail, memory_order_acquire) !=
+                   atomic_load_explicit(ring->cq_khead, memory_order_relaxed);
+
+  struct __kernel_timespec kts;
+  struct io_uring_getevents_arg arg;
+  memset(&arg, 0, sizeof(arg));
+  arg.sigmask_sz = _NSIG / 8;
+  if (ts != NULL) {
+    kts.tv_sec = ts->tv_sec;
+    kts.tv_nsec = ts->tv_nsec;
+    arg.ts = (uint64_t)(uintptr_t)&kts;
+  }
+
+  if (to_submit > 0 || !have_cqes) {
+    int ret = sys_io_uring_enter(ring->fd, to_submit, have_cqes ? 0 : 1,
+                                 IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    if (ret < 0 && errno != ETIME && errno != EINTR && errno != EBUSY && errno != EAGAIN) return -1;
+    if (ret < 0 && errno == EINTR && !have_cqes) return -1;
+  }
+  return uring_reap(ring, events, max_events);
+}
@@ -0,0 +1,66 @@
+#ifndef LIBUEVENT_UEVENT_URING_H
+#define LIBUEVENT_UEVENT_URING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <time.h>
+
+/**
+ * @brief Флаг в events результата uev_uring_wait(): multishot poll завершился
+ * (нет IORING_CQE_F_MORE), и если событие еще активно, его нужно поставить заново.
+ */
+#define UEV_URING_F_REARM (1U << 30)
+
+/**
+ * @brief Непрозрачный тип для кольца io_uring базы событий.
+ *
+ * Детали реализации скрыты в uevent_uring.c. Подготовка SQE защищена
+ * мьютексом кольца, ожидание (uev_uring_wait) вызывает только поток цикла.
+ */
+typedef struct uev_uring uev_uring_t;
+
+/**
+ * @brief Создает кольцо io_uring.
+ *
+ * @param entries Размер очереди отправки (ядро округляет до степени двойки).
+ * @return Указатель на кольцо или NULL, если ядро не поддерживает io_uring
+ *         с multishot poll и ожиданием с таймаутом (нужно 5.13+).
+ */
+uev_uring_t *uev_uring_create(unsigned int entries);
+
+/** Освобождает кольцо и закрывает его fd. */
+void uev_uring_free(uev_uring_t *ring);
+
+/**
+ * @brief Ставит multishot poll на fd.
+ *
+ * @param poll_mask Маска EPOLLIN/EPOLLOUT/... (совпадает с POLL*).
+ * @param user_data Возвращается в data.u64 результата uev_uring_wait().
+ * @param flush true — отправить в ядро сразу, иначе SQE уйдет пачкой
+ *        при следующем uev_uring_wait().
+ * @return 0 при успехе, -1 если очередь отправки переполнена и не сбрасывается.
+ */
+int uev_uring_poll_add(uev_uring_t *ring, int fd, uint32_t poll_mask, uint64_t user_data, bool flush);
+
+/**
+ * @brief Снимает poll, поставленный с тем же user_data.
+ *
+ * @return 0 при успехе, -1 при переполнении очереди отправки.
+ */
+int uev_uring_poll_remove(uev_uring_t *ring, uint64_t user_data, bool flush);
+
+/**
+ * @brief Отправляет накопленные SQE и ждет готовности одним io_uring_enter.
+ *
+ * Результаты poll раскладываются в массив epoll_event: events — маска
+ * готовности (плюс UEV_URING_F_REARM), data.u64 — user_data.
+ * Ошибка poll приходит как EPOLLERR. Служебные завершения (снятие poll
+ * и отмененный им poll) пропускаются.
+ *
+ * @param ts Таймаут ожидания, NULL — ждать без ограничения.
+ * @return Количество событий, 0 по таймауту, -1 при ошибке (errno выставлен).
+ */
+int uev_uring_wait(uev_uring_t *ring, struct epoll_event *events, int max_events, const struct timespec *ts);
+
+#endif /* LIBUEVENT_UEVENT_URING_H */
@@ -0,0 +1,250 @@
+#include "uevent_wheel.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+
+// 6 уровней по 64 слота: диапазон 2^36 тиков (~795 суток при тике в 1 мс)
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1U << WHEEL_BITS)
+#define WHEEL_MASK ((uint64_t)WHEEL_SIZE - 1)
+#define WHEEL_LEVELS 6
+#define WHEEL_MAX_DELTA ((1ULL << (WHEEL_BITS * WHEEL_LEVELS)) - 1)
+
+struct uev_wheel {
+  uint64_t now;                                     // следующий необработанный тик
+  uint64_t bitmap[WHEEL_LEVELS];                    // битовые карты непустых слотов
+  struct list_head slots[WHEEL_LEVELS][WHEEL_SIZE]; // списки узлов по слотам
+  struct list_head expired;                         // истекшие узлы, ждущие извлечения
+  unsigned int size;                                // общее число узлов
+};
+
+static inline unsigned int level_shift(int lvl) {
+  return (unsigned int)lvl * WHEEL_BITS;
+}
+
+// поместить узел в слот по его expires относительно wheel->now
+static void wheel_link(uev_wheel_t *wheel, uev_wheel_node_t *node) {
+  uint64_t expires = node->expires;
+  if (expires < wheel->now) {
+    // тик уже обработан — узел сразу истекший
+    list_add_tail(&node->list, &wheel->expired);
+    return;
+  }
+
+  uint64_t delta = expires - wheel->now;
+  if (delta > WHEEL_MAX_DELTA) {
+    // за пределами диапазона: кладем в последний слот, при каскадировании узел
+    // будет перераспределен по реальному expires
+    delta = WHEEL_MAX_DELTA;
+    expires = wheel->now + delta;
+  }
+
+  int lvl = 0;
+  while (lvl < WHEEL_LEVELS - 1 && delta >= (1ULL << level_shift(lvl + 1))) {
+    lvl++;
+  }
+
+  unsigned int slot = (unsigned int)((expires >> level_shift(lvl)) & WHEEL_MASK);
+  list_add_tail(&node->list, &wheel->slots[lvl][slot]);
+  wheel->bitmap[lvl] |= 1ULL << slot;
+}
+
+// снять узел со списка и сбросить бит слота, если слот опустел
+static void wheel_unlink(uev_wheel_t *wheel, uev_wheel_node_t *node) {
+  struct list_head *next = node->list.next;
+  list_del(&node->list);
+  INIT_LIST_HEAD(&node->list);
+
+  // после удаления соседний элемент, ссылающийся сам на себя, — это голова пустого списка
+  if (next->next != next) return;
+
+  struct list_head *first = &wheel->slots[0][0];
+  if (next < first || next >= first + WHEEL_LEVELS * WHEEL_SIZE) return;
+
+  ptrdiff_t idx = next - first;
+  wheel->bitmap[idx / WHEEL_SIZE] &= ~(1ULL << (idx % WHEEL_SIZE));
+}
+
+// перераспределить слот уровня lvl по нижним уровням
+static void wheel_cascade(uev_wheel_t *wheel, int lvl, unsigned int slot) {
+  if ((wheel->bitmap[lvl] & (1ULL << slot)) == 0) return;
+
+  struct list_head tmp;
+  INIT_LIST_HEAD(&tmp);
+  list_splice_init(&wheel->slots[lvl][slot], &tmp);
+  wheel->bitmap[lvl] &= ~(1ULL << slot);
+
+  while (!list_empty(&tmp)) {
+    uev_wheel_node_t *node = list_first_entry(&tmp, uev_wheel_node_t, list);
+    list_del(&node->list);
+    wheel_link(wheel, node);
+  }
+}
+
+// ближайший тик >= from, в который будет каскадирован непустой слот верхних уровней
+static bool wheel_upper_bound(const uev_wheel_t *wheel, uint64_t from, uint64_t *tick) {
+  bool found = false;
+  uint64_t best = UINT64_MAX;
+
+  for (int lvl = 1; lvl < WHEEL_LEVELS; lvl++) {
+    uint64_t bits = wheel->bitmap[lvl];
+    if (bits == 0) continue;
+
+    unsigned int shift = level_shift(lvl);
+    uint64_t k0 = (from + (1ULL << shift) - 1) >> shift; // первый оборот уровня, начинающийся не раньше from
+    unsigned int cur = (unsigned int)(k0 & WHEEL_MASK);
+
+    // ближайший непустой слот начиная с cur с заворачиванием
+    uint64_t rotated = (bits >> cur) | (cur ? bits << (WHEEL_SIZE - cur) : 0);
+    unsigned int dist = (unsigned int)__builtin_ctzll(rotated);
+    uint64_t t = (k0 + dist) << shift;
+    if (t < best) {
+      best = t;
+      found = true;
+    }
+  }
+
+  if (found) *tick = best;
+  return found;
+}
+
+// продвинуть колесо до now включительно, истекшие слоты переносятся в wheel->expired
+static void wheel_advance(uev_wheel_t *wheel, uint64_t now) {
+  while (wheel->now <= now) {
+    unsigned int idx = (unsigned int)(wheel->now & WHEEL_MASK);
+    if (idx == 0) {
+      for (int lvl = 1; lvl < WHEEL_LEVELS; lvl++) {
+        unsigned int i = (unsigned int)((wheel->now >> level_shift(lvl)) & WHEEL_MASK);
+        wheel_cascade(wheel, lvl, i);
+        if (i != 0) break;
+      }
+    }
+
+    if (wheel->bitmap[0] == 0) {
+      // нижний уровень пуст: прыгаем сразу к ближайшему каскадированию
+      uint64_t next;
+      if (!wheel_upper_bound(wheel, wheel->now + 1, &next) || next > now) {
+        wheel->now = now + 1;
+        break;
+      }
+      wheel->now = next;
+      continue;
+    }
+
+    uint64_t bits = wheel->bitmap[0] & (~0ULL << idx);
+    if (bits != 0) {
+      unsigned int slot = (unsigned int)__builtin_ctzll(bits);
+      uint64_t tick = wheel->now + (slot - idx);
+      if (tick <= now) {
+        list_splice_init(&wheel->slots[0][slot], wheel->expired.prev);
+        wheel->bitmap[0] &= ~(1ULL << slot);
+        wheel->now = tick + 1;
+        continue;
+      }
+    }
+
+    // до конца текущего оборота нижнего уровня обрабатывать нечего
+    uint64_t period_end = wheel->now | WHEEL_MASK;
+    if (period_end >= now) {
+      wheel->now = now + 1;
+      break;
+    }
+    wheel->now = period_end + 1;
+  }
+}
+
+uev_wheel_t *uev_wheel_create(uint64_t now) {
+  uev_wheel_t *wheel = calloc(1, sizeof(uev_wheel_t));
+  if (wheel == NULL) return NULL;
+
+  for (int lvl = 0; lvl < WHEEL_LEVELS; lvl++) {
+    for (unsigned int i = 0; i < WHEEL_SIZE; i++) {
+      INIT_LIST_HEAD(&wheel->slots[lvl][i]);
+    }
+  }
+  INIT_LIST_HEAD(&wheel->expired);
+  wheel->now = now;
+  return wheel;
+}
+
+void uev_wheel_free(uev_wheel_t *wheel) {
+  free(wheel);
+}
+
+void uev_wheel_add(uev_wheel_t *wheel, uev_wheel_node_t *node) {
+  if (wheel == NULL || node == NULL) return;
+
+  if (uev_wheel_node_linked(node)) {
+    wheel_unlink(wheel, node);
+  } else {
+    wheel->size++;
+  }
+  wheel_link(wheel, node);
+}
+
+void uev_wheel_del(uev_wheel_t *wheel, uev_wheel_node_t *node) {
+  if (wheel == NULL || node == NULL || !uev_wheel_node_linked(node)) return;
+  wheel_unlink(wheel, node);
+  wheel->size--;
+}
+
+uev_wheel_node_t *uev_wheel_pop_expired(uev_wheel_t *wheel, uint64_t now) {
+  if (wheel == NULL) return NULL;
+
+  if (list_empty(&wheel->expired)) {
+    wheel_advance(wheel, now);
+    if (list_empty(&wheel->expired)) return NULL;
+  }
+
+  uev_wheel_node_t *node = list_first_entry(&wheel->expired, uev_wheel_node_t, list);
+  list_del(&node->list);
+  INIT_LIST_HEAD(&node->list);
+  wheel->size--;
+  return node;
+}
+
+uev_wheel_node_t *uev_wheel_pop_any(uev_wheel_t *wheel) {
+  if (wheel == NULL || wheel->size == 0) return NULL;
+
+  struct list_head *head = &wheel->expired;
+  for (int lvl = 0; lvl < WHEEL_LEVELS && list_empty(head); lvl++) {
+    if (wheel->bitmap[lvl] != 0) {
+      head = &wheel->slots[lvl][__builtin_ctzll(wheel->bitmap[lvl])];
+    }
+  }
+  if (list_empty(head)) return NULL;
+
+  uev_wheel_node_t *node = list_first_entry(head, uev_wheel_node_t, list);
+  wheel_unlink(wheel, node);
+  wheel->size--;
+  return node;
+}
+
+bool uev_wheel_next_expiry(uev_wheel_t *wheel, uint64_t *expires) {
+  if (wheel == NULL || wheel->size == 0) return false;
+
+  if (!list_empty(&wheel->expired)) {
+    *expires = list_first_entry(&wheel->expired, uev_wheel_node_t, list)->expires;
+    return true;
+  }
+
+  uint64_t best = UINT64_MAX;
+  bool found = wheel_upper_bound(wheel, wheel->now, &best);
+
+  uint64_t bits = wheel->bitmap[0];
+  if (bits != 0) {
+    // слоты ниже текущего индекса относятся к следующему обороту
+    unsigned int idx = (unsigned int)(wheel->now & WHEEL_MASK);
+    uint64_t rotated = (bits >> idx) | (idx ? bits << (WHEEL_SIZE - idx) : 0);
+    uint64_t tick = wheel->now + (uint64_t)__builtin_ctzll(rotated);
+    if (tick < best) best = tick;
+    found = true;
+  }
+
+  if (found) *expires = best;
+  return found;
+}
+
+unsigned int uev_wheel_size(uev_wheel_t *wheel) {
+  return wheel ? wheel->size : 0;
+}
@@ -0,0 +1,78 @@
+#ifndef LIBUEVENT_UEVENT_WHEEL_H
+#define LIBUEVENT_UEVENT_WHEEL_H
+
+#include "../list/list.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Узел иерархического колеса таймеров.
+ *
+ * Встраивается в uevent_t. Нулевой (неинициализированный) узел считается
+ * не добавленным в колесо.
+ */
+typedef struct uev_wheel_node {
+  struct list_head list; /* узел в списке слота колеса */
+  uint64_t expires;      /* время срабатывания в тиках колеса */
+} uev_wheel_node_t;
+
+/**
+ * @brief Непрозрачный тип для иерархического колеса таймеров.
+ *
+ * Детали реализации скрыты в uevent_wheel.c. Колесо не потокобезопасно,
+ * синхронизация лежит на вызывающей стороне (base_mut).
+ */
+typedef struct uev_wheel uev_wheel_t;
+
+/**
+ * @brief Создает колесо таймеров.
+ *
+ * @param now Текущее время в тиках, с него начинается отсчет.
+ * @return Указатель на колесо или NULL при ошибке выделения памяти.
+ */
+uev_wheel_t *uev_wheel_create(uint64_t now);
+
+/** Освобождает колесо (узлы не освобождаются). */
+void uev_wheel_free(uev_wheel_t *wheel);
+
+/**
+ * @brief Добавляет узел в колесо за O(1).
+ *
+ * Если узел уже в колесе — он перемещается в слот для нового node->expires.
+ */
+void uev_wheel_add(uev_wheel_t *wheel, uev_wheel_node_t *node);
+
+/** Удаляет узел из колеса за O(1), если он там есть. */
+void uev_wheel_del(uev_wheel_t *wheel, uev_wheel_node_t *node);
+
+/** true, если узел находится в колесе. */
+static inline bool uev_wheel_node_linked(const uev_wheel_node_t *node) {
+  return node->list.next != NULL && node->list.next != &node->list;
+}
+
+/**
+ * @brief Продвигает колесо до времени now и извлекает один истекший узел.
+ *
+ * @return Узел с expires <= now или NULL, если истекших узлов нет.
+ */
+uev_wheel_node_t *uev_wheel_pop_expired(uev_wheel_t *wheel, uint64_t now);
+
+/** Извлекает любой узел независимо от времени (для очистки), NULL если колесо пусто. */
+uev_wheel_node_t *uev_wheel_pop_any(uev_wheel_t *wheel);
+
+/**
+ * @brief Нижняя граница времени ближайшего срабатывания.
+ *
+ * Для узлов на верхних уровнях возвращается время каскадирования их слота,
+ * которое не позже реального срабатывания. Проснуться в это время безопасно:
+ * колесо перераспределит узлы и граница уточнится.
+ *
+ * @return false, если колесо пусто.
+ */
+bool uev_wheel_next_expiry(uev_wheel_t *wheel, uint64_t *expires);
+
+/** Количество узлов в колесе. */
+unsigned int uev_wheel_size(uev_wheel_t *wheel);
+
+#endif /* LIBUEVENT_UEVENT_WHEEL_H */
@@ -7,6 +7,7 @@
 #include "uevent.h" // uevent_t и uevent_cb_t
 
 #include "uevent_internal.h"
+#include "uevent_placement.h"
 #include "uevent_worker.h"
 
 #include <inttypes.h>
@@ -16,6 +17,8 @@
 
 #define UEV_EXTRA_WORKER_TASKS 100
 #define UEV_MAX_WORKER_MULTIPLIER 8
+#define UEV_WORKER_CACHELINE 64
+#define UEV_STEAL_MIN_BACKLOG 2 // воровать только из очереди, где задач больше, чем одна следующая
 
 static _Atomic bool enable_extra_workers = true;
 
@@ -26,11 +29,26 @@ void uevent_worker_pool_enable_extra_workers(bool enable) {
 // Внутренняя структура для задачи в очереди
 typedef struct {
   uev_t *uev;
-  uint64_t cron_time;
+  uint64_t cron_time; // мс по часам базы, 0 — не таймер
   short triggered_events;
   struct list_head node;
 } uevent_task_t;
 
+// собственная очередь воркера в режиме привязки
+typedef struct {
+  _Alignas(UEV_WORKER_CACHELINE) pthread_mutex_t mut;
+  pthread_cond_t cond;
+  struct list_head queue;
+  _Atomic int size; // читается ворами без мьютекса
+  _Atomic bool sleeping; // воркер ждет на cond, меняется под mut, читается без него
+} uevent_worker_queue_t;
+
+// аргумент потока основного воркера
+typedef struct {
+  struct uevent_worker_pool_t *pool;
+  unsigned int idx;
+} uevent_worker_arg_t;
+
 // основная структура пула воркеров
 typedef struct uevent_worker_pool_t {
   _Atomic bool running;
@@ -46,6 +64,19 @@ typedef struct uevent_worker_pool_t {
 
   pthread_mutex_t idle_mutex;
   pthread_cond_t idle_cond;
+
+  // режим привязки: задачи одного fd идут в очередь одного воркера, task_queue не используется
+  bool affinity;
+  uevent_worker_queue_t *queues;
+  uevent_worker_arg_t *args;
+  _Atomic int aff_queued;     // задач во всех очередях
+  _Atomic int aff_sleepers;   // воркеров, спящих на своей cond
+  _Atomic unsigned long stolen;
+
+  // размещение потоков: воркер i берет placement[i % placement_cnt]
+  uev_placement_t *placement;
+  unsigned int placement_cnt;
+  _Atomic unsigned int extra_seq; // номера дополнительных воркеров идут после основных
 } uevent_worker_pool_t;
 
 // forward declaration
@@ -92,16 +123,15 @@ static void process_worker_task(uevent_worker_pool_t *pool, uevent_task_t *task)
 
   uev_t *uev = task->uev;
   uevent_t *ev = ATOM_LOAD_ACQ(uev->ev);
-  if (ev == NULL || ev->cb == NULL || ATOM_LOAD_ACQ(ev->pending_free)) {
+  if (ev == NULL || ev->cb == NULL || uev_st_test(ev, UEV_ST_PENDING_FREE)) {
     uevent_put(uev);
     return;
   }
 
-  uint64_t cb_start_time = tu_clock_gettime_monotonic_ms();
-  int64_t queue_delay = (int64_t)cb_start_time - (int64_t)task->cron_time;
-
-  // логируем задержку в очереди
-  if (task->cron_time) {
+  // логируем задержку в очереди, часы читаются только для таймеров; cron_time — мс по часам базы
+  uevent_base_t *base = ATOM_LOAD_ACQ(ev->base);
+  if (task->cron_time && base != NULL) {
+    int64_t queue_delay = uev_base_timer_lag_ms(base, task->cron_time);
     int refcount = ATOM_LOAD_ACQ(uev->refcount);
     if (syslog2_get_pri() & LOG_MASK(LOG_DEBUG)) {
       syslog2(LOG_DEBUG, "[WORKER_DBG] name='%s' task_start_delay=%" PRId64 " refcount=%d", ev->name, queue_delay, refcount);
@@ -115,12 +145,16 @@ static void process_worker_task(uevent_worker_pool_t *pool, uevent_task_t *task)
   uevent_put(uev);
 }
 
+static bool affinity_finish_task(uevent_worker_pool_t *pool, uevent_task_t *task);
+
 // освобождение задачи и обновление счетчиков
 static void finalize_worker_task(uevent_worker_pool_t *pool, uevent_task_t *task) {
-  if (task) {
+  if (task && pool->affinity && affinity_finish_task(pool, task)) {
+    task = NULL; // задача снова в очереди с накопленными срабатываниями
+  } else if (task) {
     if (task->uev->ev) {
       uevent_t *ev = task->uev->ev;
-      atomic_store_explicit(&ev->is_in_worker_pool, false, memory_order_release);
+      uev_st_clear(ev, UEV_ST_IN_WORKER);
       uevent_put(task->uev);
     }
     free(task);
@@ -134,11 +168,19 @@ static void finalize_worker_task(uevent_worker_pool_t *pool, uevent_task_t *task
   }
 }
 
+// CPU, политика планировщика и nice воркера idx, вызывается в его потоке
+static void worker_apply_placement(uevent_worker_pool_t *pool, unsigned int idx) {
+  if (pool->placement_cnt == 0) return;
+  uev_placement_apply(&pool->placement[idx % pool->placement_cnt], "worker", (int)idx);
+}
+
 // основная функция воркера
 static void *uevent_worker_thread(void *arg) {
   FUNC_START_DEBUG;
   PTHREAD_SET_NAME(__func__);
-  uevent_worker_pool_t *pool = (uevent_worker_pool_t *)arg;
+  uevent_worker_arg_t *wa = arg;
+  uevent_worker_pool_t *pool = wa->pool;
+  worker_apply_placement(pool, wa->idx);
   while (atomic_load_explicit(&pool->running, memory_order_acquire)) {
 
     uevent_task_t *task = wait_and_pop_task(pool); // ждем и извлекаем задачу
@@ -155,6 +197,7 @@ static void *uevent_worker_thread(void *arg) {
 static void *uevent_extra_worker_thread(void *arg) {
   uevent_worker_pool_t *pool = (uevent_worker_pool_t *)arg;
   int tasks_left = UEV_EXTRA_WORKER_TASKS;
+  worker_apply_placement(pool, pool->num_workers + atomic_fetch_add_explicit(&pool->extra_seq, 1, memory_order_relaxed));
   while (atomic_load_explicit(&pool->running, memory_order_acquire) && tasks_left-- > 0) {
     uevent_task_t *task = wait_and_pop_task(pool);
     if (!task) break; // если задачи кончились, просто завершаемся
@@ -168,7 +211,8 @@ static void *uevent_extra_worker_thread(void *arg) {
 
 static void try_spawn_extra_worker(uevent_worker_pool_t *pool) {
   FUNC_START_DEBUG;
-  if (!atomic_load(&enable_extra_workers)) {
+  // в режиме привязки разгрузкой занимаются воры из числа основных воркеров
+  if (!atomic_load(&enable_extra_workers) || pool->affinity) {
     return;
   }
   int max_workers = pool->num_workers * UEV_MAX_WORKER_MULTIPLIER;
@@ -206,17 +250,223 @@ static void try_spawn_extra_worker(uevent_worker_pool_t *pool) {
   }
 }
 
-/**
- * @brief Создает и запускает пул рабочих потоков.
- */
-uevent_worker_pool_t *uevent_worker_pool_create(int num_workers) {
+// --- режим привязки: очередь на воркера, маршрут по fd, воровство при перекосе ---
+
+// воркер задач события: fd-события по fd, таймеры по слоту
+static unsigned int affinity_route(const uevent_worker_pool_t *pool, uev_t *uev, const uevent_t *ev) {
+  uint32_t key = ev->fd >= 0 ? (uint32_t)ev->fd : uev->slot_idx;
+  return (key * 2654435761U) % pool->num_workers;
+}
+
+// будит одного спящего воркера, чтобы он забрал лишнее из перегруженной очереди.
+// Мьютекс берется только у воркера, который по флагу спит: чужие очереди не трогаются
+static void affinity_wake_thief(uevent_worker_pool_t *pool, unsigned int busy) {
+  if (atomic_load_explicit(&pool->aff_sleepers, memory_order_acquire) == 0) return;
+  for (unsigned int i = 1; i < pool->num_workers; i++) {
+    uevent_worker_queue_t *q = &pool->queues[(busy + i) % pool->num_workers];
+    if (!atomic_load_explicit(&q->sleeping, memory_order_relaxed)) continue;
+    pthread_mutex_lock(&q->mut);
+    bool sleeping = atomic_load_explicit(&q->sleeping, memory_order_relaxed);
+    if (sleeping) pthread_cond_signal(&q->cond);
+    pthread_mutex_unlock(&q->mut);
+    if (sleeping) return;
+  }
+}
+
+static void affinity_push(uevent_worker_pool_t *pool, unsigned int idx, uevent_task_t *task) {
+  uevent_worker_queue_t *q = &pool->queues[idx];
+  pthread_mutex_lock(&q->mut);
+  list_add_tail(&task->node, &q->queue);
+  int size = atomic_fetch_add_explicit(&q->size, 1, memory_order_relaxed) + 1;
+  atomic_fetch_add_explicit(&pool->aff_queued, 1, memory_order_acq_rel);
+  pthread_cond_signal(&q->cond);
+  pthread_mutex_unlock(&q->mut);
+  if (size >= UEV_STEAL_MIN_BACKLOG && pool->num_workers > 1) affinity_wake_thief(pool, idx);
+}
+
+// Ставит срабатывание события. Пока событие в пуле, новые срабатывания не теряются, а копятся
+// в ev->worker_pending и выполняются одним вызовом после текущего: задача события всегда одна,
+// поэтому колбэки одного fd не идут параллельно и не переставляются, у кого бы их ни украли.
+static bool affinity_submit(uevent_worker_pool_t *pool, uev_t *uev, uevent_t *ev, short events, uint64_t cron_time) {
+  for (;;) {
+    if (!uev_st_set(ev, UEV_ST_IN_WORKER)) break;
+    atomic_fetch_or(&ev->worker_pending, events);
+    // владелец проверяет накопленное после снятия бита: если бит уже снят, забираем сами
+    if (uev_st_test(ev, UEV_ST_IN_WORKER)) return false;
+    events = atomic_exchange(&ev->worker_pending, 0);
+    if (events == 0) return false;
+    cron_time = 0;
+  }
+  events |= atomic_exchange(&ev->worker_pending, 0);
+
+  uevent_task_t *task = malloc(sizeof(uevent_task_t));
+  if (task == NULL) {
+    syslog2(LOG_ERR, "Failed to allocate memory for uevent task");
+    uev_st_clear(ev, UEV_ST_IN_WORKER);
+    return false;
+  }
+  uevent_ref(uev);
+  task->uev = uev;
+  task->cron_time = cron_time;
+  task->triggered_events = events;
+  affinity_push(pool, affinity_route(pool, uev, ev), task);
+  return true;
+}
+
+// после колбэка: накопленные срабатывания уходят той же задачей в очередь события
+static bool affinity_finish_task(uevent_worker_pool_t *pool, uevent_task_t *task) {
+  uev_t *uev = task->uev;
+  uevent_t *ev = ATOM_LOAD_ACQ(uev->ev);
+  if (ev == NULL) return false;
+  short pending = atomic_exchange(&ev->worker_pending, 0);
+  if (pending != 0 && !uev_st_test(ev, UEV_ST_PENDING_FREE)) {
+    task->triggered_events = pending;
+    task->cron_time = 0;
+    affinity_push(pool, affinity_route(pool, uev, ev), task);
+    return true;
+  }
+  uev_st_clear(ev, UEV_ST_IN_WORKER);
+  // срабатывание между обменом и снятием бита видело бит и оставило маску нам;
+  // ссылка задачи еще держит событие
+  pending = atomic_exchange(&ev->worker_pending, 0);
+  if (pending != 0 && !uev_st_test(ev, UEV_ST_PENDING_FREE)) (void)affinity_submit(pool, uev, ev, pending, 0);
+  uevent_put(uev);
+  free(task);
+  return true;
+}
+
+// забрать задачу из хвоста самой длинной чужой очереди
+static uevent_task_t *affinity_steal(uevent_worker_pool_t *pool, unsigned int self) {
+  uevent_worker_queue_t *victim = NULL;
+  int best = UEV_STEAL_MIN_BACKLOG - 1;
+  for (unsigned int i = 1; i < pool->num_workers; i++) {
+    uevent_worker_queue_t *q = &pool->queues[(self + i) % pool->num_workers];
+    int size = atomic_load_explicit(&q->size, memory_order_relaxed);
+    if (size > best) {
+      best = size;
+      victim = q;
+    }
+  }
+  if (victim == NULL) return NULL;
+  uevent_task_t *task = NULL;
+  pthread_mutex_lock(&victim->mut);
+  if (atomic_load_explicit(&victim->size, memory_order_relaxed) >= UEV_STEAL_MIN_BACKLOG) {
+    task = list_last_entry(&victim->queue, uevent_task_t, node);
+    list_del(&task->node);
+    atomic_fetch_sub_explicit(&victim->size, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&pool->active_tasks, 1, memory_order_acq_rel);
+    atomic_fetch_sub_explicit(&pool->aff_queued, 1, memory_order_acq_rel);
+    atomic_fetch_add_explicit(&pool->stolen, 1, memory_order_relaxed);
+  }
+  pthread_mutex_unlock(&victim->mut);
+  return task;
+}
+
+// своя очередь, затем воровство, затем сон до новой задачи или просьбы о помощи
+static uevent_task_t *affinity_pop(uevent_worker_pool_t *pool, unsigned int idx) {
+  uevent_worker_queue_t *q = &pool->queues[idx];
+  for (;;) {
+    pthread_mutex_lock(&q->mut);
+    if (atomic_load_explicit(&q->size, memory_order_relaxed) > 0) {
+      uevent_task_t *task = list_first_entry(&q->queue, uevent_task_t, node);
+      list_del(&task->node);
+      atomic_fetch_sub_explicit(&q->size, 1, memory_order_relaxed);
+      // сначала активные, потом очередь: is_idle не увидит паузы между ними
+      atomic_fetch_add_explicit(&pool->active_tasks, 1, memory_order_acq_rel);
+      atomic_fetch_sub_explicit(&pool->aff_queued, 1, memory_order_acq_rel);
+      pthread_mutex_unlock(&q->mut);
+      return task;
+    }
+    pthread_mutex_unlock(&q->mut);
+    if (!atomic_load_explicit(&pool->running, memory_order_acquire)) return NULL;
+
+    uevent_task_t *task = affinity_steal(pool, idx);
+    if (task != NULL) return task;
+
+    pthread_mutex_lock(&q->mut);
+    if (atomic_load_explicit(&q->size, memory_order_relaxed) == 0 &&
+        atomic_load_explicit(&pool->running, memory_order_acquire)) {
+      atomic_store_explicit(&q->sleeping, true, memory_order_relaxed);
+      atomic_fetch_add_explicit(&pool->aff_sleepers, 1, memory_order_acq_rel);
+      pthread_cond_wait(&q->cond, &q->mut);
+      atomic_fetch_sub_explicit(&pool->aff_sleepers, 1, memory_order_acq_rel);
+      atomic_store_explicit(&q->sleeping, false, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&q->mut);
+  }
+}
+
+static void *uevent_affinity_worker_thread(void *arg) {
+  FUNC_START_DEBUG;
+  PTHREAD_SET_NAME(__func__);
+  uevent_worker_arg_t *wa = arg;
+  uevent_worker_pool_t *pool = wa->pool;
+  worker_apply_placement(pool, wa->idx);
+  while (atomic_load_explicit(&pool->running, memory_order_acquire)) {
+    uevent_task_t *task = affinity_pop(pool, wa->idx);
+    if (task == NULL) continue;
+    process_worker_task(pool, task);
+    finalize_worker_task(pool, task);
+  }
+  atomic_fetch_sub_explicit(&pool->total_workers, 1, memory_order_acq_rel);
+  return NULL;
+}
+
+// снять задачи со всех очередей привязки, вызывается при остановке пула
+static void affinity_drain(uevent_worker_pool_t *pool) {
+  for (unsigned int i = 0; pool->queues != NULL && i < pool->num_workers; i++) {
+    uevent_worker_queue_t *q = &pool->queues[i];
+    pthread_mutex_lock(&q->mut);
+    uevent_task_t *task, *tmp;
+    list_for_each_entry_safe(task, tmp, &q->queue, node) {
+      list_del(&task->node);
+      atomic_fetch_sub_explicit(&q->size, 1, memory_order_relaxed);
+      atomic_fetch_sub_explicit(&pool->aff_queued, 1, memory_order_acq_rel);
+      uevent_t *ev = ATOM_LOAD_ACQ(task->uev->ev);
+      if (ev) {
+        atomic_store(&ev->worker_pending, 0);
+        uev_st_clear(ev, UEV_ST_IN_WORKER);
+        uevent_put(task->uev);
+      }
+      free(task);
+    }
+    pthread_mutex_unlock(&q->mut);
+  }
+}
+
+bool uevent_worker_pool_is_affinity(const uevent_worker_pool_t *pool) {
+  return pool != NULL && pool->affinity;
+}
+
+unsigned long uevent_worker_pool_stolen(uevent_worker_pool_t *pool) {
+  return pool ? atomic_load_explicit(&pool->stolen, memory_order_relaxed) : 0;
+}
+
+uevent_worker_pool_t *uevent_worker_pool_create_placed(int num_workers, bool affinity,
+                                                       const uevent_thread_placement_t *placement, int placement_cnt) {
   uevent_worker_pool_t *pool = NULL;
+  uev_placement_t *place = NULL;
   unsigned int i;
 
-  if (num_workers <= 0) return NULL;
+  if (num_workers <= 0 || placement_cnt < 0 || (placement_cnt > 0 && placement == NULL)) return NULL;
+  if (placement_cnt > 0) {
+    place = calloc(placement_cnt, sizeof(uev_placement_t));
+    if (place == NULL) return NULL;
+    for (int k = 0; k < placement_cnt; k++) {
+      if (uev_placement_init(&place[k], &placement[k]) != 0) {
+        free(place);
+        return NULL;
+      }
+    }
+  }
 
   pool = calloc(1, sizeof(uevent_worker_pool_t));
-  if (pool == NULL) return NULL;
+  if (pool == NULL) {
+    free(place);
+    return NULL;
+  }
+  pool->placement = place;
+  pool->placement_cnt = (unsigned int)placement_cnt;
 
   pool->num_workers = num_workers;
   atomic_store_explicit(&pool->running, true, memory_order_release);
@@ -229,10 +479,39 @@ uevent_worker_pool_t *uevent_worker_pool_create(int num_workers) {
   if (pthread_cond_init(&pool->idle_cond, NULL) != 0) goto fail_idle_mutex;
 
   pool->workers = calloc(num_workers, sizeof(pthread_t));
-  if (pool->workers == NULL) goto fail_idle_cond;
+  pool->args = calloc(num_workers, sizeof(uevent_worker_arg_t));
+  if (pool->workers == NULL || pool->args == NULL) {
+    free(pool->workers);
+    free(pool->args);
+    goto fail_idle_cond;
+  }
+  for (i = 0; i < pool->num_workers; i++) {
+    pool->args[i].pool = pool;
+    pool->args[i].idx = i;
+  }
+
+  if (affinity) {
+    pool->queues = aligned_alloc(UEV_WORKER_CACHELINE, num_workers * sizeof(uevent_worker_queue_t));
+    if (pool->queues == NULL) {
+      free(pool->args);
+      free(pool->workers);
+      goto fail_idle_cond;
+    }
+    for (i = 0; i < pool->num_workers; i++) {
+      uevent_worker_queue_t *q = &pool->queues[i];
+      pthread_mutex_init(&q->mut, NULL);
+      pthread_cond_init(&q->cond, NULL);
+      INIT_LIST_HEAD(&q->queue);
+      atomic_init(&q->size, 0);
+      atomic_init(&q->sleeping, false);
+    }
+    pool->affinity = true;
+  }
 
   for (i = 0; i < pool->num_workers; i++) {
-    if (pthread_create(&pool->workers[i], NULL, uevent_worker_thread, pool) == 0) {
+    int ret = pthread_create(&pool->workers[i], NULL, affinity ? uevent_affinity_worker_thread : uevent_worker_thread,
+                             &pool->args[i]);
+    if (ret == 0) {
       atomic_fetch_add_explicit(&pool->total_workers, 1, memory_order_acq_rel);
     } else {
       pool->num_workers = i;
@@ -252,10 +531,22 @@ fail_task_cond:
 fail_task_mutex:
   pthread_mutex_destroy(&pool->task_mutex);
 fail:
+  free(pool->placement);
   free(pool);
   return NULL;
 }
 
+/**
+ * @brief Создает и запускает пул рабочих потоков.
+ */
+uevent_worker_pool_t *uevent_worker_pool_create(int num_workers) {
+  return uevent_worker_pool_create_placed(num_workers, false, NULL, 0);
+}
+
+uevent_worker_pool_t *uevent_worker_pool_create_affinity(int num_workers) {
+  return uevent_worker_pool_create_placed(num_workers, true, NULL, 0);
+}
+
 /**
  * @brief Добавляет задачу (вызов колбека) в очередь пула воркеров
  */
@@ -266,7 +557,11 @@ void uevent_worker_pool_insert(uevent_worker_pool_t *pool, uev_t *uev, short tri
   }
   uevent_t *ev = ATOM_LOAD_ACQ(uev->ev);
 
-  if (!ev || atomic_load_explicit(&uev->ev->is_in_worker_pool, memory_order_acquire)) return;
+  if (ev && pool->affinity) {
+    (void)affinity_submit(pool, uev, ev, triggered_events, cron_time);
+    return;
+  }
+  if (!ev || uev_st_test(ev, UEV_ST_IN_WORKER)) return;
 
   TINIT;
   TMARK(10, "START");
@@ -279,7 +574,7 @@ void uevent_worker_pool_insert(uevent_worker_pool_t *pool, uev_t *uev, short tri
   // увеличить счетчик ссылок перед добавлением в очередь
   uevent_ref(uev);
   // поднять флаг, что event в пуле
-  ATOM_STORE_REL(ev->is_in_worker_pool, true);
+  uev_st_set(ev, UEV_ST_IN_WORKER);
   task->uev = uev;
   task->cron_time = cron_time;
   task->triggered_events = triggered_events;
@@ -295,10 +590,74 @@ void uevent_worker_pool_insert(uevent_worker_pool_t *pool, uev_t *uev, short tri
   TMARK(10, "END");
 }
 
+/**
+ * @brief Добавляет пачку задач в очередь пула воркеров за один захват task_mutex
+ */
+int uevent_worker_pool_insert_batch(uevent_worker_pool_t *pool, const uevent_worker_batch_item_t *items, int count) {
+  FUNC_START_DEBUG;
+  if (pool == NULL || items == NULL || count <= 0) {
+    return 0;
+  }
+
+  if (pool->affinity) {
+    int queued = 0;
+    for (int i = 0; i < count; i++) {
+      uev_t *uev = items[i].uev;
+      uevent_t *ev = uev ? ATOM_LOAD_ACQ(uev->ev) : NULL;
+      if (!ev || ev->cb == NULL || uev_st_test(ev, UEV_ST_PENDING_FREE)) continue;
+      queued += affinity_submit(pool, uev, ev, items[i].triggered_events, items[i].cron_time);
+    }
+    return queued;
+  }
+
+  // задачи готовим без блокировки, под мьютексом только переносим список
+  struct list_head batch;
+  INIT_LIST_HEAD(&batch);
+  int queued = 0;
+  for (int i = 0; i < count; i++) {
+    uev_t *uev = items[i].uev;
+    uevent_t *ev = uev ? ATOM_LOAD_ACQ(uev->ev) : NULL;
+    if (!ev || ev->cb == NULL || uev_st_test(ev, UEV_ST_PENDING_FREE)) continue;
+    if (uev_st_set(ev, UEV_ST_IN_WORKER)) continue;
+
+    uevent_task_t *task = malloc(sizeof(uevent_task_t));
+    if (task == NULL) {
+      syslog2(LOG_ERR, "Failed to allocate memory for uevent task");
+      uev_st_clear(ev, UEV_ST_IN_WORKER);
+      continue;
+    }
+
+    uevent_ref(uev);
+    task->uev = uev;
+    task->cron_time = items[i].cron_time;
+    task->triggered_events = items[i].triggered_events;
+    list_add_tail(&task->node, &batch);
+    queued++;
+  }
+  if (queued == 0) return 0;
+
+  pthread_mutex_lock(&pool->task_mutex);
+  list_splice(&batch, pool->task_queue.prev); // в хвост очереди
+  pool->queue_size += queued;
+  if (queued == 1) {
+    pthread_cond_signal(&pool->task_cond);
+  } else {
+    pthread_cond_broadcast(&pool->task_cond);
+  }
+  pthread_mutex_unlock(&pool->task_mutex);
+
+  return queued;
+}
+
 static void trigger_workers_internal(uevent_worker_pool_t *pool) {
   pthread_mutex_lock(&pool->task_mutex);
   pthread_cond_broadcast(&pool->task_cond);
   pthread_mutex_unlock(&pool->task_mutex);
+  for (unsigned int i = 0; pool->affinity && i < pool->num_workers; i++) {
+    pthread_mutex_lock(&pool->queues[i].mut);
+    pthread_cond_broadcast(&pool->queues[i].cond);
+    pthread_mutex_unlock(&pool->queues[i].mut);
+  }
   pthread_mutex_lock(&pool->idle_mutex);
   pthread_cond_broadcast(&pool->idle_cond);
   pthread_mutex_unlock(&pool->idle_mutex);
@@ -343,6 +702,14 @@ void uevent_worker_pool_destroy(uevent_worker_pool_t *pool) {
 
   // Освобождаем оставшиеся ресурсы
   free(pool->workers);
+  affinity_drain(pool);
+  for (unsigned int i = 0; pool->affinity && i < pool->num_workers; i++) {
+    pthread_mutex_destroy(&pool->queues[i].mut);
+    pthread_cond_destroy(&pool->queues[i].cond);
+  }
+  free(pool->queues);
+  free(pool->args);
+  free(pool->placement);
 
   pthread_mutex_destroy(&pool->task_mutex);
   pthread_cond_destroy(&pool->task_cond);
@@ -359,7 +726,7 @@ void uevent_worker_pool_destroy(uevent_worker_pool_t *pool) {
     // уменьшаем счетчик ссылок
     if (task->uev->ev) {
       uevent_t *ev = task->uev->ev;
-      atomic_store_explicit(&ev->is_in_worker_pool, false, memory_order_release);
+      uev_st_clear(ev, UEV_ST_IN_WORKER);
       uevent_put(task->uev);
     }
     free(task);
@@ -380,6 +747,7 @@ bool uevent_worker_pool_is_idle(uevent_worker_pool_t *pool) {
   pthread_mutex_lock(&pool->task_mutex);
   queue_empty = pool->queue_size < 1;
   pthread_mutex_unlock(&pool->task_mutex);
+  if (pool->affinity) queue_empty = atomic_load_explicit(&pool->aff_queued, memory_order_acquire) == 0;
 
   int active = atomic_load_explicit(&pool->active_tasks, memory_order_acquire);
   syslog2(LOG_DEBUG, "worker pool active_tasks=%d", active);
@@ -425,13 +793,14 @@ void uevent_worker_pool_stop(uevent_worker_pool_t *pool) {
     pool->queue_size--;
     uevent_t *ev = ATOM_LOAD_ACQ(task->uev->ev);
     if (ev) {
-      atomic_store_explicit(&ev->is_in_worker_pool, false, memory_order_release);
+      uev_st_clear(ev, UEV_ST_IN_WORKER);
       uevent_put(task->uev);
     }
     free(task);
   }
 
   pthread_mutex_unlock(&pool->task_mutex);
+  affinity_drain(pool);
 
   // 4. Будим ожидающие потоки (например, в wait_for_idle)
   pthread_mutex_lock(&pool->idle_mutex);
@@ -7,6 +7,7 @@
 // Forward-declaration для uevent_t, чтобы избежать циклической зависимости,
 // так как uevent.h будет включать этот файл.
 typedef struct uevent_t uevent_t;
+typedef struct uevent_thread_placement_t uevent_thread_placement_t;
 
 /**
  * @brief Непрозрачный тип для пула рабочих потоков.
@@ -26,6 +27,40 @@ void uevent_worker_pool_enable_extra_workers(bool enable);
  */
 uevent_worker_pool_t *uevent_worker_pool_create(int num_workers);
 
+/**
+ * @brief Создает пул в режиме привязки: у каждого воркера своя очередь.
+ *
+ * Задачи fd-события всегда идут в очередь одного воркера (по хешу fd, таймеры — по
+ * слоту события), состояние соединения остается в кеше одного CPU. Срабатывания,
+ * пришедшие пока событие в пуле, не отбрасываются, а сливаются в следующий вызов
+ * колбэка. Воркер без задач забирает задачу из хвоста чужой очереди, где их не меньше двух.
+ *
+ * @param num_workers Количество потоков.
+ * @return Указатель на созданный пул или NULL в случае ошибки.
+ */
+uevent_worker_pool_t *uevent_worker_pool_create_affinity(int num_workers);
+
+/**
+ * @brief Создает пул с размещением потоков по CPU и настройками планировщика.
+ *
+ * Воркер i при старте применяет к себе placement[i % placement_cnt]. Дополнительные
+ * воркеры, создаваемые под нагрузкой, нумеруются после основных.
+ *
+ * @param num_workers Количество потоков.
+ * @param affinity Режим привязки, как у uevent_worker_pool_create_affinity().
+ * @param placement Массив размещений, копируется в пул.
+ * @param placement_cnt Число элементов placement, 0 — потоки не трогаются.
+ * @return Указатель на созданный пул или NULL при ошибке и недопустимых параметрах размещения.
+ */
+uevent_worker_pool_t *uevent_worker_pool_create_placed(int num_workers, bool affinity,
+                                                       const uevent_thread_placement_t *placement, int placement_cnt);
+
+/** true, если пул создан в режиме привязки. */
+bool uevent_worker_pool_is_affinity(const uevent_worker_pool_t *pool);
+
+/** Сколько задач забрали из чужих очередей воркеры пула в режиме привязки. */
+unsigned long uevent_worker_pool_stolen(uevent_worker_pool_t *pool);
+
 /**
  * @brief Помещает задачу (вызов колбэка) в очередь на выполнение.
  *
@@ -38,6 +73,28 @@ uevent_worker_pool_t *uevent_worker_pool_create(int num_workers);
  */
 void uevent_worker_pool_insert(uevent_worker_pool_t *pool, uev_t *uev, short triggered_events, uint64_t cron_time);
 
+/**
+ * @brief Элемент пачки задач для uevent_worker_pool_insert_batch().
+ */
+typedef struct {
+  uev_t *uev;             /* событие, колбэк которого нужно вызвать */
+  uint64_t cron_time;     /* время срабатывания в мс */
+  short triggered_events; /* флаги сработавших событий */
+} uevent_worker_batch_item_t;
+
+/**
+ * @brief Помещает пачку задач в очередь за один захват мьютекса очереди.
+ *
+ * События без колбэка, помеченные на освобождение или уже стоящие в пуле,
+ * пропускаются.
+ *
+ * @param pool Указатель на пул рабочих потоков.
+ * @param items Массив задач.
+ * @param count Количество задач в массиве.
+ * @return Количество поставленных в очередь задач.
+ */
+int uevent_worker_pool_insert_batch(uevent_worker_pool_t *pool, const uevent_worker_batch_item_t *items, int count);
+
 /**
  * @brief Корректно останавливает и уничтожает пул рабочих потоков.
  *